@@ -53,6 +53,18 @@ def config_cache(options, system):
     if options.external_memory_system:
         ExternalCache = ExternalCacheFactory(options.external_memory_system)
 
+    if options.spm_cache_ways >= 0 and not options.hybrid_mem:
+        print "Carving the spm from cache ways needs --hybrid-mem.\n"
+        sys.exit(1)
+
+    if options.spm_event_queues > 1:
+        if options.l2cache or options.external_memory_system:
+            print "Parallel spm meshes need private memory paths per node.\n"
+            sys.exit(1)
+        if buildEnv['TARGET_ISA'] == 'x86':
+            print "Parallel spm meshes don't bridge x86 interrupts.\n"
+            sys.exit(1)
+
     if options.cpu_type == "arm_detailed":
         try:
             from O3_ARM_v7a import *
@@ -110,7 +122,21 @@ def config_cache(options, system):
             dspm = L1_DSPM(size=options.l1dspm_size,
                            read_ber = options.spm_read_ber,
                            write_ber = options.spm_write_ber,
-                           ber_energy_file = options.ber_energy_file)
+                           ber_energy_file = options.ber_energy_file,
+                           fault_seed = options.spm_fault_seed,
+                           huge_pages = options.spm_huge_pages,
+                           num_banks = options.spm_banks,
+                           bank_interleaving = options.spm_bank_interleaving,
+                           ports_per_bank = options.spm_ports_per_bank)
+
+            if options.spm_cache_ways >= 0:
+                # The spm takes its slots from the ways of the L1, it can
+                # grow to all of them but one
+                way_size = m5.util.convert.toMemorySize(options.l1d_size) / \
+                           options.l1d_assoc
+                dspm.size = way_size * (options.l1d_assoc - 1)
+                dspm.reconfigurable = True
+                dspm.cache_ways = options.spm_cache_ways
 
             if options.hybrid_mem: #todo: make this more modular -- similar to BaseCPU.py
                 dcache = L1_5_DCache(size=options.l1d_size,
@@ -177,6 +203,16 @@ def config_cache(options, system):
             system.cpu[i].connectAllPorts(system.tol2bus, system.membus)
         elif options.external_memory_system:
             system.cpu[i].connectUncachedPorts(system.membus)
+        elif options.spm_event_queues > 1:
+            # The node runs in its own event queue, its accesses reach the
+            # shared memory over a bridge to the queue of the memory
+            system.cpu[i].eventq_index = \
+                1 + i % (options.spm_event_queues - 1)
+            system.cpu[i].nodebus = L2XBar(clk_domain = system.cpu_clk_domain)
+            system.cpu[i].membridge = QueueBridge(master_eventq_index = 0)
+            system.cpu[i].nodebus.master = system.cpu[i].membridge.slave
+            system.cpu[i].membridge.master = system.membus.slave
+            system.cpu[i].connectAllPorts(system.cpu[i].nodebus)
         else:
             system.cpu[i].connectAllPorts(system.membus)
     return pmmu_nodes, system
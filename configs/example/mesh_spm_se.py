@@ -110,6 +110,9 @@ def add_all_options():
     parser.add_option("--spm-page-size", type="int", default="512",
                       help="spm page size in bytes")
     parser.add_option("--l1dspm-size", type="string", default="64kB")
+    parser.add_option("--spm-cache-ways", type="int", default="-1",
+                      help="carve the spm from the ways of the L1 and start "
+                      "it with this many, -1 for a separate array")
 
     # governor options
     parser.add_option("--gov-type", type="string", default="Local")
@@ -117,6 +120,37 @@ def add_all_options():
     parser.add_option("--guest-slot-selection-policy", type="string", default="LeastRecentlyUsed")
     parser.add_option("--guest-slot-relocation-policy", type="string", default="MoveOffChip")
     parser.add_option("--uncacheable-spm", action="store_true")
+    parser.add_option("--migration-epoch", type="string", default="10us")
+    parser.add_option("--migration-budget", type="int", default="4")
+    parser.add_option("--migration-threshold", type="int", default="16")
+    parser.add_option("--replication-epoch", type="string", default="10us")
+    parser.add_option("--replication-budget", type="int", default="4")
+    parser.add_option("--replication-threshold", type="int", default="32")
+    parser.add_option("--power-epoch", type="string", default="10us")
+    parser.add_option("--cold-threshold", type="int", default="1")
+    parser.add_option("--approx-epoch", type="string", default="10us")
+    parser.add_option("--error-budget", type="int", default="8")
+    parser.add_option("--plan-file", type="string", default="",
+                      help="placement plan replayed by the Plan governor")
+
+    # profiling options
+    parser.add_option("--spm-profile", action="store_true",
+                      help="record per-page accesses for util/spm_plan.py")
+    parser.add_option("--spm-profile-epoch", type="string", default="10us")
+    parser.add_option("--spm-timeline", action="store_true",
+                      help="sample per-node spm occupancy and traffic every epoch")
+    parser.add_option("--spm-timeline-epoch", type="string", default="10us")
+    parser.add_option("--spm-timeline-binary", action="store_true",
+                      help="write the timeline as binary rather than CSV")
+
+    # parallel simulation options
+    parser.add_option("--spm-event-queues", type="int", default="1",
+                      help="event queues the nodes are spread over, the "
+                      "memory, network and governor stay on the first")
+    parser.add_option("--sim-quantum", type="string", default="1ns",
+                      help="synchronization quantum of the event queues")
+    parser.add_option("--spm-huge-pages", action="store_true",
+                      help="back the spm slots with huge pages of the host")
 
     # approx options
     parser.add_option("--spm-read-ber", type="float", default="-1",
@@ -124,6 +158,15 @@ def add_all_options():
     parser.add_option("--spm-write-ber", type="float", default="-1",
                       help="write ber for approximate spm writes")
     parser.add_option("--ber-energy-file", type="string", default="")
+    parser.add_option("--spm-fault-seed", type="int", default="1",
+                      help="seed of the spm fault injectors")
+
+    # spm timing options
+    parser.add_option("--spm-banks", type="int", default="0",
+                      help="banks of every spm, 0 for unlimited bandwidth")
+    parser.add_option("--spm-bank-interleaving", type="int", default="64",
+                      help="bytes mapped to a bank before the next one")
+    parser.add_option("--spm-ports-per-bank", type="int", default="1")
 
     return parser
 
@@ -227,6 +270,10 @@ else:
 
 
 (CPUClass, test_mem_mode, FutureClass) = Simulation.setCPUClass(options)
+# ruby only carries the pmmu messages here, the spms and caches can be
+# accessed atomically while fast-forwarding
+if test_mem_mode == 'atomic_noncaching':
+    test_mem_mode = 'atomic'
 CPUClass.numThreads = numThreads
 
 # Check -- do not allow SMT with multiple CPUs
@@ -304,12 +351,33 @@ system.governor = BaseGovernor(gov_type = options.gov_type,
                                guest_slot_selection_policy = options.guest_slot_selection_policy,
                                guest_slot_relocation_policy = options.guest_slot_relocation_policy,
                                hybrid_mem = options.hybrid_mem,
-                               uncacheable_spm = options.uncacheable_spm)
+                               uncacheable_spm = options.uncacheable_spm,
+                               migration_epoch = options.migration_epoch,
+                               migration_budget = options.migration_budget,
+                               migration_threshold = options.migration_threshold,
+                               replication_epoch = options.replication_epoch,
+                               replication_budget = options.replication_budget,
+                               replication_threshold = options.replication_threshold,
+                               power_epoch = options.power_epoch,
+                               cold_threshold = options.cold_threshold,
+                               approx_epoch = options.approx_epoch,
+                               error_budget = options.error_budget,
+                               plan_file = options.plan_file)
 pmmus,sys = SPMConfig.config_cache(options, system)
+if options.spm_profile:
+    system.spm_profiler = SPMProfiler(spms = [cpu.dspm for cpu in system.cpu],
+                                      epoch = options.spm_profile_epoch)
+if options.spm_timeline:
+    system.spm_timeline = SPMTimeline(spms = [cpu.dspm for cpu in system.cpu],
+                                      epoch = options.spm_timeline_epoch,
+                                      binary = options.spm_timeline_binary)
 MemConfig.config_mem(options, system)
 system.ruby = RubySystem(num_of_sequencers=0,
                          block_size_bytes = options.cacheline_size)
 create_system(options, system, pmmus)
 
 root = Root(full_system = False, system = system)
+if options.spm_event_queues > 1:
+    root.sim_quantum = \
+        m5.ticks.fromSeconds(m5.util.convert.anyToLatency(options.sim_quantum))
 Simulation.run(options, root, system, FutureClass)
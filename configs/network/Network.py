@@ -41,8 +41,8 @@ def define_options(parser):
     parser.add_option("--mesh-rows", type="int", default=0,
                       help="the number of rows in the mesh topology")
     parser.add_option("--network", type="choice", default="simple",
-                      choices=['simple', 'garnet2.0'],
-                      help="'simple'|'garnet2.0'")
+                      choices=['simple', 'garnet2.0', 'analytical'],
+                      help="'simple'|'garnet2.0'|'analytical'")
     parser.add_option("--router-latency", action="store", type="int",
                       default=1,
                       help="""number of pipeline stages in the garnet router.
@@ -73,6 +73,10 @@ def define_options(parser):
     parser.add_option("--garnet-deadlock-threshold", action="store",
                       type="int", default=50000,
                       help="network-level deadlock threshold.")
+    parser.add_option("--utilization-window", action="store", type="int",
+                      default=100,
+                      help="""cycles over which the analytical network
+                            measures the utilization of its links.""")
 
 
 def create_network(options, ruby):
@@ -85,6 +89,13 @@ def create_network(options, ruby):
         RouterClass = GarnetRouter
         InterfaceClass = GarnetNetworkInterface
 
+    elif options.network == "analytical":
+        NetworkClass = AnalyticalNetwork
+        IntLinkClass = BasicIntLink
+        ExtLinkClass = BasicExtLink
+        RouterClass = BasicRouter
+        InterfaceClass = None
+
     else:
         NetworkClass = SimpleNetwork
         IntLinkClass = SimpleIntLink
@@ -111,6 +122,9 @@ def init_network(options, network, InterfaceClass):
     if options.network == "simple":
         network.setup_buffers()
 
+    if options.network == "analytical":
+        network.utilization_window = options.utilization_window
+
     if InterfaceClass != None:
         netifs = [InterfaceClass(id=i) \
                   for (i,n) in enumerate(network.ext_links)]
@@ -74,12 +74,15 @@
 
 #define M5OP_SPM_ALLOC          0x56 // Reserved for user
 #define M5OP_SPM_FREE           0x57 // Reserved for user
-#define M5OP_RESERVED4          0x58 // Reserved for user
-#define M5OP_RESERVED5          0x59 // Reserved for user
+#define M5OP_SPM_TEST           0x58 // Reserved for user
+#define M5OP_SPM_STREAM         0x59 // Reserved for user
 
 #define M5OP_WORK_BEGIN         0x5a
 #define M5OP_WORK_END           0x5b
 
+#define M5OP_SPM_TRANSFER       0x5c
+#define M5OP_SPM_RESIZE         0x5d
+
 #define M5OP_SE_SYSCALL         0x60
 #define M5OP_SE_PAGE_FAULT      0x61
 #define M5OP_DIST_TOGGLE_SYNC   0x62
@@ -130,6 +133,10 @@
     M5OP(m5_work_end, M5OP_WORK_END, 0);                        \
     M5OP(m5_spm_alloc, M5OP_SPM_ALLOC, 0);                    \
     M5OP(m5_spm_free, M5OP_SPM_FREE, 0);                        \
+    M5OP(m5_spm_test, M5OP_SPM_TEST, 0);                        \
+    M5OP(m5_spm_stream, M5OP_SPM_STREAM, 0);                    \
+    M5OP(m5_spm_transfer, M5OP_SPM_TRANSFER, 0);                \
+    M5OP(m5_spm_resize, M5OP_SPM_RESIZE, 0);                    \
     M5OP(m5_dist_toggle_sync, M5OP_DIST_TOGGLE_SYNC, 0);
 
 #define M5OP_FOREACH_ANNOTATION                      \
@@ -68,8 +68,12 @@ void m5_work_begin(uint64_t workid, uint64_t threadid);
 void m5_work_end(uint64_t workid, uint64_t threadid);
 
 // SPM-APIs
-void m5_spm_alloc(uint64_t begin, uint64_t end, uint64_t metadata);
-void m5_spm_free(uint64_t begin, uint64_t end, uint64_t metadata);
+uint64_t m5_spm_alloc(uint64_t begin, uint64_t end, uint64_t metadata);
+uint64_t m5_spm_free(uint64_t begin, uint64_t end, uint64_t metadata);
+uint64_t m5_spm_test(uint64_t ticket);
+uint64_t m5_spm_stream(uint64_t begin, uint64_t end, uint64_t metadata);
+uint64_t m5_spm_transfer(uint64_t begin, uint64_t end, uint64_t metadata);
+uint64_t m5_spm_resize(uint64_t num_ways);
 
 // These operations are for critical path annotation
 void m5a_bsm(char *sm, const void *id, int flags);
@@ -31,6 +31,8 @@
 #ifndef __BASE_REFCNT_HH__
 #define __BASE_REFCNT_HH__
 
+#include <type_traits>
+
 /**
  * @file base/refcnt.hh
  *
@@ -163,6 +165,12 @@ class RefCountingPtr
     /// one.  Adds a reference.
     RefCountingPtr(const RefCountingPtr &r) { copy(r.data); }
 
+    /// Create a new reference counting pointer by copying one to a
+    /// derived class.  Adds a reference.
+    template <class U, class = typename std::enable_if<
+                           std::is_convertible<U *, T *>::value>::type>
+    RefCountingPtr(const RefCountingPtr<U> &r) { copy(r.get()); }
+
     /// Destroy the pointer and any reference it may hold.
     ~RefCountingPtr() { del(); }
 
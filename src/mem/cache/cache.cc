@@ -73,6 +73,8 @@ Cache::Cache(const CacheParams *p)
       prefetchOnAccess(p->prefetch_on_access),
       clusivity(p->clusivity),
       writebackClean(p->writeback_clean),
+      numWays(p->assoc),
+      waySize(p->size / p->assoc),
       tempBlockWriteback(nullptr),
       writebackTempBlockAtomicEvent([this]{ writebackTempBlockAtomic(); },
                                     name(), false,
@@ -1801,6 +1803,66 @@ Cache::invalidateVisitor(CacheBlk &blk)
     return true;
 }
 
+bool
+Cache::setAllocatableWays(unsigned num_ways, Tick &ready_tick)
+{
+    fatal_if(num_ways > numWays, "%s has only %d ways\n", name(), numWays);
+
+    ready_tick = curTick();
+
+    CacheBlkFromWayVisitor visitor(num_ways);
+    tags->forEachBlk(visitor);
+    const std::vector<CacheBlk*> &blks = visitor.getBlks();
+
+    // a block with a miss outstanding is in a transient state
+    for (auto blk : blks) {
+        Addr blk_addr = tags->regenerateBlkAddr(blk->tag, blk->set);
+        if (mshrQueue.findMatch(blk_addr, blk->isSecure())) {
+            DPRINTF(Cache, "Can't give way %d away, %#llx has a miss "
+                    "outstanding\n", blk->way, blk_addr);
+            return false;
+        }
+    }
+
+    // the blocks leave through the write buffer like any other eviction,
+    // as many at a time as it takes; the rest wait for the next try
+    bool timing = system->isTimingMode();
+    PacketList writebacks;
+    for (auto blk : blks) {
+        if (timing && (int)writebacks.size() >= writeBuffer.numFree()) {
+            break;
+        }
+
+        if (blk->isDirty() || writebackClean) {
+            writebacks.push_back(writebackBlk(blk));
+        } else {
+            writebacks.push_back(cleanEvictBlk(blk));
+        }
+        invalidateBlock(blk);
+    }
+
+    const size_t num_evicted = writebacks.size();
+    if (timing) {
+        // one cycle to read each block out of the array
+        if (num_evicted)
+            ready_tick = clockEdge(Cycles(forwardLatency + num_evicted));
+        doWritebacks(writebacks, clockEdge(forwardLatency));
+    } else {
+        doWritebacksAtomic(writebacks);
+    }
+
+    if (num_evicted < blks.size()) {
+        DPRINTF(Cache, "Can't give %d way(s) away yet, %d block(s) are "
+                "left in them\n", numWays - num_ways,
+                blks.size() - num_evicted);
+        return false;
+    }
+
+    DPRINTF(Cache, "Allocating in %d of %d ways\n", num_ways, numWays);
+    tags->setWayAllocationMax(num_ways);
+    return true;
+}
+
 CacheBlk*
 Cache::allocateBlock(Addr addr, bool is_secure, PacketList &writebacks)
 {
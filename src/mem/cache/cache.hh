@@ -53,6 +53,7 @@
 #define __MEM_CACHE_CACHE_HH__
 
 #include <unordered_set>
+#include <vector>
 
 #include "base/logging.hh" // fatal, panic, and warn
 #include "enums/Clusivity.hh"
@@ -229,6 +230,10 @@ class Cache : public BaseCache
      */
     const bool writebackClean;
 
+    /** Number of ways of the array and bytes in each of them. */
+    const unsigned numWays;
+    const unsigned waySize;
+
     /**
      * Upstream caches need this packet until true is returned, so
      * hold it for deletion until a subsequent call
@@ -538,6 +543,23 @@ class Cache : public BaseCache
         return (mshrQueue.findMatch(addr, is_secure) != 0);
     }
 
+    /**
+     * Restricts the cache to its first num_ways ways, the array of the
+     * others is left to a scratchpad sharing it. The blocks in the ways
+     * given away are evicted through the write buffer.
+     *
+     * @param num_ways The number of ways left to the cache.
+     * @param ready_tick Set to when the evicted blocks are out of the
+     * array.
+     * @return False, with the ways left as they were, while a miss is
+     * outstanding on one of the blocks or the write buffer can't take
+     * all of them yet.
+     */
+    bool setAllocatableWays(unsigned num_ways, Tick &ready_tick);
+
+    unsigned getNumWays() const { return numWays; }
+    unsigned getWaySize() const { return waySize; }
+
     /**
      * Find next request ready time from among possible sources.
      */
@@ -637,4 +659,33 @@ class CacheBlkIsDirtyVisitor : public CacheBlkVisitor
     bool _isDirty;
 };
 
+/**
+ * Cache block visitor that collects the valid blocks from a given way on.
+ *
+ * Use with the forEachBlk method in the tag array to find the blocks
+ * in the ways the cache is giving away.
+ */
+class CacheBlkFromWayVisitor : public CacheBlkVisitor
+{
+  public:
+    CacheBlkFromWayVisitor(int first_way)
+        : firstWay(first_way) {}
+
+    bool operator()(CacheBlk &blk) override {
+        if (blk.isValid() && blk.way >= firstWay) {
+            blks.push_back(&blk);
+        }
+        return true;
+    }
+
+    /**
+     * The valid blocks in the ways from firstWay on.
+     */
+    const std::vector<CacheBlk*> &getBlks() const { return blks; }
+
+  private:
+    const int firstWay;
+    std::vector<CacheBlk*> blks;
+};
+
 #endif // __MEM_CACHE_CACHE_HH__
@@ -49,6 +49,7 @@
 #ifndef __MEM_CACHE_QUEUE_HH__
 #define __MEM_CACHE_QUEUE_HH__
 
+#include <algorithm>
 #include <cassert>
 
 #include "base/trace.hh"
@@ -147,6 +148,15 @@ class Queue : public Drainable
         return _numInService;
     }
 
+    /**
+     * The number of entries that can be allocated before the queue is
+     * full, leaving the reserve aside.
+     */
+    int numFree() const
+    {
+        return std::max(numEntries - numReserve - allocated, 0);
+    }
+
     /**
      * Find the first WriteQueueEntry that matches the provided address.
      * @param blk_addr The block address to find.
@@ -216,9 +216,13 @@ public:
         BlkType *blk = nullptr;
         int set = extractSet(addr);
 
-        // prefer to evict an invalid block
-        for (int i = 0; i < allocAssoc; ++i) {
-            blk = sets[set].blks[i];
+        // prefer to evict an invalid block, the blocks are kept in
+        // replacement order so the ways past the limit are skipped
+        for (int i = 0; i < assoc; ++i) {
+            BlkType *b = sets[set].blks[i];
+            if (b->way >= allocAssoc)
+                continue;
+            blk = b;
             if (!blk->isValid())
                 break;
         }
@@ -65,14 +65,17 @@
 #include "base/types.hh"
 #include "mem/request.hh"
 #include "sim/core.hh"
-#include "mem/spm/SPMPktInfo.hh"
-#include "mem/spm/governor/GOVPktInfo.hh"
-
 
 class Packet;
 typedef Packet *PacketPtr;
 typedef uint8_t* PacketDataPtr;
 typedef std::list<PacketPtr> PacketList;
+
+// SPM/governor metadata of a packet, see mem/spm/SPMPacketExtension.hh
+class SPMPacketExtension;
+class SPMPktInfo;
+class GOVPktInfo;
+void releaseSPMExtension(SPMPacketExtension *ext);
 typedef uint64_t PacketId;
 
 class MemCmd
@@ -751,7 +754,7 @@ class Packet : public Printable
     Packet(const RequestPtr _req, MemCmd _cmd)
         :  cmd(_cmd), id((PacketId)_req), req(_req), data(nullptr), addr(0),
            _isSecure(false), size(0), headerDelay(0), snoopDelay(0),
-           payloadDelay(0), senderState(NULL)
+           payloadDelay(0), senderState(NULL), spmExt(nullptr)
     {
         if (req->hasPaddr()) {
             addr = req->getPaddr();
@@ -772,7 +775,7 @@ class Packet : public Printable
     Packet(const RequestPtr _req, MemCmd _cmd, int _blkSize, PacketId _id = 0)
         :  cmd(_cmd), id(_id ? _id : (PacketId)_req), req(_req), data(nullptr),
            addr(0), _isSecure(false), headerDelay(0), snoopDelay(0),
-           payloadDelay(0), senderState(NULL)
+           payloadDelay(0), senderState(NULL), spmExt(nullptr)
     {
         if (req->hasPaddr()) {
             addr = req->getPaddr() & ~(_blkSize - 1);
@@ -798,7 +801,8 @@ class Packet : public Printable
            headerDelay(pkt->headerDelay),
            snoopDelay(0),
            payloadDelay(pkt->payloadDelay),
-           senderState(pkt->senderState)
+           senderState(pkt->senderState),
+           spmExt(nullptr)
     {
         if (!clear_flags)
             flags.set(pkt->flags & COPY_FLAGS);
@@ -889,6 +893,8 @@ class Packet : public Printable
             delete req;
         }
         deleteData();
+        if (spmExt)
+            releaseSPMExtension(spmExt);
     }
 
     /**
@@ -1239,24 +1245,20 @@ class Packet : public Printable
     std::string print() const;
 
     /**
-     * SPM-related enhancements
+     * SPM-related enhancements. Only the packets handled by a PMMU
+     * carry them, the accessors are defined along with the extension.
      */
+    SPMPacketExtension *spmExt;
 
     // The info for a spm request.
-    SPMPktInfo spmInfo;
+    SPMPktInfo &spmInfo();
 
     // The info for a governor request.
-    GOVPktInfo govInfo;
+    GOVPktInfo &govInfo();
 
     // The command field of the packet.
-    MemCmd origCmd;
-
-    void saveCmd() {
-		origCmd = cmd;
-    }
-    void retrieveCmd() {
-		cmd = origCmd;
-    }
+    void saveCmd();
+    void retrieveCmd();
 };
 
 #endif //__MEM_PACKET_HH
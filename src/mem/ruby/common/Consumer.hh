@@ -70,6 +70,9 @@ class Consumer
 
     void scheduleEventAbsolute(Tick timeAbs);
 
+    // queue the wakeups of the consumer are served from
+    EventQueue *eventQueue() const { return em->eventQueue(); }
+
   protected:
     void scheduleEvent(Cycles timeDelta);
 
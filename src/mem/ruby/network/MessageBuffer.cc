@@ -150,6 +150,12 @@ random_time()
 void
 MessageBuffer::enqueue(MsgPtr message, Tick current_time, Tick delta)
 {
+    assert(m_consumer != NULL);
+    if (inParallelMode && m_consumer->eventQueue() != curEventQueue()) {
+        enqueueFromOtherQueue(message, current_time, delta);
+        return;
+    }
+
     // record current time incase we have a pop that also adjusts my size
     if (m_time_last_time_enqueue < current_time) {
         m_msgs_this_cycle = 0;  // first msg this cycle
@@ -221,6 +227,23 @@ MessageBuffer::enqueue(MsgPtr message, Tick current_time, Tick delta)
     m_consumer->storeEventInfo(m_vnet_id);
 }
 
+void
+MessageBuffer::enqueueFromOtherQueue(MsgPtr message, Tick current_time,
+                                     Tick delta)
+{
+    // the sender can't tell how full we are, and the message can only be
+    // handed over once the queues synchronize, a quantum later at least
+    if (m_max_size != 0) {
+        fatal("%s: a finite buffer can't be fed from another event queue\n",
+              name());
+    }
+
+    Tick delivery_time = current_time + std::max(delta, simQuantum);
+    m_consumer->eventQueue()->schedule(new EventFunctionWrapper(
+        [this, message]{ enqueue(message, curTick(), 1); },
+        name() + ".crossing", true), delivery_time);
+}
+
 Tick
 MessageBuffer::dequeue(Tick current_time, bool decrement_messages)
 {
@@ -133,6 +133,10 @@ class MessageBuffer : public SimObject
   private:
     void reanalyzeList(std::list<MsgPtr> &, Tick);
 
+    //! Hands a message sent from the thread of another event queue over
+    //! to the one of the consumer.
+    void enqueueFromOtherQueue(MsgPtr message, Tick curTime, Tick delta);
+
   private:
     // Data Members (m_ prefix)
     //! Consumer to signal a wakeup(), can be NULL
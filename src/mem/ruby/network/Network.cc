@@ -43,6 +43,7 @@
 #include "base/logging.hh"
 #include "mem/ruby/common/MachineID.hh"
 #include "mem/ruby/network/BasicLink.hh"
+#include "mem/ruby/slicc_interface/Message.hh"
 #include "mem/ruby/system/RubySystem.hh"
 
 uint32_t Network::m_virtual_networks;
@@ -159,6 +160,13 @@ Network::MessageSizeType_to_int(MessageSizeType size_type)
     }
 }
 
+uint32_t
+Network::getMessageSizeBytes(const Message *msg)
+{
+    return MessageSizeType_to_int(msg->getMessageSize()) +
+           msg->getExtraDataBytes();
+}
+
 void
 Network::checkNetworkAllocation(NodeID id, bool ordered,
                                         int network_num,
@@ -70,6 +70,7 @@
 
 class NetDest;
 class MessageBuffer;
+class Message;
 
 class Network : public ClockedObject
 {
@@ -84,8 +85,11 @@ class Network : public ClockedObject
 
     static uint32_t getNumberOfVirtualNetworks() { return m_virtual_networks; }
     int getNumNodes() const { return m_nodes; }
+    const Topology *getTopology() const { return m_topology_ptr; }
 
     static uint32_t MessageSizeType_to_int(MessageSizeType size_type);
+    // the size of the message type, plus the extra data of the message
+    static uint32_t getMessageSizeBytes(const Message *msg);
 
     // returns the queue requested for the given component
     void setToNetQueue(NodeID id, bool ordered, int netNumber,
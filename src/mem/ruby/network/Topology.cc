@@ -29,6 +29,7 @@
 #include "mem/ruby/network/Topology.hh"
 
 #include <cassert>
+#include <queue>
 
 #include "base/trace.hh"
 #include "debug/RubyNetwork.hh"
@@ -157,6 +158,43 @@ Topology::createLinks(Network *net)
     }
 }
 
+Matrix
+Topology::hopDistances() const
+{
+    int num_switches = 2 * m_nodes + m_number_of_switches;
+    vector<vector<SwitchID>> next_switches(num_switches);
+    for (LinkMap::const_iterator i = m_link_map.begin();
+         i != m_link_map.end(); ++i) {
+        next_switches[(*i).first.first].push_back((*i).first.second);
+    }
+
+    Matrix hops(m_nodes, vector<int>(m_nodes, -1));
+    for (SwitchID src = 0; src < m_nodes; src++) {
+        // breadth-first walk from the endpoint's input link
+        vector<int> dist(num_switches, -1);
+        queue<SwitchID> frontier;
+        dist[src] = 0;
+        frontier.push(src);
+        while (!frontier.empty()) {
+            SwitchID s = frontier.front();
+            frontier.pop();
+            for (SwitchID next : next_switches[s]) {
+                if (dist[next] < 0) {
+                    dist[next] = dist[s] + 1;
+                    frontier.push(next);
+                }
+            }
+        }
+
+        // don't count the external links at both ends
+        for (SwitchID dst = 0; dst < m_nodes; dst++) {
+            if (dist[dst + m_nodes] >= 2)
+                hops[src][dst] = dist[dst + m_nodes] - 2;
+        }
+    }
+    return hops;
+}
+
 void
 Topology::addLink(SwitchID src, SwitchID dest, BasicLink* link,
                   PortDirection src_outport_dirn,
@@ -71,6 +71,11 @@ class Topology
 
     uint32_t numSwitches() const { return m_number_of_switches; }
     void createLinks(Network *net);
+
+    // Number of router-to-router links on the shortest route between
+    // every pair of endpoints (machine-wide controller indices), or -1
+    // if unreachable. Link weights are ignored, each link is one hop.
+    Matrix hopDistances() const;
     void print(std::ostream& out) const { out << "[Topology]"; }
 
   private:
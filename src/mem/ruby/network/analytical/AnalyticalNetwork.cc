@@ -0,0 +1,355 @@
+#include "mem/ruby/network/analytical/AnalyticalNetwork.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "base/trace.hh"
+#include "debug/RubyNetwork.hh"
+#include "mem/ruby/network/BasicLink.hh"
+#include "mem/ruby/network/BasicRouter.hh"
+#include "mem/ruby/network/MessageBuffer.hh"
+
+using namespace std;
+
+AnalyticalNetwork::AnalyticalNetwork(const Params *p)
+    : Network(p), Consumer(this),
+      m_endpoint_bandwidth(p->endpoint_bandwidth),
+      m_window(p->utilization_window),
+      m_max_utilization(p->max_utilization)
+{
+    fatal_if(m_window == 0, "%s: the utilization window can't be empty\n",
+             name());
+    fatal_if(m_max_utilization <= 0 || m_max_utilization >= 1,
+             "%s: the maximum utilization must be in (0, 1)\n", name());
+
+    // the latency of every router, indexed like the topology does
+    for (auto router : p->routers) {
+        int id = router->params()->router_id;
+        if (id >= m_router_latency.size())
+            m_router_latency.resize(id + 1, Cycles(0));
+        m_router_latency[id] = router->params()->latency;
+    }
+
+    m_switch_links.resize(m_router_latency.size());
+    m_node_links.resize(m_nodes, -1);
+    m_last_arrival.resize(m_nodes, vector<Tick>(m_virtual_networks, 0));
+}
+
+void
+AnalyticalNetwork::init()
+{
+    Network::init();
+
+    // The topology pointer should have already been initialized in
+    // the parent class network constructor.
+    assert(m_topology_ptr != NULL);
+    m_topology_ptr->createLinks(this);
+
+    m_routes.resize(m_nodes, vector<vector<int> >(m_nodes));
+    for (NodeID src = 0; src < m_nodes; src++) {
+        if (m_node_links[src] < 0)
+            continue;
+        for (NodeID dest = 0; dest < m_nodes; dest++)
+            computeRoute(src, dest);
+    }
+}
+
+void
+AnalyticalNetwork::addLink(int src_switch, int dest_switch, BasicLink *link,
+                           Cycles router_latency,
+                           const NetDest& routing_table_entry)
+{
+    Link l;
+    l.latency = link->m_latency + router_latency;
+    l.bandwidth = (double)link->m_bandwidth_factor * m_endpoint_bandwidth /
+                  1000;
+    fatal_if(l.bandwidth <= 0, "%s: link %s has no bandwidth\n", name(),
+             link->name());
+    l.dest_switch = dest_switch;
+    l.routing = routing_table_entry;
+    l.reaches.resize(m_nodes, false);
+    for (NodeID node : l.routing.getAllDest())
+        l.reaches[node] = true;
+    l.window_start = 0;
+    l.bytes = 0;
+    l.prev_bytes = 0;
+
+    if (src_switch >= 0)
+        m_switch_links[src_switch].push_back(m_links.size());
+    m_links.push_back(l);
+}
+
+// From a switch to an endpoint node
+void
+AnalyticalNetwork::makeExtOutLink(SwitchID src, NodeID dest, BasicLink* link,
+                                  const NetDest& routing_table_entry)
+{
+    assert(dest < m_nodes);
+    assert(src < m_switch_links.size());
+    addLink(src, -1, link, Cycles(0), routing_table_entry);
+}
+
+// From an endpoint node to a switch
+void
+AnalyticalNetwork::makeExtInLink(NodeID src, SwitchID dest, BasicLink* link,
+                                 const NetDest& routing_table_entry)
+{
+    assert(src < m_nodes);
+    assert(dest < m_switch_links.size());
+
+    m_node_links[src] = m_links.size();
+    addLink(-1, dest, link, m_router_latency[dest], routing_table_entry);
+
+    // the network takes the messages of the endpoint right away
+    for (int i = 0; i < m_toNetQueues[src].size(); i++) {
+        MessageBuffer *buffer = m_toNetQueues[src][i];
+        if (buffer != nullptr) {
+            buffer->setConsumer(this);
+            buffer->setIncomingLink(src);
+            buffer->setVnet(i);
+        }
+    }
+}
+
+// From a switch to a switch
+void
+AnalyticalNetwork::makeInternalLink(SwitchID src, SwitchID dest,
+                                    BasicLink* link,
+                                    const NetDest& routing_table_entry,
+                                    PortDirection src_outport,
+                                    PortDirection dst_inport)
+{
+    assert(src < m_switch_links.size());
+    assert(dest < m_switch_links.size());
+    addLink(src, dest, link, m_router_latency[dest], routing_table_entry);
+}
+
+void
+AnalyticalNetwork::computeRoute(NodeID src, NodeID dest)
+{
+    // follow the first link on the way at every switch, as the
+    // switches of the simple network do
+    vector<int> &route = m_routes[src][dest];
+    int l = m_node_links[src];
+    while (true) {
+        panic_if(route.size() > m_links.size(),
+                 "%s: routing loop from node %d to node %d\n",
+                 name(), src, dest);
+        route.push_back(l);
+
+        int sw = m_links[l].dest_switch;
+        if (sw < 0)
+            break;
+
+        l = -1;
+        for (int out : m_switch_links[sw]) {
+            if (m_links[out].reaches[dest]) {
+                l = out;
+                break;
+            }
+        }
+        if (l < 0) {
+            // not connected, a message sent this way panics
+            route.clear();
+            return;
+        }
+    }
+}
+
+double
+AnalyticalNetwork::utilization(Link &link, Cycles now)
+{
+    const uint64_t window = m_window;
+    const uint64_t cycle = now;
+
+    // slide the window up to now
+    if (cycle >= link.window_start + 2 * window) {
+        link.prev_bytes = 0;
+        link.bytes = 0;
+        link.window_start = cycle - (cycle - link.window_start) % window;
+    } else if (cycle >= link.window_start + window) {
+        link.prev_bytes = link.bytes;
+        link.bytes = 0;
+        link.window_start += window;
+    }
+
+    // the previous window counts for the part of it still within the
+    // last window cycles
+    double prev_share = (double)(window - (cycle - link.window_start)) /
+                        window;
+    double bytes = link.bytes + link.prev_bytes * prev_share;
+
+    return min(bytes / (link.bandwidth * window), m_max_utilization);
+}
+
+bool
+AnalyticalNetwork::sendMessage(NodeID src, MessageBuffer *buffer, int vnet)
+{
+    Tick current_time = clockEdge();
+    Cycles now = curCycle();
+
+    MsgPtr msg_ptr = buffer->peekMsgPtr();
+    NetDest destination = msg_ptr->getDestination();
+    vector<NodeID> dests = destination.getAllDest();
+    int bytes = getMessageSizeBytes(msg_ptr.get());
+
+    for (NodeID dest : dests) {
+        panic_if(dest >= m_nodes || m_routes[src][dest].empty(),
+                 "%s: no route from node %d to node %d\n",
+                 name(), src, dest);
+        panic_if(m_fromNetQueues[dest].size() <= vnet ||
+                 m_fromNetQueues[dest][vnet] == nullptr,
+                 "%s: node %d doesn't take messages on vnet %d\n",
+                 name(), dest, vnet);
+        if (!m_fromNetQueues[dest][vnet]->areNSlotsAvailable(1,
+                                                             current_time))
+            return false;
+    }
+
+    buffer->dequeue(current_time);
+    m_msg_count++;
+
+    for (int i = 0; i < dests.size(); i++) {
+        NodeID dest = dests[i];
+        const vector<int> &route = m_routes[src][dest];
+
+        // every hop adds the latency of its link and router, and the
+        // M/D/1 waiting time of its link at the current utilization;
+        // the message is serialized once, over the narrowest link
+        double latency = 0;
+        double queueing = 0;
+        double serialization = 0;
+        for (int l : route) {
+            Link &link = m_links[l];
+            double service = bytes / link.bandwidth;
+            double u = utilization(link, now);
+            double wait = service * u / (2 * (1 - u));
+            latency += link.latency + wait;
+            queueing += wait;
+            serialization = max(serialization, service);
+        }
+        latency += serialization;
+
+        for (int l : route) {
+            m_links[l].bytes += bytes;
+            m_link_bytes[l] += bytes;
+        }
+
+        // the last copy takes the message itself
+        MsgPtr out_msg = (i + 1 < dests.size()) ? msg_ptr->clone() : msg_ptr;
+        out_msg->getDestination() = m_links[route.back()].routing;
+
+        MessageBuffer *out = m_fromNetQueues[dest][vnet];
+        Tick arrival = current_time +
+                       cyclesToTicks(Cycles(max(1.0, ceil(latency))));
+        if (out->getOrdered()) {
+            arrival = max(arrival, m_last_arrival[dest][vnet]);
+            m_last_arrival[dest][vnet] = arrival;
+        }
+
+        DPRINTF(RubyNetwork, "node %d to node %d vnet %d: %d bytes, %d "
+                "hops, latency %.1f cycles (%.1f queueing)\n", src, dest,
+                vnet, bytes, route.size(), latency, queueing);
+
+        out->enqueue(out_msg, current_time, arrival - current_time);
+
+        m_deliveries++;
+        m_msg_bytes += bytes;
+        m_total_latency += latency;
+        m_queueing_latency += queueing;
+    }
+
+    return true;
+}
+
+void
+AnalyticalNetwork::wakeup()
+{
+    Tick current_time = clockEdge();
+
+    for (NodeID node = 0; node < m_nodes; node++) {
+        for (int vnet = 0; vnet < m_toNetQueues[node].size(); vnet++) {
+            MessageBuffer *buffer = m_toNetQueues[node][vnet];
+            if (buffer == nullptr)
+                continue;
+
+            while (buffer->isReady(current_time)) {
+                if (!sendMessage(node, buffer, vnet)) {
+                    // a destination is full, try again next cycle
+                    m_stalls++;
+                    scheduleEvent(Cycles(1));
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void
+AnalyticalNetwork::regStats()
+{
+    Network::regStats();
+
+    m_msg_count
+        .name(name() + ".msg_count")
+        .desc("Number of messages sent through the network")
+        ;
+
+    m_deliveries
+        .name(name() + ".deliveries")
+        .desc("Number of messages delivered, a copy per destination")
+        ;
+
+    m_msg_bytes
+        .name(name() + ".msg_bytes")
+        .desc("Number of bytes delivered by the network")
+        ;
+
+    m_total_latency
+        .name(name() + ".total_latency")
+        .desc("Total latency of the delivered messages, in cycles")
+        ;
+
+    m_queueing_latency
+        .name(name() + ".queueing_latency")
+        .desc("Part of the total latency spent waiting for busy links")
+        ;
+
+    m_stalls
+        .name(name() + ".stalls")
+        .desc("Number of times a message waited for its destination")
+        ;
+
+    m_avg_latency
+        .name(name() + ".avg_latency")
+        .desc("Average latency of a delivered message")
+        ;
+    m_avg_latency = m_total_latency / m_deliveries;
+
+    m_avg_queueing_latency
+        .name(name() + ".avg_queueing_latency")
+        .desc("Average queueing latency of a delivered message")
+        ;
+    m_avg_queueing_latency = m_queueing_latency / m_deliveries;
+
+    // every external link is a link in and a link out
+    m_link_bytes
+        .init(2 * params()->ext_links.size() + params()->int_links.size())
+        .name(name() + ".link_bytes")
+        .desc("Number of bytes sent over every link")
+        .flags(Stats::nozero)
+        ;
+}
+
+void
+AnalyticalNetwork::print(ostream& out) const
+{
+    out << "[AnalyticalNetwork]";
+}
+
+AnalyticalNetwork *
+AnalyticalNetworkParams::create()
+{
+    return new AnalyticalNetwork(this);
+}
@@ -0,0 +1,111 @@
+/* A network that doesn't move messages hop by hop. When a controller sends
+ * a message, its latency to every destination is computed from the route
+ * the topology gives it: the latency of the links and routers on the way,
+ * a queueing delay on every link that grows with the utilization of the
+ * link over the last window, and the time to serialize the message over
+ * the narrowest link of the route. The message is then put straight into
+ * the queue of the destination, so it costs a single event however far it
+ * goes. Links don't push back: a busy link only makes messages slower.
+ * */
+
+#ifndef __MEM_RUBY_NETWORK_ANALYTICAL_ANALYTICALNETWORK_HH__
+#define __MEM_RUBY_NETWORK_ANALYTICAL_ANALYTICALNETWORK_HH__
+
+#include <iostream>
+#include <vector>
+
+#include "mem/ruby/common/Consumer.hh"
+#include "mem/ruby/common/NetDest.hh"
+#include "mem/ruby/network/Network.hh"
+#include "params/AnalyticalNetwork.hh"
+
+class AnalyticalNetwork : public Network, public Consumer
+{
+  public:
+    typedef AnalyticalNetworkParams Params;
+    AnalyticalNetwork(const Params *p);
+
+    void init();
+
+    void wakeup();
+
+    void collateStats() {}
+    void regStats();
+
+    // Methods used by Topology to setup the network
+    void makeExtOutLink(SwitchID src, NodeID dest, BasicLink* link,
+                     const NetDest& routing_table_entry);
+    void makeExtInLink(NodeID src, SwitchID dest, BasicLink* link,
+                    const NetDest& routing_table_entry);
+    void makeInternalLink(SwitchID src, SwitchID dest, BasicLink* link,
+                          const NetDest& routing_table_entry,
+                          PortDirection src_outport,
+                          PortDirection dst_inport);
+
+    void print(std::ostream& out) const;
+
+    // messages are never held inside the network
+    bool functionalRead(Packet *pkt) { return false; }
+    uint32_t functionalWrite(Packet *pkt) { return 0; }
+
+  private:
+    struct Link
+    {
+        Cycles latency;         // of the link and the router it leads to
+        double bandwidth;       // bytes per cycle
+        int dest_switch;        // -1 for a link to an endpoint
+        NetDest routing;        // endpoints routed through the link
+        std::vector<bool> reaches;  // routing, indexed by endpoint
+
+        // bytes sent in the current and in the previous window
+        uint64_t window_start;  // cycle the current window began at
+        uint64_t bytes;
+        uint64_t prev_bytes;
+    };
+
+    void addLink(int src_switch, int dest_switch, BasicLink *link,
+                 Cycles router_latency, const NetDest& routing_table_entry);
+
+    // the links from the endpoint src to the endpoint dest
+    void computeRoute(NodeID src, NodeID dest);
+
+    // false if a destination can't take the message yet
+    bool sendMessage(NodeID src, MessageBuffer *buffer, int vnet);
+
+    // fraction of the bandwidth of the link used over the last window
+    double utilization(Link &link, Cycles now);
+
+    const int m_endpoint_bandwidth;
+    const Cycles m_window;
+    const double m_max_utilization;
+
+    std::vector<Cycles> m_router_latency;
+    std::vector<Link> m_links;
+    std::vector<std::vector<int> > m_switch_links;  // outgoing, per switch
+    std::vector<int> m_node_links;  // into the network, per endpoint
+    // links of the route from every endpoint to every endpoint
+    std::vector<std::vector<std::vector<int> > > m_routes;
+    // last arrival at every endpoint, per vnet, to keep ordered vnets
+    // in order
+    std::vector<std::vector<Tick> > m_last_arrival;
+
+    Stats::Scalar m_msg_count;
+    Stats::Scalar m_deliveries;
+    Stats::Scalar m_msg_bytes;
+    Stats::Scalar m_total_latency;
+    Stats::Scalar m_queueing_latency;
+    Stats::Scalar m_stalls;
+    Stats::Formula m_avg_latency;
+    Stats::Formula m_avg_queueing_latency;
+    Stats::Vector m_link_bytes;
+};
+
+inline std::ostream&
+operator<<(std::ostream& out, const AnalyticalNetwork& obj)
+{
+    obj.print(out);
+    out << std::flush;
+    return out;
+}
+
+#endif // __MEM_RUBY_NETWORK_ANALYTICAL_ANALYTICALNETWORK_HH__
@@ -0,0 +1,11 @@
+from m5.params import *
+from Network import RubyNetwork
+
+class AnalyticalNetwork(RubyNetwork):
+    type = 'AnalyticalNetwork'
+    cxx_header = "mem/ruby/network/analytical/AnalyticalNetwork.hh"
+    endpoint_bandwidth = Param.Int(1000, "bandwidth adjustment factor")
+    utilization_window = Param.Cycles(100,
+        "cycles over which the utilization of a link is measured")
+    max_utilization = Param.Float(0.95,
+        "utilization at which the queueing delay of a link stops growing")
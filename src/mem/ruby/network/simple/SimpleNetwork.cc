@@ -149,11 +149,9 @@ SimpleNetwork::regStats()
         for (int i = 0; i < m_switches.size(); i++) {
             m_msg_counts[(unsigned int) type] +=
                 sum(m_switches[i]->getMsgCount(type));
+            m_msg_bytes[(unsigned int) type] +=
+                sum(m_switches[i]->getMsgBytes(type));
         }
-
-        m_msg_bytes[(unsigned int) type] =
-            m_msg_counts[(unsigned int) type] * Stats::constant(
-                    Network::MessageSizeType_to_int(type));
     }
 }
 
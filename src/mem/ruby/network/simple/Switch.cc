@@ -140,9 +140,8 @@ Switch::regStats()
 
         for (unsigned int i = 0; i < m_throttles.size(); i++) {
             m_msg_counts[type] += m_throttles[i]->getMsgCount(type);
+            m_msg_bytes[type] += m_throttles[i]->getMsgBytes(type);
         }
-        m_msg_bytes[type] = m_msg_counts[type] * Stats::constant(
-                Network::MessageSizeType_to_int(MessageSizeType(type)));
     }
 }
 
@@ -74,6 +74,8 @@ class Switch : public BasicRouter
     void regStats();
     const Stats::Formula & getMsgCount(unsigned int type) const
     { return m_msg_counts[type]; }
+    const Stats::Formula & getMsgBytes(unsigned int type) const
+    { return m_msg_bytes[type]; }
 
     void print(std::ostream& out) const;
     void init_net_ptr(SimpleNetwork* net_ptr) { m_network_ptr = net_ptr; }
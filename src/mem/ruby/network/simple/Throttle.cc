@@ -123,6 +123,8 @@ Throttle::operateVnet(int vnet, int &bw_remaining, bool &schedule_wakeup,
 
             // Count the message
             m_msg_counts[net_msg_ptr->getMessageSize()][vnet]++;
+            m_msg_bytes[net_msg_ptr->getMessageSize()][vnet] +=
+                Network::getMessageSizeBytes(net_msg_ptr);
             DPRINTF(RubyNetwork, "%s\n", *out);
         }
 
@@ -214,13 +216,11 @@ Throttle::regStats(string parent)
             .flags(Stats::nozero)
             ;
         m_msg_bytes[(unsigned int) type]
+            .init(Network::getNumberOfVirtualNetworks())
             .name(parent + csprintf(".throttle%i", m_node) + ".msg_bytes." +
                     MessageSizeType_to_string(type))
             .flags(Stats::nozero)
             ;
-
-        m_msg_bytes[(unsigned int) type] = m_msg_counts[type] * Stats::constant(
-                Network::MessageSizeType_to_int(type));
     }
 }
 
@@ -250,7 +250,7 @@ network_message_to_size(Message *net_msg_ptr)
 {
     assert(net_msg_ptr != NULL);
 
-    int size = Network::MessageSizeType_to_int(net_msg_ptr->getMessageSize());
+    int size = Network::getMessageSizeBytes(net_msg_ptr);
     size *=  MESSAGE_SIZE_MULTIPLIER;
 
     // Artificially increase the size of broadcast messages
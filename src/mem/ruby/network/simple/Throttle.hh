@@ -69,6 +69,8 @@ class Throttle : public Consumer
     { return m_link_utilization; }
     const Stats::Vector & getMsgCount(unsigned int type) const
     { return m_msg_counts[type]; }
+    const Stats::Vector & getMsgBytes(unsigned int type) const
+    { return m_msg_bytes[type]; }
 
     int getLinkBandwidth() const
     { return m_endpoint_bandwidth * m_link_bandwidth_multiplier; }
@@ -108,7 +110,7 @@ class Throttle : public Consumer
     // Statistical variables
     Stats::Scalar m_link_utilization;
     Stats::Vector m_msg_counts[MessageSizeType_NUM];
-    Stats::Formula m_msg_bytes[MessageSizeType_NUM];
+    Stats::Vector m_msg_bytes[MessageSizeType_NUM];
 
     double m_link_utilization_proxy;
 };
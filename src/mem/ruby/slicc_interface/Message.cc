@@ -0,0 +1,58 @@
+#include "mem/ruby/slicc_interface/Message.hh"
+
+#include <new>
+
+namespace
+{
+
+// Message storage is recycled through one free list per size class,
+// a freed block holds the link to the next free block of its class
+const size_t sizeClassBytes = 16;
+const size_t numSizeClasses = 64;
+
+struct FreeBlock
+{
+    FreeBlock *next;
+};
+
+__thread FreeBlock *freeLists[numSizeClasses];
+
+inline size_t
+sizeClass(size_t size)
+{
+    return (size + sizeClassBytes - 1) / sizeClassBytes;
+}
+
+} // anonymous namespace
+
+void *
+Message::operator new(size_t size)
+{
+    size_t size_class = sizeClass(size);
+    if (size_class >= numSizeClasses)
+        return ::operator new(size);
+
+    FreeBlock *block = freeLists[size_class];
+    if (block) {
+        freeLists[size_class] = block->next;
+        return block;
+    }
+    return ::operator new(size_class * sizeClassBytes);
+}
+
+void
+Message::operator delete(void *ptr, size_t size)
+{
+    if (!ptr)
+        return;
+
+    size_t size_class = sizeClass(size);
+    if (size_class >= numSizeClasses) {
+        ::operator delete(ptr);
+        return;
+    }
+
+    FreeBlock *block = static_cast<FreeBlock *>(ptr);
+    block->next = freeLists[size_class];
+    freeLists[size_class] = block;
+}
@@ -33,14 +33,20 @@
 #include <memory>
 #include <stack>
 
+#include "base/refcnt.hh"
 #include "mem/packet.hh"
 #include "mem/protocol/MessageSizeType.hh"
 #include "mem/ruby/common/NetDest.hh"
 
 class Message;
-typedef std::shared_ptr<Message> MsgPtr;
+typedef RefCountingPtr<Message> MsgPtr;
 
-class Message
+/**
+ * Messages are reference counted intrusively, so handing a message from
+ * one buffer to the next only touches its counter, and their storage is
+ * recycled through per-size free lists instead of going back to the heap.
+ */
+class Message : public RefCounted
 {
   public:
     Message(Tick curTime)
@@ -49,8 +55,10 @@ class Message
           m_DelayedTicks(0), m_msg_counter(0)
     { }
 
+    // the copy starts out unreferenced
     Message(const Message &other)
-        : m_time(other.m_time),
+        : RefCounted(),
+          m_time(other.m_time),
           m_LastEnqueueTime(other.m_LastEnqueueTime),
           m_DelayedTicks(other.m_DelayedTicks),
           m_msg_counter(other.m_msg_counter)
@@ -58,6 +66,9 @@ class Message
 
     virtual ~Message() { }
 
+    static void *operator new(size_t size);
+    static void operator delete(void *ptr, size_t size);
+
     virtual MsgPtr clone() const = 0;
     virtual void print(std::ostream& out) const = 0;
 
@@ -66,6 +77,10 @@ class Message
     virtual MessageSizeType& getMessageSize()
     { panic("MessageSizeType() called on wrong message!"); }
 
+    //! Bytes carried on top of the size of the MessageSizeType, for
+    //! messages whose payload doesn't fit any of the fixed sizes.
+    virtual uint32_t getExtraDataBytes() const { return 0; }
+
     /**
      * The two functions below are used for reading / writing the message
      * functionally. The methods return true if the address in the packet
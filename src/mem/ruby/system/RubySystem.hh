@@ -91,6 +91,7 @@ class RubySystem : public ClockedObject
     bool functionalWrite(Packet *ptr);
 
     void registerNetwork(Network*);
+    Network *getNetwork() const { return m_network; }
     void registerAbstractController(AbstractController*);
 
     bool eventQueueEmpty() { return eventq->empty(); }
@@ -8,6 +8,15 @@ class PMMU(RubyController):
     cxx_header = "mem/spm/pmmu.hh"
 #    version = Param.Int("");
     page_size_bytes = Param.Int(512,"Size of a SPM page in bytes")
+    att_capacity = Param.Unsigned(0, "Max number of ATT entries (0 = unbounded)")
+    att_lookaside_entries = Param.Unsigned(16,
+        "Entries in the ATT lookaside buffer, a power of 2 (0 = disabled)")
+    request_latency = Param.Cycles(1,
+        "Latency of an ATT translation in atomic mode")
+    max_streams = Param.Unsigned(4,
+        "Max number of ranges streamed through the SPM at once (SPM_STREAM)")
+    hop_latency = Param.Cycles(2,
+        "Latency of one network hop, to estimate remote accesses in atomic mode")
     ruby_system = Param.RubySystem(NULL, "")
     responseFromSPM = Param.MessageBuffer("");
     responseToSPM = Param.MessageBuffer("");
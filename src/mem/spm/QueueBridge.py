@@ -0,0 +1,12 @@
+from m5.params import *
+from MemObject import MemObject
+
+class QueueBridge(MemObject):
+    type = 'QueueBridge'
+    cxx_header = "mem/spm/queue_bridge.hh"
+    slave = SlavePort('Slave port, in the event queue of the bridge')
+    master = MasterPort('Master port, in the event queue of the memory')
+    master_eventq_index = Param.UInt32(0,
+        "Event queue of the objects on the master side")
+    delay = Param.Latency('0ns', "The latency of the bridge, at least one "
+                          "simulation quantum when crossing event queues")
@@ -0,0 +1,71 @@
+#include "mem/spm/SPMPacketExtension.hh"
+
+#include "sim/eventq.hh"
+
+SPMPacketExtensionPool::SPMPacketExtensionPool()
+    : freeList(nullptr),
+      numAllocated(0),
+      numFree(0)
+{
+}
+
+SPMPacketExtensionPool::~SPMPacketExtensionPool()
+{
+    // extensions still attached to packets are lost with their packets
+    while (freeList) {
+        SPMPacketExtension *ext = freeList;
+        freeList = ext->nextFree;
+        delete ext;
+    }
+}
+
+SPMPacketExtension &
+SPMPacketExtensionPool::attach(PacketPtr pkt)
+{
+    if (pkt->spmExt) {
+        return *pkt->spmExt;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+    if (inParallelMode)
+        lock.lock();
+
+    SPMPacketExtension *ext;
+    if (freeList) {
+        ext = freeList;
+        freeList = ext->nextFree;
+        numFree--;
+
+        ext->spmInfo = SPMPktInfo();
+        ext->govInfo.reset();
+        ext->origCmd = MemCmd();
+    }
+    else {
+        ext = new SPMPacketExtension(this);
+        numAllocated++;
+    }
+
+    ext->nextFree = nullptr;
+    pkt->spmExt = ext;
+    return *ext;
+}
+
+void
+SPMPacketExtensionPool::release(SPMPacketExtension *ext)
+{
+    assert(ext->pool == this);
+
+    std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+    if (inParallelMode)
+        lock.lock();
+
+    ext->nextFree = freeList;
+    freeList = ext;
+    numFree++;
+}
+
+void
+releaseSPMExtension(SPMPacketExtension *ext)
+{
+    ext->pool->release(ext);
+}
@@ -0,0 +1,93 @@
+#ifndef __SPM_PACKET_EXTENSION_HH__
+#define __SPM_PACKET_EXTENSION_HH__
+
+#include <cassert>
+#include <mutex>
+
+#include "mem/packet.hh"
+#include "mem/spm/SPMPktInfo.hh"
+#include "mem/spm/governor/GOVPktInfo.hh"
+
+class SPMPacketExtensionPool;
+
+/**
+ * SPM and governor metadata of a packet. Packets only get one once a
+ * PMMU handles them, so packets of the rest of the memory system don't
+ * pay for it. The extension comes from the pool of that PMMU and goes
+ * back to it when the packet is deleted.
+ */
+class SPMPacketExtension
+{
+  public:
+    SPMPktInfo spmInfo;
+    GOVPktInfo govInfo;
+    MemCmd origCmd;
+
+  private:
+    friend class SPMPacketExtensionPool;
+
+    SPMPacketExtension(SPMPacketExtensionPool *_pool)
+        : pool(_pool), nextFree(nullptr) {}
+
+    SPMPacketExtensionPool *pool;
+    SPMPacketExtension *nextFree;
+
+    friend void releaseSPMExtension(SPMPacketExtension *ext);
+};
+
+/**
+ * Free list of the extensions of one PMMU. Extensions are never freed
+ * while the pool lives, so the number of allocations is bounded by the
+ * number of packets in flight. Packets of a PMMU may be deleted by nodes
+ * in other event queues, so the list is locked in parallel simulations.
+ */
+class SPMPacketExtensionPool
+{
+  public:
+    SPMPacketExtensionPool();
+    ~SPMPacketExtensionPool();
+
+    /** Gives pkt a cleared extension, unless it already carries one. */
+    SPMPacketExtension &attach(PacketPtr pkt);
+
+    void release(SPMPacketExtension *ext);
+
+    unsigned getNumAllocated() const { return numAllocated; }
+    unsigned getNumFree() const { return numFree; }
+
+  private:
+    SPMPacketExtension *freeList;
+    unsigned numAllocated;
+    unsigned numFree;
+    std::mutex mutex;
+};
+
+inline SPMPktInfo &
+Packet::spmInfo()
+{
+    assert(spmExt);
+    return spmExt->spmInfo;
+}
+
+inline GOVPktInfo &
+Packet::govInfo()
+{
+    assert(spmExt);
+    return spmExt->govInfo;
+}
+
+inline void
+Packet::saveCmd()
+{
+    assert(spmExt);
+    spmExt->origCmd = cmd;
+}
+
+inline void
+Packet::retrieveCmd()
+{
+    assert(spmExt);
+    cmd = spmExt->origCmd;
+}
+
+#endif // __SPM_PACKET_EXTENSION_HH__
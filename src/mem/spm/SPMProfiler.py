@@ -0,0 +1,10 @@
+from m5.params import *
+from m5.SimObject import SimObject
+
+class SPMProfiler(SimObject):
+    type = 'SPMProfiler'
+    cxx_header = "mem/spm/spm_profiler.hh"
+    spms = VectorParam.SPM("SPMs whose cpu accesses are profiled")
+    epoch = Param.Latency('10us', "Length of a profiling epoch")
+    profile_file = Param.String("", "Profile file, in the output directory "
+                                "(default: <name>.prof.gz)")
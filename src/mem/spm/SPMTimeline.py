@@ -0,0 +1,11 @@
+from m5.params import *
+from m5.SimObject import SimObject
+
+class SPMTimeline(SimObject):
+    type = 'SPMTimeline'
+    cxx_header = "mem/spm/spm_timeline.hh"
+    spms = VectorParam.SPM("SPMs whose occupancy and traffic are sampled")
+    epoch = Param.Latency('10us', "Time between two samples")
+    binary = Param.Bool(False, "Write a binary file instead of a CSV one")
+    timeline_file = Param.String("", "Timeline file, in the output directory "
+                                 "(default: <name>.csv or <name>.bin)")
@@ -6,15 +6,14 @@
 
 #define SYNC_ROI() wakeCPU(0xFFFFFFFFFFFFFFFF);
 
-static inline void SPM_ALLOC32(uint64_t start_v_address,
-                               uint64_t end_v_address,
-                               AllocationModes alloc_mode,
-                               //only used for explicitly addressed SPMs
-                               uint64_t start_spm_address,
-                               uint64_t shared_data,
-                               DataImportance d_importance,
-                               ThreadPriority app_priority,
-                               Approximation approximation)
+// identifies an asynchronous request, see SPM_ALLOC_ASYNC/SPM_FREE_ASYNC
+typedef uint64_t SPMTicket;
+
+static inline uint64_t spm_alloc_modes(AllocationModes alloc_mode,
+                                       uint64_t shared_data,
+                                       DataImportance d_importance,
+                                       ThreadPriority app_priority,
+                                       Approximation approximation)
 {
     uint64_t modes = 0x0000000000000000;
     modes = modes | (uint64_t)approximation;
@@ -22,7 +21,14 @@ static inline void SPM_ALLOC32(uint64_t start_v_address,
     modes = modes | (uint64_t)alloc_mode << 12;
     modes = modes | (uint64_t)d_importance << 16;
     modes = modes | (uint64_t)app_priority << 20;
+    return modes;
+}
 
+static inline SPMTicket spm_alloc32(uint64_t start_v_address,
+                                    uint64_t end_v_address,
+                                    uint64_t modes,
+                                    uint64_t start_spm_address)
+{
     uint64_t encoded_start =  ( 0x0000000000000000 | start_v_address) |
                               ( modes & 0xFFFFFFFF00000000);
     uint64_t encoded_end   =  ( 0x0000000000000000 | end_v_address)   |
@@ -34,7 +40,38 @@ static inline void SPM_ALLOC32(uint64_t start_v_address,
      */
     start_spm_address = (uint64_t)start_spm_address << 32;
 
-    m5_spm_alloc(encoded_start, encoded_end, start_spm_address);
+    return m5_spm_alloc(encoded_start, encoded_end, start_spm_address);
+}
+
+static inline SPMTicket spm_alloc64(uint64_t start_v_address,
+                                    uint64_t end_v_address,
+                                    uint64_t modes,
+                                    uint64_t start_spm_address)
+{
+    /*
+     * we limit the physically addressable SPM space to 4GB, dedicating
+     * the top 32b of mode to the address
+     */
+
+    modes = modes | (uint64_t)start_spm_address << 32;
+
+    return m5_spm_alloc(start_v_address, end_v_address, modes);
+}
+
+static inline void SPM_ALLOC32(uint64_t start_v_address,
+                               uint64_t end_v_address,
+                               AllocationModes alloc_mode,
+                               //only used for explicitly addressed SPMs
+                               uint64_t start_spm_address,
+                               uint64_t shared_data,
+                               DataImportance d_importance,
+                               ThreadPriority app_priority,
+                               Approximation approximation)
+{
+    uint64_t modes = spm_alloc_modes(alloc_mode, shared_data, d_importance,
+                                     app_priority, approximation);
+
+    spm_alloc32(start_v_address, end_v_address, modes, start_spm_address);
 }
 
 static inline void SPM_ALLOC64(uint64_t start_v_address,
@@ -47,47 +84,234 @@ static inline void SPM_ALLOC64(uint64_t start_v_address,
                                ThreadPriority app_priority,
                                Approximation approximation)
 {
-    uint64_t modes = 0x0000000000000000;
-    modes = modes | (uint64_t)approximation;
-    modes = modes | (uint64_t)shared_data << 8;
-    modes = modes | (uint64_t)alloc_mode << 12;
-    modes = modes | (uint64_t)d_importance << 16;
-    modes = modes | (uint64_t)app_priority << 20;
-    /*
-     * we limit the physically addressable SPM space to 4GB, dedicating
-     * the top 32b of mode to the address
-     */
+    uint64_t modes = spm_alloc_modes(alloc_mode, shared_data, d_importance,
+                                     app_priority, approximation);
 
-    modes = modes | (uint64_t)start_spm_address << 32;
+    spm_alloc64(start_v_address, end_v_address, modes, start_spm_address);
+}
+
+/*
+ * Non-blocking variants: the core keeps running (and keeps accessing the
+ * pages already in the SPM) while the pages are being transferred. The
+ * range must not be touched before its ticket completes.
+ */
+static inline SPMTicket SPM_ALLOC_ASYNC32(uint64_t start_v_address,
+                                          uint64_t end_v_address,
+                                          AllocationModes alloc_mode,
+                                          //only used for explicitly addressed SPMs
+                                          uint64_t start_spm_address,
+                                          uint64_t shared_data,
+                                          DataImportance d_importance,
+                                          ThreadPriority app_priority,
+                                          Approximation approximation)
+{
+    uint64_t modes = spm_alloc_modes(alloc_mode, shared_data, d_importance,
+                                     app_priority, approximation);
 
-    m5_spm_alloc(start_v_address, end_v_address, modes);
+    return spm_alloc32(start_v_address, end_v_address,
+                       modes | SPM_ASYNC_REQUEST, start_spm_address);
+}
+
+static inline SPMTicket SPM_ALLOC_ASYNC64(uint64_t start_v_address,
+                                          uint64_t end_v_address,
+                                          AllocationModes alloc_mode,
+                                          //only used for explicitly addressed SPMs
+                                          uint64_t start_spm_address,
+                                          uint64_t shared_data,
+                                          DataImportance d_importance,
+                                          ThreadPriority app_priority,
+                                          Approximation approximation)
+{
+    uint64_t modes = spm_alloc_modes(alloc_mode, shared_data, d_importance,
+                                     app_priority, approximation);
+
+    return spm_alloc64(start_v_address, end_v_address,
+                       modes | SPM_ASYNC_REQUEST, start_spm_address);
 }
 
 /*************************************************************/
 
+static inline SPMTicket spm_free32(uint64_t start_v_address,
+                                   uint64_t end_v_address,
+                                   uint64_t modes)
+{
+    uint64_t encoded_start =  ( 0x0000000000000000 | start_v_address) |
+                              ( modes & 0xFFFFFFFF00000000);
+    uint64_t encoded_end   =  ( 0x0000000000000000 | end_v_address)   |
+                              ( modes & 0x00000000FFFFFFFF) << 32;
+
+    return m5_spm_free(encoded_start, encoded_end, 0);
+}
+
 static inline void SPM_FREE32(uint64_t start_v_address,
                               uint64_t end_v_address,
                               DeallocationModes dealloc_mode)
+{
+    spm_free32(start_v_address, end_v_address, (uint64_t)dealloc_mode);
+}
+
+static inline void SPM_FREE64(uint64_t start_v_address,
+                              uint64_t end_v_address,
+                              DeallocationModes dealloc_mode)
+{
+    m5_spm_free(start_v_address, end_v_address, (uint64_t)dealloc_mode);
+}
+
+static inline SPMTicket SPM_FREE_ASYNC32(uint64_t start_v_address,
+                                         uint64_t end_v_address,
+                                         DeallocationModes dealloc_mode)
+{
+    return spm_free32(start_v_address, end_v_address,
+                      (uint64_t)dealloc_mode | SPM_ASYNC_REQUEST);
+}
+
+static inline SPMTicket SPM_FREE_ASYNC64(uint64_t start_v_address,
+                                         uint64_t end_v_address,
+                                         DeallocationModes dealloc_mode)
+{
+    return m5_spm_free(start_v_address, end_v_address,
+                       (uint64_t)dealloc_mode | SPM_ASYNC_REQUEST);
+}
+
+/*************************************************************/
+
+/*
+ * Streams: the pmmu watches the core walk the range page by page, and
+ * keeps the next depth pages on the spm ahead of it. Pages left behind
+ * are freed with dealloc_mode. Registering a stream returns non-zero if
+ * the pmmu had room for it; a depth of 0 ends the stream covering
+ * start_v_address, and its pages are freed before the call returns.
+ */
+static inline uint64_t spm_stream_modes(uint64_t depth,
+                                        AllocationModes alloc_mode,
+                                        DeallocationModes dealloc_mode)
 {
     uint64_t modes = 0x0000000000000000;
     modes = modes | (uint64_t)dealloc_mode;
+    modes = modes | (uint64_t)alloc_mode << 12;
+    modes = modes | depth << 32;
+    return modes;
+}
 
+static inline int SPM_STREAM32(uint64_t start_v_address,
+                               uint64_t end_v_address,
+                               uint64_t depth,
+                               AllocationModes alloc_mode,
+                               DeallocationModes dealloc_mode)
+{
+    uint64_t modes = spm_stream_modes(depth, alloc_mode, dealloc_mode);
     uint64_t encoded_start =  ( 0x0000000000000000 | start_v_address) |
                               ( modes & 0xFFFFFFFF00000000);
     uint64_t encoded_end   =  ( 0x0000000000000000 | end_v_address)   |
                               ( modes & 0x00000000FFFFFFFF) << 32;
 
-    m5_spm_free(encoded_start, encoded_end, 0);
+    return m5_spm_stream(encoded_start, encoded_end, 0) != 0;
 }
 
-static inline void SPM_FREE64(uint64_t start_v_address,
-                              uint64_t end_v_address,
-                              DeallocationModes dealloc_mode)
+static inline int SPM_STREAM64(uint64_t start_v_address,
+                               uint64_t end_v_address,
+                               uint64_t depth,
+                               AllocationModes alloc_mode,
+                               DeallocationModes dealloc_mode)
 {
-    uint64_t modes = 0x0000000000000000;
-    modes = modes | (uint64_t)dealloc_mode;
+    uint64_t modes = spm_stream_modes(depth, alloc_mode, dealloc_mode);
+
+    return m5_spm_stream(start_v_address, end_v_address, modes) != 0;
+}
+
+static inline void SPM_STREAM_END32(uint64_t start_v_address,
+                                    uint64_t end_v_address)
+{
+    SPM_STREAM32(start_v_address, end_v_address, 0, COPY, WRITE_BACK);
+}
 
-    m5_spm_free(start_v_address, end_v_address, modes);
+static inline void SPM_STREAM_END64(uint64_t start_v_address,
+                                    uint64_t end_v_address)
+{
+    SPM_STREAM64(start_v_address, end_v_address, 0, COPY, WRITE_BACK);
+}
+
+/*************************************************************/
+
+/*
+ * Producer/consumer transfers between the spms of two nodes, over the
+ * network and without going through memory. SPM_HANDOFF gives the pages
+ * of the range the caller has on chip to the consumer node, and moves
+ * them to its spm if it has room; the caller must not touch the range
+ * afterwards. SPM_COPY leaves the caller its pages and gives the consumer
+ * a private copy on its spm, the caller must not write the range until
+ * the consumer got it. The consumer stalls while the pages move. Both
+ * return the number of pages transferred.
+ */
+static inline uint64_t spm_transfer32(uint64_t start_v_address,
+                                      uint64_t end_v_address,
+                                      uint64_t modes)
+{
+    uint64_t encoded_start =  ( 0x0000000000000000 | start_v_address) |
+                              ( modes & 0xFFFFFFFF00000000);
+    uint64_t encoded_end   =  ( 0x0000000000000000 | end_v_address)   |
+                              ( modes & 0x00000000FFFFFFFF) << 32;
+
+    return m5_spm_transfer(encoded_start, encoded_end, 0);
+}
+
+static inline uint64_t SPM_HANDOFF32(uint64_t start_v_address,
+                                     uint64_t end_v_address,
+                                     uint64_t consumer_node)
+{
+    return spm_transfer32(start_v_address, end_v_address,
+                          (uint64_t)HAND_OFF | consumer_node << 32);
+}
+
+static inline uint64_t SPM_HANDOFF64(uint64_t start_v_address,
+                                     uint64_t end_v_address,
+                                     uint64_t consumer_node)
+{
+    return m5_spm_transfer(start_v_address, end_v_address,
+                           (uint64_t)HAND_OFF | consumer_node << 32);
+}
+
+static inline uint64_t SPM_COPY32(uint64_t start_v_address,
+                                  uint64_t end_v_address,
+                                  uint64_t consumer_node)
+{
+    return spm_transfer32(start_v_address, end_v_address,
+                          (uint64_t)DUPLICATE | consumer_node << 32);
+}
+
+static inline uint64_t SPM_COPY64(uint64_t start_v_address,
+                                  uint64_t end_v_address,
+                                  uint64_t consumer_node)
+{
+    return m5_spm_transfer(start_v_address, end_v_address,
+                           (uint64_t)DUPLICATE | consumer_node << 32);
+}
+
+/*************************************************************/
+
+/*
+ * On a spm that shares its array with the L1 cache, gives it num_ways of
+ * the cache ways; the pages on the slots it gives back are written back
+ * to memory, and the core waits for the blocks evicted from the ways it
+ * takes. Returns the number of pages the spm holds afterwards, which is
+ * unchanged while the cache can't evict those blocks yet.
+ */
+static inline uint64_t SPM_RESIZE(uint64_t num_ways)
+{
+    return m5_spm_resize(num_ways);
+}
+
+/*************************************************************/
+
+// returns non-zero once every page of the ticket has been transferred
+static inline int SPM_TEST(SPMTicket ticket)
+{
+    return m5_spm_test(ticket) != 0;
+}
+
+static inline void SPM_WAIT(SPMTicket ticket)
+{
+    while (!SPM_TEST(ticket));
 }
 
 #endif /* SPM_API_H_ */
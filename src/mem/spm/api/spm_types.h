@@ -4,26 +4,54 @@
 #ifdef ARM32_ARCH
 #define SPM_ALLOC SPM_ALLOC32
 #define SPM_FREE SPM_FREE32
+#define SPM_ALLOC_ASYNC SPM_ALLOC_ASYNC32
+#define SPM_FREE_ASYNC SPM_FREE_ASYNC32
+#define SPM_STREAM SPM_STREAM32
+#define SPM_STREAM_END SPM_STREAM_END32
+#define SPM_HANDOFF SPM_HANDOFF32
+#define SPM_COPY SPM_COPY32
 #endif
 
 #ifdef ARM64_ARCH
 #define SPM_ALLOC SPM_ALLOC64
 #define SPM_FREE SPM_FREE64
+#define SPM_ALLOC_ASYNC SPM_ALLOC_ASYNC64
+#define SPM_FREE_ASYNC SPM_FREE_ASYNC64
+#define SPM_STREAM SPM_STREAM64
+#define SPM_STREAM_END SPM_STREAM_END64
+#define SPM_HANDOFF SPM_HANDOFF64
+#define SPM_COPY SPM_COPY64
 #endif
 
 #ifdef ALPHA_ARCH
 #define SPM_ALLOC SPM_ALLOC64
 #define SPM_FREE SPM_FREE64
+#define SPM_ALLOC_ASYNC SPM_ALLOC_ASYNC64
+#define SPM_FREE_ASYNC SPM_FREE_ASYNC64
+#define SPM_STREAM SPM_STREAM64
+#define SPM_STREAM_END SPM_STREAM_END64
+#define SPM_HANDOFF SPM_HANDOFF64
+#define SPM_COPY SPM_COPY64
 #endif
 
 #ifdef X86_ARCH
 #define SPM_ALLOC SPM_ALLOC64
 #define SPM_FREE SPM_FREE64
+#define SPM_ALLOC_ASYNC SPM_ALLOC_ASYNC64
+#define SPM_FREE_ASYNC SPM_FREE_ASYNC64
+#define SPM_STREAM SPM_STREAM64
+#define SPM_STREAM_END SPM_STREAM_END64
+#define SPM_HANDOFF SPM_HANDOFF64
+#define SPM_COPY SPM_COPY64
 #endif
 
 #define SHARED_DATA 1
 #define PRIVATE_DATA 0
 
+// mode bit asking for a non-blocking request, completion is then polled
+// with SPM_TEST/SPM_WAIT on the returned ticket
+#define SPM_ASYNC_REQUEST 0x0000000010000000
+
 typedef enum
 {
     CRITICAL = 0x00,
@@ -61,5 +89,12 @@ typedef enum
     NUM_DEALLOCATION_MODE
 } DeallocationModes;
 
+typedef enum
+{
+    HAND_OFF,
+    DUPLICATE,
+    NUM_TRANSFER_MODE
+} TransferModes;
+
 
 #endif /* SPM_TYPES_H_ */
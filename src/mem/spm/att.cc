@@ -1,49 +1,118 @@
 #include "mem/spm/att.hh"
+
+#include <unordered_map>
+
 #include "debug/PMMU.hh"
 #include "sim/system.hh"
 
-ATT::ATT()
+// annotations restored so far, by their address in the checkpoint
+static std::unordered_map<uint64_t, Annotations*> restoredAnnotations;
+
+void
+serializeAnnotations(CheckpointOut &cp, const Annotations *annotations)
 {
+    uint64_t id = reinterpret_cast<uintptr_t>(annotations);
+    int approximation = annotations->approximation;
+    bool shared_data = annotations->shared_data;
+    int alloc_mode = annotations->alloc_mode;
+    int dealloc_mode = annotations->dealloc_mode;
+    int data_importance = annotations->data_importance;
+    int app_priority = annotations->app_priority;
+    uint32_t spm_addr = annotations->spm_addr;
+
+    SERIALIZE_SCALAR(id);
+    SERIALIZE_SCALAR(approximation);
+    SERIALIZE_SCALAR(shared_data);
+    SERIALIZE_SCALAR(alloc_mode);
+    SERIALIZE_SCALAR(dealloc_mode);
+    SERIALIZE_SCALAR(data_importance);
+    SERIALIZE_SCALAR(app_priority);
+    SERIALIZE_SCALAR(spm_addr);
 }
 
-ATT::~ATT()
+Annotations *
+unserializeAnnotations(CheckpointIn &cp)
 {
-    std::map<Addr,ATTEntry*>::iterator it;
-    for (it = translation_table.begin(); it != translation_table.end(); it++) {
-        delete(it->second);
+    uint64_t id;
+    UNSERIALIZE_SCALAR(id);
+
+    Annotations *&annotations = restoredAnnotations[id];
+    if (annotations) {
+        return annotations;
     }
+
+    int approximation, alloc_mode, dealloc_mode, data_importance, app_priority;
+    annotations = new Annotations();
+    UNSERIALIZE_SCALAR(approximation);
+    paramIn(cp, "shared_data", annotations->shared_data);
+    UNSERIALIZE_SCALAR(alloc_mode);
+    UNSERIALIZE_SCALAR(dealloc_mode);
+    UNSERIALIZE_SCALAR(data_importance);
+    UNSERIALIZE_SCALAR(app_priority);
+    paramIn(cp, "spm_addr", annotations->spm_addr);
+
+    annotations->approximation = static_cast<Approximation>(approximation);
+    annotations->alloc_mode = static_cast<AllocationModes>(alloc_mode);
+    annotations->dealloc_mode = static_cast<DeallocationModes>(dealloc_mode);
+    annotations->data_importance = static_cast<DataImportance>(data_importance);
+    annotations->app_priority = static_cast<ThreadPriority>(app_priority);
+    return annotations;
+}
+
+void
+clearRestoredAnnotations()
+{
+    restoredAnnotations.clear();
+}
+
+ATT::ATT(unsigned int _table_capacity)
+    : table_capacity(_table_capacity),
+      generation(0)
+{
+}
+
+ATT::~ATT()
+{
     translation_table.clear();
+    reverse_translation_table.clear();
+}
+
+ATTEntry*
+ATT::lookup(uint64_t asid, Addr v_page_addr)
+{
+    return translation_table.find({asid, v_page_addr});
 }
 
 bool
-ATT::hasMapping(Addr v_page_addr)
+ATT::hasMapping(uint64_t asid, Addr v_page_addr)
 {
-    return (translation_table.find(v_page_addr) != translation_table.end());
+    return (lookup(asid, v_page_addr) != NULL);
 }
 
 ATTEntry*
-ATT::getMapping(Addr v_page_addr)
+ATT::getMapping(uint64_t asid, Addr v_page_addr)
 {
-    if (hasMapping (v_page_addr))
-        return translation_table.at(v_page_addr);
-    else
-        return NULL;
+    return lookup(asid, v_page_addr);
 }
 
 ATTEntry*
 ATT::getMapping(MachineID destination_node, Addr spm_slot_addr)
 {
-    return getMapping(slot2Addr(destination_node, spm_slot_addr));
+    ReverseATTEntry *entry = findReverseMapping(destination_node, spm_slot_addr);
+    if (!entry)
+        panic("ATT entry can not be mapped to a virtual address\n");
+
+    return translation_table.find(entry->mapping);
 }
 
 bool
-ATT::isHit(Addr v_page_addr)
+ATT::isHit(uint64_t asid, Addr v_page_addr)
 {
-    if (!hasMapping(v_page_addr)) {
+    ATTEntry *mapping = lookup(asid, v_page_addr);
+    if (!mapping) {
         return false;
     }
     else {
-        ATTEntry *mapping = getMapping(v_page_addr);
         bool hit = mapping->data_valid;
         if (hit) {
             mapping->num_accesses++;
@@ -52,46 +121,54 @@ ATT::isHit(Addr v_page_addr)
     }
 }
 
-bool
-ATT::addMapping(Addr v_page_addr, MachineID destination_node, Addr spm_slot_addr, Annotations *annotations)
+ATT::AddResult
+ATT::addMapping(uint64_t asid, Addr v_page_addr, MachineID destination_node,
+                Addr spm_slot_addr, Annotations *annotations)
 {
-    ATTEntry *new_entry;
+    ATTKey key = {asid, v_page_addr};
+    ATTEntry *new_entry = translation_table.find(key);
 
-    if (hasMapping(v_page_addr)) {
-        new_entry = getMapping(v_page_addr);
+    if (new_entry) {
         new_entry->num_owners++;
-        return false;
+        return ATT_Exists;
     }
     else if (!isATTFull()) {
-        new_entry = new ATTEntry;
+        new_entry = translation_table.insert(key);
+        new_entry->asid = asid;
+        new_entry->v_page_addr = v_page_addr;
         new_entry->destination_node = destination_node;
         new_entry->spm_slot_addr = spm_slot_addr;
         new_entry->num_owners = 1;
         new_entry->num_accesses = 0;
         new_entry->data_valid = false;
-        *new_entry->annotations = *annotations;
-        translation_table[v_page_addr] = new_entry;
-        reverse_translation_table[new_entry] = v_page_addr;
-        return true;
+        new_entry->alias = false;
+        new_entry->read_only = false;
+        // freed in SPMPage, if unallocated in PMMU
+        new_entry->annotations = new Annotations(*annotations);
+        addReverseMapping(destination_node, spm_slot_addr, key);
+        generation++;
+        return ATT_Added;
     }
     else {
-        return false;
+        return ATT_Full;
     }
 }
 
-bool
+ATT::AddResult
 ATT::addMapping(GOVRequest *gov_request, HostInfo *host_info, int page_index)
 {
-    return addMapping(gov_request->getNthPageStartAddr(Unserved_Aligned, page_index),
+    return addMapping(gov_request->getASID(),
+                      gov_request->getNthPageStartAddr(Unserved_Aligned, page_index),
                       host_info->getHostMachineID(),
                       host_info->getSPMaddress() + page_index * gov_request->getPageSizeBytes(),
                       gov_request->getAnnotations());
 }
 
 bool
-ATT::removeMapping(Addr v_page_addr)
+ATT::removeMapping(uint64_t asid, Addr v_page_addr)
 {
-    ATTEntry *ret = getMapping(v_page_addr);
+    ATTEntry *ret = getMapping(asid, v_page_addr);
+    assert(ret);
 
     if (ret->num_owners > 1) {
         ret->num_owners--;
@@ -99,9 +176,9 @@ ATT::removeMapping(Addr v_page_addr)
     }
     else {
         assert (ret->num_owners == 1);
-        reverse_translation_table.erase(ret);
-        translation_table.erase(v_page_addr);
-        delete ret;
+        removeReverseMapping(ret->destination_node, ret->spm_slot_addr, ret->key());
+        translation_table.erase(ret);
+        generation++;
         return true;
     }
 }
@@ -109,21 +186,74 @@ ATT::removeMapping(Addr v_page_addr)
 bool
 ATT::removeMapping(GOVRequest *gov_request, int page_index)
 {
-    return removeMapping(gov_request->getNthPageStartAddr(Unserved_Aligned, page_index));
+    return removeMapping(gov_request->getASID(),
+                         gov_request->getNthPageStartAddr(Unserved_Aligned, page_index));
+}
+
+bool
+ATT::transferMapping(uint64_t asid, Addr v_page_addr, ATT *new_att)
+{
+    ATTEntry *entry = getMapping(asid, v_page_addr);
+    assert(entry);
+
+    if (entry->num_owners > 1 || new_att->hasMapping(asid, v_page_addr) ||
+        new_att->isATTFull()) {
+        return false;
+    }
+
+    ATTEntry *new_entry = new_att->translation_table.insert(entry->key());
+    *new_entry = *entry;
+    new_entry->num_accesses = 0;
+    new_att->addReverseMapping(entry->destination_node, entry->spm_slot_addr,
+                               entry->key());
+    new_att->generation++;
+
+    removeReverseMapping(entry->destination_node, entry->spm_slot_addr,
+                         entry->key());
+    translation_table.erase(entry);
+    generation++;
+    return true;
+}
+
+void
+ATT::addReverseMapping(MachineID destination_node, Addr spm_slot_addr,
+                       const ATTKey &mapping)
+{
+    SPMSlotKey slot = {destination_node.num, spm_slot_addr};
+    ReverseATTEntry *entry = reverse_translation_table.find(slot);
+    if (!entry) {
+        entry = reverse_translation_table.insert(slot);
+        entry->slot = slot;
+        entry->occupied = true;
+    }
+    entry->mapping = mapping;
+}
+
+ReverseATTEntry*
+ATT::findReverseMapping(MachineID destination_node, Addr spm_slot_addr)
+{
+    SPMSlotKey slot = {destination_node.num, spm_slot_addr};
+    return reverse_translation_table.find(slot);
+}
+
+void
+ATT::removeReverseMapping(MachineID destination_node, Addr spm_slot_addr,
+                          const ATTKey &mapping)
+{
+    // the slot may have been handed to another address space meanwhile
+    ReverseATTEntry *entry = findReverseMapping(destination_node, spm_slot_addr);
+    if (entry && entry->mapping == mapping) {
+        reverse_translation_table.erase(entry);
+    }
 }
 
 Addr
 ATT::slot2Addr(MachineID destination_node, Addr spm_slot_addr)
 {
-    ATTEntry search_entry;
-    search_entry.destination_node = destination_node;
-    search_entry.spm_slot_addr = spm_slot_addr;
+    ReverseATTEntry *entry = findReverseMapping(destination_node, spm_slot_addr);
 
-    for(std::map<ATTEntry*, Addr >::const_iterator it = reverse_translation_table.begin();
-        it != reverse_translation_table.end(); ++it) {
-        if (*it->first == search_entry) {
-            return it->second;
-        }
+    if (entry) {
+        return entry->mapping.v_page_addr;
     }
 
     panic("ATT entry can not be mapped to a virtual address\n");
@@ -148,12 +278,16 @@ ATT::isATTEntryValid(ATTEntry *mapping)
 }
 
 ATTEntry*
-ATT::changeMapping(Addr v_page_addr, MachineID new_destination_node, Addr new_spm_slot_addr)
+ATT::changeMapping(uint64_t asid, Addr v_page_addr,
+                   MachineID new_destination_node, Addr new_spm_slot_addr)
 {
-    if (hasMapping(v_page_addr)) {
-        ATTEntry* mapping = getMapping(v_page_addr);
+    ATTEntry* mapping = lookup(asid, v_page_addr);
+    if (mapping) {
+        removeReverseMapping(mapping->destination_node, mapping->spm_slot_addr,
+                             mapping->key());
         mapping->destination_node = new_destination_node;
         mapping->spm_slot_addr = new_spm_slot_addr;
+        addReverseMapping(new_destination_node, new_spm_slot_addr, mapping->key());
         return mapping;
     }
     else {
@@ -165,7 +299,12 @@ ATTEntry*
 ATT::changeMapping(MachineID destination_node, Addr spm_slot_addr,
                    MachineID new_destination_node, Addr new_spm_slot_addr)
 {
-    return changeMapping(slot2Addr(destination_node, spm_slot_addr),
+    ReverseATTEntry *entry = findReverseMapping(destination_node, spm_slot_addr);
+    if (!entry)
+        panic("ATT entry can not be mapped to a virtual address\n");
+
+    ATTKey key = entry->mapping;
+    return changeMapping(key.asid, key.v_page_addr,
                          new_destination_node, new_spm_slot_addr);
 }
 
@@ -178,25 +317,199 @@ ATT::getTableSize()
 bool
 ATT::isATTFull()
 {
-    return getTableSize() >= table_capacity;
+    return table_capacity && getTableSize() >= table_capacity;
+}
+
+int
+ATT::invalidateASID(uint64_t asid)
+{
+    // collect first, erasing shifts entries around underneath the walk
+    std::vector<Addr> victims;
+    forEachMapping([asid, &victims](const ATTEntry &entry) {
+        if (entry.asid == asid)
+            victims.push_back(entry.v_page_addr);
+    });
+
+    for (Addr v_page_addr : victims) {
+        ATTEntry *entry = lookup(asid, v_page_addr);
+        removeReverseMapping(entry->destination_node, entry->spm_slot_addr,
+                             entry->key());
+        translation_table.erase(entry);
+    }
+
+    if (!victims.empty())
+        generation++;
+
+    DPRINTF(ATTMap, "Invalidated %d ATT mappings of address space %d\n",
+            victims.size(), asid);
+    return victims.size();
 }
 
 void
-ATT::invalidateATT()
+ATT::serialize(CheckpointOut &cp) const
+{
+    unsigned num_entries = 0;
+    for (auto &entry : translation_table.getSlots()) {
+        if (!entry.isOccupied())
+            continue;
+
+        ScopedCheckpointSection sec(cp, csprintf("entry%d", num_entries++));
+        paramOut(cp, "asid", entry.asid);
+        paramOut(cp, "v_page_addr", entry.v_page_addr);
+        paramOut(cp, "destination_node", entry.destination_node.num);
+        paramOut(cp, "spm_slot_addr", entry.spm_slot_addr);
+        paramOut(cp, "num_owners", entry.num_owners);
+        paramOut(cp, "num_accesses", entry.num_accesses);
+        paramOut(cp, "data_valid", entry.data_valid);
+        paramOut(cp, "alias", entry.alias);
+        paramOut(cp, "read_only", entry.read_only);
+        paramOut(cp, "has_annotations", entry.annotations != nullptr);
+        if (entry.annotations) {
+            ScopedCheckpointSection sec(cp, "annotations");
+            serializeAnnotations(cp, entry.annotations);
+        }
+    }
+    SERIALIZE_SCALAR(num_entries);
+
+    unsigned num_reverse_entries = 0;
+    for (auto &entry : reverse_translation_table.getSlots()) {
+        if (!entry.isOccupied())
+            continue;
+
+        ScopedCheckpointSection sec(cp, csprintf("reverse%d", num_reverse_entries++));
+        paramOut(cp, "node", entry.slot.node);
+        paramOut(cp, "spm_slot_addr", entry.slot.spm_slot_addr);
+        paramOut(cp, "asid", entry.mapping.asid);
+        paramOut(cp, "v_page_addr", entry.mapping.v_page_addr);
+    }
+    SERIALIZE_SCALAR(num_reverse_entries);
+}
+
+void
+ATT::unserialize(CheckpointIn &cp)
 {
     translation_table.clear();
     reverse_translation_table.clear();
+
+    unsigned num_entries;
+    UNSERIALIZE_SCALAR(num_entries);
+    for (unsigned i = 0; i < num_entries; i++) {
+        ScopedCheckpointSection sec(cp, csprintf("entry%d", i));
+
+        ATTKey key;
+        paramIn(cp, "asid", key.asid);
+        paramIn(cp, "v_page_addr", key.v_page_addr);
+
+        ATTEntry *entry = translation_table.insert(key);
+        entry->asid = key.asid;
+        entry->v_page_addr = key.v_page_addr;
+        entry->destination_node.type = MachineType_PMMU;
+        paramIn(cp, "destination_node", entry->destination_node.num);
+        paramIn(cp, "spm_slot_addr", entry->spm_slot_addr);
+        paramIn(cp, "num_owners", entry->num_owners);
+        paramIn(cp, "num_accesses", entry->num_accesses);
+        paramIn(cp, "data_valid", entry->data_valid);
+        paramIn(cp, "alias", entry->alias);
+        paramIn(cp, "read_only", entry->read_only);
+
+        bool has_annotations;
+        paramIn(cp, "has_annotations", has_annotations);
+        if (has_annotations) {
+            ScopedCheckpointSection sec(cp, "annotations");
+            entry->annotations = unserializeAnnotations(cp);
+        }
+    }
+
+    unsigned num_reverse_entries;
+    UNSERIALIZE_SCALAR(num_reverse_entries);
+    for (unsigned i = 0; i < num_reverse_entries; i++) {
+        ScopedCheckpointSection sec(cp, csprintf("reverse%d", i));
+
+        SPMSlotKey slot;
+        paramIn(cp, "node", slot.node);
+        paramIn(cp, "spm_slot_addr", slot.spm_slot_addr);
+
+        ReverseATTEntry *entry = reverse_translation_table.insert(slot);
+        entry->slot = slot;
+        entry->occupied = true;
+        paramIn(cp, "asid", entry->mapping.asid);
+        paramIn(cp, "v_page_addr", entry->mapping.v_page_addr);
+    }
+
+    generation++;
 }
 
 void
 ATT::dump()
 {
     DPRINTF(ATTMap,"\n");
-    for(std::map<Addr, ATTEntry*>::const_iterator it = translation_table.begin();
-        it != translation_table.end(); ++it) {
-        DPRINTF(ATTMap, "0x%16x %d %d\n",
-                it->first,
-                (*it->second).destination_node,
-                (*it->second).spm_slot_addr);
+    forEachMapping([](const ATTEntry &entry) {
+        DPRINTF(ATTMap, "%d 0x%16x %d %d\n",
+                entry.asid,
+                entry.v_page_addr,
+                entry.destination_node,
+                entry.spm_slot_addr);
+    });
+}
+
+ATTLookasideBuffer::ATTLookasideBuffer(ATT *_att, unsigned int num_entries,
+                                       unsigned int page_shift)
+    : att(_att),
+      lines(num_entries),
+      pageShift(page_shift)
+{
+    assert(num_entries == 0 || isPowerOf2(num_entries));
+}
+
+ATTLookasideBuffer::LookupResult
+ATTLookasideBuffer::lookup(uint64_t asid, Addr v_page_addr, ATTEntry **mapping)
+{
+    ATTEntry *entry = NULL;
+
+    if (lines.empty()) {
+        entry = att->lookup(asid, v_page_addr);
+    }
+    else {
+        LookasideLine &line = lines[((v_page_addr >> pageShift) ^ asid) & (lines.size() - 1)];
+        if (line.valid && line.v_page_addr == v_page_addr && line.asid == asid &&
+            line.generation == att->getGeneration()) {
+            lookasideHits++;
+            entry = line.mapping;
+        }
+        else {
+            lookasideMisses++;
+            entry = att->lookup(asid, v_page_addr);
+            line.asid = asid;
+            line.v_page_addr = v_page_addr;
+            line.generation = att->getGeneration();
+            line.mapping = entry;
+            line.valid = true;
+        }
     }
+
+    *mapping = entry;
+    if (!entry) {
+        return ATT_Miss;
+    }
+    else if (!entry->data_valid) {
+        return ATT_Unallocated;
+    }
+    else {
+        entry->num_accesses++;
+        return ATT_Hit;
+    }
+}
+
+void
+ATTLookasideBuffer::regStats(const std::string &name)
+{
+    lookasideHits
+        .name(name + ".att_lookaside_hits")
+        .desc("Number of ATT translations served by the lookaside buffer")
+        ;
+
+    lookasideMisses
+        .name(name + ".att_lookaside_misses")
+        .desc("Number of ATT translations that had to probe the ATT")
+        ;
 }
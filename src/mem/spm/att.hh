@@ -1,29 +1,58 @@
 #ifndef __ATT_HH__
 #define __ATT_HH__
 
-#include <limits>
-#include <map>
+#include <vector>
+
+#include "base/statistics.hh"
 #include "base/types.hh"
 #include "debug/ATT.hh"
 #include "mem/ruby/common/MachineID.hh"
+#include "mem/spm/att_hash_table.hh"
 #include "mem/spm/governor/GOVRequest.hh"
+#include "sim/serialize.hh"
+
+// virtual pages are tagged with the address space (thread group) they
+// belong to, so that several processes can share one PMMU
+typedef struct ATTKey
+{
+    uint64_t asid;
+    Addr v_page_addr;
 
-#define UINT_MAXIMUM std::numeric_limits<unsigned int>::max()
+    bool operator==(const ATTKey &o) const
+    {
+        return (asid == o.asid) && (v_page_addr == o.v_page_addr);
+    }
+} ATTKey;
 
 typedef struct ATTEntry
 {
+    uint64_t asid;
+    Addr v_page_addr;
     MachineID destination_node;
     Addr spm_slot_addr;
-    unsigned int num_owners;
+    unsigned int num_owners;  // zero marks an empty slot of the table
     unsigned int num_accesses;
     bool data_valid;
-    Annotations *annotations;
+    bool alias;       // points at a shared page another node allocated
+    bool read_only;   // the page has replicas, a write collapses them
+    Annotations *annotations; // freed in SPMPage, if unallocated in PMMU
 
     ATTEntry()
+      : asid(0),
+        v_page_addr(0),
+        spm_slot_addr(0),
+        num_owners(0),
+        num_accesses(0),
+        data_valid(false),
+        alias(false),
+        read_only(false),
+        annotations(nullptr)
     {
-        annotations = new Annotations; // freed in SPMPage, if unallocated in PMMU
     }
 
+    bool isOccupied() const { return num_owners != 0; }
+    ATTKey key() const { return {asid, v_page_addr}; }
+
     bool operator==(const ATTEntry &o) const
     {
         return (destination_node.num == o.destination_node.num) &&
@@ -31,30 +60,106 @@ typedef struct ATTEntry
     }
 } ATTEntry;
 
-class ATT
+// identifies a physical slot on one of the on-chip SPMs
+typedef struct SPMSlotKey
+{
+    NodeID node;
+    Addr spm_slot_addr;
+
+    bool operator==(const SPMSlotKey &o) const
+    {
+        return (node == o.node) && (spm_slot_addr == o.spm_slot_addr);
+    }
+} SPMSlotKey;
+
+// reverse translation: SPM slot back to the virtual page mapped onto it
+typedef struct ReverseATTEntry
+{
+    SPMSlotKey slot;
+    ATTKey mapping;
+    bool occupied;
+
+    ReverseATTEntry() : occupied(false)
+    {
+        slot.node = 0;
+        slot.spm_slot_addr = 0;
+        mapping.asid = 0;
+        mapping.v_page_addr = 0;
+    }
+
+    bool isOccupied() const { return occupied; }
+    const SPMSlotKey &key() const { return slot; }
+} ReverseATTEntry;
+
+/**
+ * An ATT entry and the spm page holding its data share one Annotations
+ * object. The checkpoint keeps the address of the object next to its
+ * fields, so that all references to it are restored to a single copy.
+ */
+void serializeAnnotations(CheckpointOut &cp, const Annotations *annotations);
+Annotations *unserializeAnnotations(CheckpointIn &cp);
+/** Forgets the copies made while restoring, once every object is restored. */
+void clearRestoredAnnotations();
+
+inline uint64_t
+attHash(Addr v_page_addr)
+{
+    // Fibonacci hashing; page-aligned keys have their entropy in the
+    // upper bits, which the multiply folds down
+    return v_page_addr * 0x9E3779B97F4A7C15ULL;
+}
+
+inline uint64_t
+attHash(const ATTKey &key)
+{
+    return attHash(key.v_page_addr + key.asid * 0xC2B2AE3D27D4EB4FULL);
+}
+
+inline uint64_t
+attHash(const SPMSlotKey &slot)
+{
+    return attHash(slot.spm_slot_addr ^ (uint64_t(slot.node) << 40));
+}
+
+class ATT : public Serializable
 {
 
   public:
-    ATT();
+    // a table_capacity of zero models an unbounded ATT
+    ATT(unsigned int _table_capacity = 0);
     ~ATT();
 
+    // returns the mapping for a virtual page address, or nullptr if there
+    // is none; the returned pointer is only valid until the table changes
+    ATTEntry* lookup(uint64_t asid, Addr v_page_addr);
+
     // checks if mapping exists for virtual page address
     // all other functions assume this is called before accessing table
-    bool hasMapping(Addr v_page_addr);
+    bool hasMapping(uint64_t asid, Addr v_page_addr);
 
-    ATTEntry* getMapping(Addr v_page_addr);
+    ATTEntry* getMapping(uint64_t asid, Addr v_page_addr);
     ATTEntry* getMapping(MachineID destination_node, Addr spm_slot_addr);
 
-    bool isHit(Addr v_page_addr);
+    bool isHit(uint64_t asid, Addr v_page_addr);
 
-    bool addMapping(Addr v_page_addr, MachineID destination_node,
-                    Addr spm_slot_addr, Annotations *annotations);
-    bool addMapping(GOVRequest *gov_request, HostInfo *host_info, int page_index);
+    enum AddResult {
+        ATT_Added = 0,
+        ATT_Exists,  // the mapping has one more owner
+        ATT_Full
+    };
 
-    bool removeMapping(Addr v_page_addr);
+    AddResult addMapping(uint64_t asid, Addr v_page_addr, MachineID destination_node,
+                         Addr spm_slot_addr, Annotations *annotations);
+    AddResult addMapping(GOVRequest *gov_request, HostInfo *host_info, int page_index);
+
+    bool removeMapping(uint64_t asid, Addr v_page_addr);
     bool removeMapping(GOVRequest *gov_request, int page_index);
 
-    ATTEntry *changeMapping(Addr v_page_addr,
+    // hands a mapping with a single owner over to another ATT, which takes
+    // the annotations along; false if either side can't do it
+    bool transferMapping(uint64_t asid, Addr v_page_addr, ATT *new_att);
+
+    ATTEntry *changeMapping(uint64_t asid, Addr v_page_addr,
                             MachineID new_destination_node, Addr new_spm_slot_addr);
     ATTEntry *changeMapping(MachineID destination_node, Addr spm_slot_addr,
                             MachineID new_destination_node, Addr new_spm_slot_addr);
@@ -65,16 +170,90 @@ class ATT
     bool isATTEntryValid(ATTEntry *mapping);
 
     unsigned int getTableSize();
+    unsigned int getTableCapacity() const { return table_capacity; }
     bool isATTFull();
 
-    void invalidateATT();
+    // drops every mapping of one address space, leaving other tenants alone
+    int invalidateASID(uint64_t asid);
     void dump();
 
+    // bumped whenever entries may have moved within the table
+    uint64_t getGeneration() const { return generation; }
+
+    // both tables are saved, a reverse entry may be newer than the
+    // forward entries sharing its slot
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+
+    template <typename Visitor>
+    void forEachMapping(Visitor visit)
+    {
+        for (auto &entry : translation_table.getSlots()) {
+            if (entry.isOccupied())
+                visit(entry);
+        }
+    }
+
+  private:
+    ATTHashTable<ATTEntry, ATTKey> translation_table;
+    ATTHashTable<ReverseATTEntry, SPMSlotKey> reverse_translation_table;
+
+    const unsigned int table_capacity;
+    uint64_t generation;
+
+    void addReverseMapping(MachineID destination_node, Addr spm_slot_addr,
+                           const ATTKey &mapping);
+    ReverseATTEntry *findReverseMapping(MachineID destination_node,
+                                        Addr spm_slot_addr);
+    void removeReverseMapping(MachineID destination_node, Addr spm_slot_addr,
+                              const ATTKey &mapping);
+};
+
+/**
+ * A small direct-mapped buffer of the last translations done by a PMMU.
+ * Each line remembers the ATT entry (or its absence) for one virtual
+ * page of an address space, so a repeated access is classified as hit, unallocated or miss
+ * with a single probe. Lines are tagged with the ATT generation, so any
+ * insertion or removal in the ATT implicitly flushes the buffer.
+ */
+class ATTLookasideBuffer
+{
   public:
-    std::map<Addr, ATTEntry*> translation_table;
-    std::map<ATTEntry*, Addr> reverse_translation_table;
+    enum LookupResult {
+        ATT_Hit = 0,
+        ATT_Unallocated,
+        ATT_Miss
+    };
+
+    ATTLookasideBuffer(ATT *_att, unsigned int num_entries,
+                       unsigned int page_shift);
+
+    LookupResult lookup(uint64_t asid, Addr v_page_addr, ATTEntry **mapping);
+
+    void regStats(const std::string &name);
+
+  private:
+    typedef struct LookasideLine
+    {
+        uint64_t asid;
+        Addr v_page_addr;
+        uint64_t generation;
+        ATTEntry *mapping;
+        bool valid;
+
+        LookasideLine()
+          : asid(0), v_page_addr(0), generation(0), mapping(nullptr),
+            valid(false)
+        {
+        }
+    } LookasideLine;
+
+    ATT *att;
+    std::vector<LookasideLine> lines;
+    const unsigned int pageShift;
 
-    static const unsigned int table_capacity = UINT_MAXIMUM; //TODO: make this a command line parameter
+    Stats::Scalar lookasideHits;
+    Stats::Scalar lookasideMisses;
 };
 
 #endif /* __ATT_HH__ */
@@ -0,0 +1,106 @@
+#ifndef __ATT_HASH_TABLE_HH__
+#define __ATT_HASH_TABLE_HH__
+
+#include <cassert>
+#include <vector>
+
+#include "base/intmath.hh"
+
+/**
+ * Open-addressing (linear probing) hash table with the entries stored
+ * inline in a single power-of-two sized array. Entries must provide
+ * key() and isOccupied(), and a default constructed entry is an empty
+ * slot. Keys are hashed by the attHash() overload for their type.
+ * Removal uses backward shifting, so no tombstones are left behind.
+ * Pointers to entries are only valid until the next insertion or
+ * removal.
+ */
+template <class Entry, class Key>
+class ATTHashTable
+{
+  public:
+    ATTHashTable() : slots(initialSlots), numOccupied(0) {}
+
+    Entry *find(const Key &key)
+    {
+        const size_t mask = slots.size() - 1;
+        for (size_t i = home(key); ; i = (i + 1) & mask) {
+            Entry &slot = slots[i];
+            if (!slot.isOccupied())
+                return nullptr;
+            if (slot.key() == key)
+                return &slot;
+        }
+    }
+
+    /** Returns an empty slot for key, the caller must fill it in. */
+    Entry *insert(const Key &key)
+    {
+        if ((numOccupied + 1) * 4 > slots.size() * 3)
+            resize(slots.size() * 2);
+
+        const size_t mask = slots.size() - 1;
+        size_t i = home(key);
+        while (slots[i].isOccupied())
+            i = (i + 1) & mask;
+        numOccupied++;
+        return &slots[i];
+    }
+
+    void erase(Entry *entry)
+    {
+        const size_t mask = slots.size() - 1;
+        size_t hole = entry - &slots[0];
+        assert(hole < slots.size() && slots[hole].isOccupied());
+
+        for (size_t i = (hole + 1) & mask; slots[i].isOccupied();
+             i = (i + 1) & mask) {
+            size_t h = home(slots[i].key());
+            // leave the entry where it is if its home lies cyclically
+            // within (hole, i]
+            bool in_place = (hole <= i) ? (hole < h && h <= i)
+                                        : (hole < h || h <= i);
+            if (!in_place) {
+                slots[hole] = slots[i];
+                hole = i;
+            }
+        }
+        slots[hole] = Entry();
+        numOccupied--;
+    }
+
+    void clear()
+    {
+        slots.assign(initialSlots, Entry());
+        numOccupied = 0;
+    }
+
+    size_t size() const { return numOccupied; }
+
+    std::vector<Entry> &getSlots() { return slots; }
+    const std::vector<Entry> &getSlots() const { return slots; }
+
+  private:
+    static const size_t initialSlots = 64;
+
+    std::vector<Entry> slots;
+    size_t numOccupied;
+
+    size_t home(const Key &key) const
+    {
+        return attHash(key) >> (64 - floorLog2(slots.size()));
+    }
+
+    void resize(size_t new_size)
+    {
+        std::vector<Entry> old_slots(new_size);
+        old_slots.swap(slots);
+        numOccupied = 0;
+        for (auto &e : old_slots) {
+            if (e.isOccupied())
+                *insert(e.key()) = e;
+        }
+    }
+};
+
+#endif /* __ATT_HASH_TABLE_HH__ */
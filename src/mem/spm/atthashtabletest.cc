@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "mem/spm/att_hash_table.hh"
+
+// a key that carries the slot it hashes to, so that collisions and the
+// wraparound at the end of the table can be set up
+struct TestKey
+{
+    unsigned home;
+    unsigned id;
+
+    bool operator==(const TestKey &o) const
+    {
+        return (home == o.home) && (id == o.id);
+    }
+};
+
+inline uint64_t
+attHash(const TestKey &key)
+{
+    // the table takes its index from the top bits, 6 of them at 64 slots
+    return uint64_t(key.home) << 58;
+}
+
+struct TestEntry
+{
+    TestKey k;
+    bool occupied;
+
+    TestEntry() : k{0, 0}, occupied(false) {}
+
+    bool isOccupied() const { return occupied; }
+    const TestKey &key() const { return k; }
+};
+
+class ATTHashTableTest : public testing::Test
+{
+  protected:
+    ATTHashTable<TestEntry, TestKey> table;
+
+    void
+    insert(unsigned home, unsigned id)
+    {
+        TestEntry *entry = table.insert({home, id});
+        entry->k = {home, id};
+        entry->occupied = true;
+    }
+
+    void
+    erase(unsigned home, unsigned id)
+    {
+        TestEntry *entry = table.find({home, id});
+        ASSERT_NE(entry, nullptr);
+        table.erase(entry);
+    }
+
+    // slot of the entry, or -1 if it isn't in the table
+    long
+    slotOf(unsigned home, unsigned id)
+    {
+        TestEntry *entry = table.find({home, id});
+        return entry ? entry - &table.getSlots()[0] : -1;
+    }
+};
+
+TEST_F(ATTHashTableTest, Empty)
+{
+    EXPECT_EQ(table.size(), 0u);
+    EXPECT_EQ(table.getSlots().size(), 64u);
+    EXPECT_EQ(slotOf(0, 0), -1);
+}
+
+TEST_F(ATTHashTableTest, InsertWrapsAround)
+{
+    insert(63, 0);
+    insert(63, 1);
+    insert(63, 2);
+
+    EXPECT_EQ(table.size(), 3u);
+    EXPECT_EQ(slotOf(63, 0), 63);
+    EXPECT_EQ(slotOf(63, 1), 0);
+    EXPECT_EQ(slotOf(63, 2), 1);
+    EXPECT_EQ(slotOf(63, 3), -1);
+}
+
+TEST_F(ATTHashTableTest, EraseShiftsBackAcrossTheEnd)
+{
+    insert(63, 0);
+    insert(63, 1);
+    insert(63, 2);
+    // displaced from its home by the entries that wrapped around
+    insert(0, 3);
+    EXPECT_EQ(slotOf(0, 3), 2);
+
+    erase(63, 0);
+
+    EXPECT_EQ(table.size(), 3u);
+    EXPECT_EQ(slotOf(63, 0), -1);
+    EXPECT_EQ(slotOf(63, 1), 63);
+    EXPECT_EQ(slotOf(63, 2), 0);
+    EXPECT_EQ(slotOf(0, 3), 1);
+    EXPECT_FALSE(table.getSlots()[2].isOccupied());
+}
+
+TEST_F(ATTHashTableTest, EraseLeavesEntriesAtTheirHome)
+{
+    insert(62, 0);
+    insert(63, 0);
+    insert(0, 0);
+
+    erase(62, 0);
+
+    EXPECT_EQ(slotOf(63, 0), 63);
+    EXPECT_EQ(slotOf(0, 0), 0);
+    EXPECT_FALSE(table.getSlots()[62].isOccupied());
+}
+
+TEST_F(ATTHashTableTest, EraseWrappedEntry)
+{
+    insert(63, 0);
+    insert(63, 1);
+    insert(0, 2);
+
+    erase(63, 1);
+
+    EXPECT_EQ(slotOf(63, 0), 63);
+    EXPECT_EQ(slotOf(0, 2), 0);
+    EXPECT_FALSE(table.getSlots()[1].isOccupied());
+}
+
+TEST_F(ATTHashTableTest, GrowsKeepingEveryEntry)
+{
+    for (unsigned id = 0; id < 100; id++)
+        insert(id % 64, id);
+
+    EXPECT_EQ(table.size(), 100u);
+    EXPECT_GT(table.getSlots().size(), 64u);
+    for (unsigned id = 0; id < 100; id++)
+        EXPECT_NE(slotOf(id % 64, id), -1) << "id " << id;
+
+    for (unsigned id = 0; id < 100; id += 2)
+        erase(id % 64, id);
+
+    EXPECT_EQ(table.size(), 50u);
+    for (unsigned id = 0; id < 100; id++)
+        EXPECT_EQ(slotOf(id % 64, id) != -1, id % 2 == 1) << "id " << id;
+}
@@ -15,6 +15,17 @@ class BaseGovernor(SimObject):
     guest_slot_relocation_policy = Param.String("MoveOffChip", "Guest Slot Relocation Policy")
     hybrid_mem = Param.Bool(False, "hybrid memory (SPM/Cache)?")
     uncacheable_spm = Param.Bool(False, "If unallocated SPM pages should be uncacheable")
+    migration_epoch = Param.Latency('10us', "Time between page migration rounds (0 disables them)")
+    migration_budget = Param.Unsigned(4, "Max number of pages migrated per epoch")
+    migration_threshold = Param.Unsigned(16, "Min accesses per epoch for a remote page to be migrated")
+    plan_file = Param.String("", "Placement plan replayed by the Plan governor (see util/spm_plan.py)")
+    replication_epoch = Param.Latency('10us', "Time between page replication rounds (0 disables them)")
+    replication_budget = Param.Unsigned(4, "Max number of shared pages replicated per epoch")
+    replication_threshold = Param.Unsigned(32, "Min reads per epoch for a node to get its own copy of a shared page")
+    power_epoch = Param.Latency('10us', "Time between power management rounds (0 disables them)")
+    cold_threshold = Param.Unsigned(1, "Min accesses per epoch for a page to stay at the nominal operating point")
+    approx_epoch = Param.Latency('10us', "Time between operating point selection rounds (0 disables them)")
+    error_budget = Param.Unsigned(8, "Max faulty approximate accesses per epoch per application")
 
 class LocalSPM(BaseGovernor):
     type = 'LocalSPM'
@@ -40,3 +51,33 @@ class GuaranteedGreedySPM(BaseGovernor):
     type = 'GuaranteedGreedySPM'
     cxx_class = 'GuaranteedGreedySPM'
     cxx_header = "mem/spm/governor/guaranteed_greedy_spm.hh"
+
+class MigratingGreedySPM(BaseGovernor):
+    type = 'MigratingGreedySPM'
+    cxx_class = 'MigratingGreedySPM'
+    cxx_header = "mem/spm/governor/migrating_greedy_spm.hh"
+
+class AdaptiveApproxSPM(BaseGovernor):
+    type = 'AdaptiveApproxSPM'
+    cxx_class = 'AdaptiveApproxSPM'
+    cxx_header = "mem/spm/governor/adaptive_approx_spm.hh"
+
+class PlanSPM(BaseGovernor):
+    type = 'PlanSPM'
+    cxx_class = 'PlanSPM'
+    cxx_header = "mem/spm/governor/plan_spm.hh"
+
+class PowerGatingSPM(BaseGovernor):
+    type = 'PowerGatingSPM'
+    cxx_class = 'PowerGatingSPM'
+    cxx_header = "mem/spm/governor/power_gating_spm.hh"
+
+class PrioritySPM(BaseGovernor):
+    type = 'PrioritySPM'
+    cxx_class = 'PrioritySPM'
+    cxx_header = "mem/spm/governor/priority_spm.hh"
+
+class ReplicatingGreedySPM(BaseGovernor):
+    type = 'ReplicatingGreedySPM'
+    cxx_class = 'ReplicatingGreedySPM'
+    cxx_header = "mem/spm/governor/replicating_greedy_spm.hh"
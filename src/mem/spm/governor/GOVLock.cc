@@ -0,0 +1,40 @@
+#include "mem/spm/governor/GOVLock.hh"
+
+std::mutex GOVLock::gov_mutex;
+__thread int GOVLock::depth = 0;
+
+GOVLock::GOVLock()
+    : own_queue(curEventQueue()),
+      locked(inParallelMode && depth == 0)
+{
+    depth++;
+    if (!locked) {
+        return;
+    }
+
+    // never wait for the governor while holding a queue somebody in the
+    // governor might need
+    own_queue->unlock();
+    gov_mutex.lock();
+
+    // always in the same order, so two threads can't hold each other up
+    for (uint32_t i = 0; i < numMainEventQueues; i++) {
+        mainEventQueue[i]->lock();
+    }
+}
+
+GOVLock::~GOVLock()
+{
+    depth--;
+    if (!locked) {
+        return;
+    }
+
+    curEventQueue(own_queue);
+    for (uint32_t i = 0; i < numMainEventQueues; i++) {
+        if (mainEventQueue[i] != own_queue) {
+            mainEventQueue[i]->unlock();
+        }
+    }
+    gov_mutex.unlock();
+}
@@ -0,0 +1,61 @@
+/* The nodes of an spm mesh can be spread over several event queues, each
+ * run by its own thread. Governor decisions read and change the state of
+ * many nodes at once (ATTs, free slots, pages in flight), so they are taken
+ * with the rest of the simulation paused: a GOVLock takes the governor
+ * mutex and then the service lock of every event queue, which the other
+ * threads only give up in between two of their events or while waiting
+ * for the queues to synchronize. Requests of different nodes are served
+ * one after the other, and the node asking keeps its own queue locked.
+ *
+ * Under a GOVLock, code acting on behalf of another node runs in a
+ * GOVNodeContext, so the events and messages it creates are timed and
+ * scheduled in the queue of that node.
+ *
+ * Both do nothing when the simulation runs a single queue.
+ * */
+
+#ifndef __GOV_LOCK_HH__
+#define __GOV_LOCK_HH__
+
+#include <mutex>
+
+#include "sim/eventq.hh"
+
+class GOVLock
+{
+  public:
+    GOVLock();
+    ~GOVLock();
+
+    // does this thread hold every event queue already?
+    static bool isHeld() { return depth > 0; }
+
+  private:
+    // the queue of the thread taking the lock, kept locked afterwards
+    EventQueue *own_queue;
+    bool locked;
+
+    static std::mutex gov_mutex;
+    // governor calls may nest, only the outermost one locks
+    static __thread int depth;
+};
+
+class GOVNodeContext
+{
+  public:
+    GOVNodeContext(EventManager *node)
+        : old_queue(curEventQueue())
+    {
+        curEventQueue(node->eventQueue());
+    }
+
+    ~GOVNodeContext()
+    {
+        curEventQueue(old_queue);
+    }
+
+  private:
+    EventQueue *old_queue;
+};
+
+#endif  /* __GOV_LOCK_HH__ */
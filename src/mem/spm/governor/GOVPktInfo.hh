@@ -2,6 +2,7 @@
 #define __GOV_REQ_INFO_HH__
 
 #include <limits>
+#include <vector>
 #include "mem/ruby/common/TypeDefines.hh"
 
 #define UINT_MAXIMUM std::numeric_limits<unsigned int>::max()
@@ -33,6 +34,18 @@ typedef struct GOVReqSignaling
 
 } GOVReqSignaling;
 
+// one page of a bulk transfer; on the SPM side the pages of a run are
+// contiguous, starting at the packet's SPM address
+typedef struct GOVRunPage
+{
+    Addr mem_p_addr;
+    Addr mem_v_addr;
+    Annotations *annotations;
+    // contents of a relocated page on its way, taken from its slot
+    // rather than copied into the packet
+    uint8_t *page_data;
+} GOVRunPage;
+
 class GOVPktInfo
 {
   private:
@@ -56,29 +69,46 @@ class GOVPktInfo
     Addr spm_p_addr;
     Addr mem_p_addr;
     Addr mem_v_addr;
+    uint64_t asid;
+    uint64_t ticket;
     ReqType request_type;
     ReqStatus request_status;
 
     // Relocation-specific
     Addr future_spm_p_addr;
     NodeID future_host_node;
+    bool keep_source;
 
   private:
     GOVReqSignaling signaling;
     Annotations *annotations;
+    std::vector<GOVRunPage> run_pages;
 
   public:
 
     GOVPktInfo() : validInfo (false),
+                   asid(0),
+                   ticket(0),
                    request_type(NUM_REQ_TYPES),
                    request_status(NUM_REQ_STATUS),
                    future_spm_p_addr(0),
                    future_host_node(UINT_MAXIMUM),
+                   keep_source(false),
                    annotations(nullptr)
     {
         setAddresses(0,0,0);
     }
 
+    // back to a default constructed state, keeping the run's storage
+    void reset()
+    {
+        std::vector<GOVRunPage> pages;
+        pages.swap(run_pages);
+        *this = GOVPktInfo();
+        pages.clear();
+        run_pages.swap(pages);
+    }
+
     const char *toString()
     {
         static const char * ReqTypeStrings[] = { "Allocation",
@@ -144,15 +174,34 @@ class GOVPktInfo
     Addr getPhysicalAddress() { return mem_p_addr; }
     Addr getVirtualAddress()  { return mem_v_addr; }
 
+    void setASID(uint64_t _asid) { asid = _asid; }
+    uint64_t getASID()           { return asid; }
+
+    // ticket of the asynchronous request this packet belongs to, if any
+    void setTicket(uint64_t _ticket) { ticket = _ticket; }
+    uint64_t getTicket()             { return ticket; }
+
     void setFutureHost(NodeID _future_host_node)      {future_host_node = _future_host_node;}
     void setFutureSPMAddress(Addr _future_spm_p_addr) {future_spm_p_addr = _future_spm_p_addr;}
 
     NodeID getFutureHost()     { return future_host_node; }
     Addr getFutureSPMAddress() { return future_spm_p_addr; }
 
+    // spm to spm copies leave the pages they read in place
+    void keepSource()  { keep_source = true; }
+    bool keepsSource() { return keep_source; }
+
     void setAnnotations(Annotations *_annotations) { assert(_annotations); annotations = _annotations; }
     Annotations *getAnnotations() { assert(annotations); return annotations; }
 
+    void addRunPage(Addr _mem_p_addr, Addr _mem_v_addr, Annotations *_annotations)
+    {
+        GOVRunPage page = {_mem_p_addr, _mem_v_addr, _annotations, nullptr};
+        run_pages.push_back(page);
+    }
+    int getNumPages() { return run_pages.size(); }
+    GOVRunPage &getRunPage(int page_index) { return run_pages.at(page_index); }
+
     void setSignaling(GOVReqSignaling *_signaling) { signaling = *_signaling; }
     GOVReqSignaling *getSignaling() { return &signaling; }
 };
@@ -235,10 +235,17 @@ class GOVRequest
 
     ThreadContext *tc;
     GOVCommand cmd;
+    uint64_t asid;
     AddrRange address_range;
     uint64_t metadata;
     Annotations *annotations;
     int pages_served;
+    bool async;
+    uint64_t ticket;  // non-zero for asynchronous requests
+
+    // spm to spm transfers, see SPM_HANDOFF/SPM_COPY
+    TransferModes transfer_mode;
+    NodeID transfer_node;
 
     GOVRequest(ThreadContext *_tc, GOVCommand _cmd,
                Addr _start_addr, Addr _end_addr, uint64_t _metadata) :
@@ -247,12 +254,18 @@ class GOVRequest
         tc = _tc;
         cmd = _cmd;
 
+        // threads of one process share an address space, hence the tgid
+        asid = tc ? tc->getProcessPtr()->tgid() : 0;
+
         metadata = _metadata;
 
+        transfer_mode = NUM_TRANSFER_MODE;
+        transfer_node = 0;
         annotations = new Annotations();
         decodeMetadata();
 
         pages_served = 0;
+        ticket = 0;
     }
 
     ~GOVRequest()
@@ -276,6 +289,14 @@ class GOVRequest
         {
             annotations->dealloc_mode    = static_cast<DeallocationModes>((metadata >> 0) & 0x000000000000000F);
         }
+
+        else if (cmd == Relocation)
+        {
+            transfer_mode                = static_cast<TransferModes>((metadata >> 0) & 0x000000000000000F);
+            transfer_node                = static_cast<NodeID>((metadata >> 32) & 0x00000000FFFFFFFF);
+        }
+
+        async = ((metadata >> 28) & 0x0000000000000001) != 0;
     }
 
     void incPagesServed(int num_pages)
@@ -299,6 +320,41 @@ class GOVRequest
         return tc;
     }
 
+    uint64_t getASID()
+    {
+        return asid;
+    }
+
+    void setASID(uint64_t _asid)
+    {
+        asid = _asid;
+    }
+
+    bool isAsync()
+    {
+        return async;
+    }
+
+    uint64_t getTicket()
+    {
+        return ticket;
+    }
+
+    void setTicket(uint64_t _ticket)
+    {
+        ticket = _ticket;
+    }
+
+    TransferModes getTransferMode()
+    {
+        return transfer_mode;
+    }
+
+    NodeID getTransferNode()
+    {
+        return transfer_node;
+    }
+
     BaseCPU *getCPUPtr()
     {
         return tc->getCpuPtr();
@@ -315,9 +371,15 @@ class GOVRequest
         return getSPMPtr()->myPMMU;
     }
 
+    // the page table of the request's address space, which isn't the one
+    // of its thread context when the pages of another tenant are evicted
     FuncPageTable *getPageTablePtr()
     {
-        return dynamic_cast<FuncPageTable*>(tc->getProcessPtr()->pTable);
+        Process *process = tc->getProcessPtr();
+        if (process->tgid() != asid) {
+            process = getPMMUPtr()->getASIDProcess(asid);
+        }
+        return dynamic_cast<FuncPageTable*>(process->pTable);
     }
 
     RequesterInfo getRequesterInfo()
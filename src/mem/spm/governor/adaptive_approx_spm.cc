@@ -0,0 +1,237 @@
+#include "mem/spm/governor/adaptive_approx_spm.hh"
+
+#include <algorithm>
+#include <iostream>
+
+// longest wait, in epochs, before an application climbs again
+static const unsigned maxBackoff = 64;
+
+AdaptiveApproxSPM *
+AdaptiveApproxSPMParams::create()
+{
+    return new AdaptiveApproxSPM(this);
+}
+
+AdaptiveApproxSPM::AdaptiveApproxSPM(const Params *p)
+    : EpochGreedySPM(p, p->approx_epoch),
+      error_budget(p->error_budget)
+{
+    gov_type = "AdaptiveApprox";
+}
+
+AdaptiveApproxSPM::~AdaptiveApproxSPM()
+{
+
+}
+
+void
+AdaptiveApproxSPM::init()
+{
+    EpochGreedySPM::init();
+
+    if (!pmmus.empty()) {
+        buildLadder(pmmus[0]->my_spm_ptr->spmSlots[0].berEnergyData);
+    }
+}
+
+void
+AdaptiveApproxSPM::buildLadder(const vector<BEREnergyData> &points)
+{
+    vector<int> by_ber;
+    for (int point = 0; point < points.size(); point++) {
+        by_ber.push_back(point);
+    }
+    std::stable_sort(by_ber.begin(), by_ber.end(), [&points](int a, int b) {
+        return points[a].read_ber + points[a].write_ber <
+               points[b].read_ber + points[b].write_ber;
+    });
+
+    // a riskier point is only worth it if it costs less energy
+    ladder.clear();
+    for (int point : by_ber) {
+        if (!ladder.empty()) {
+            const BEREnergyData &prev = points[ladder.back()];
+            const BEREnergyData &next = points[point];
+            bool no_worse = next.leakage_power <= prev.leakage_power &&
+                            next.read_access_energy <= prev.read_access_energy &&
+                            next.write_access_energy <= prev.write_access_energy;
+            bool better = next.leakage_power < prev.leakage_power ||
+                          next.read_access_energy < prev.read_access_energy ||
+                          next.write_access_energy < prev.write_access_energy;
+            if (!no_worse || !better)
+                continue;
+        }
+        ladder.push_back(point);
+    }
+
+    fatal_if(ladder.size() < 2, "%s: the ber file has no operating point "
+             "saving energy over the safest one\n", name());
+}
+
+void
+AdaptiveApproxSPM::serialize(CheckpointOut &cp) const
+{
+    vector<uint64_t> asids;
+    vector<unsigned> rungs;
+    vector<unsigned> backoffs;
+    vector<unsigned> holds;
+    for (auto &app : app_states) {
+        asids.push_back(app.first);
+        rungs.push_back(app.second.rung);
+        backoffs.push_back(app.second.backoff);
+        holds.push_back(app.second.hold);
+    }
+    SERIALIZE_CONTAINER(asids);
+    SERIALIZE_CONTAINER(rungs);
+    SERIALIZE_CONTAINER(backoffs);
+    SERIALIZE_CONTAINER(holds);
+
+    EpochGreedySPM::serialize(cp);
+}
+
+void
+AdaptiveApproxSPM::unserialize(CheckpointIn &cp)
+{
+    vector<uint64_t> asids;
+    vector<unsigned> rungs;
+    vector<unsigned> backoffs;
+    vector<unsigned> holds;
+    UNSERIALIZE_CONTAINER(asids);
+    UNSERIALIZE_CONTAINER(rungs);
+    UNSERIALIZE_CONTAINER(backoffs);
+    UNSERIALIZE_CONTAINER(holds);
+
+    if (rungs.size() != asids.size() || backoffs.size() != asids.size() ||
+        holds.size() != asids.size())
+        fatal("%s: malformed application state in the checkpoint\n", name());
+    app_states.clear();
+    for (int i = 0; i < asids.size(); i++) {
+        if (rungs[i] >= ladder.size())
+            fatal("%s: the ber file changed since the checkpoint\n", name());
+        app_states[asids[i]] = AppState{rungs[i], backoffs[i], holds[i]};
+    }
+
+    EpochGreedySPM::unserialize(cp);
+}
+
+void
+AdaptiveApproxSPM::regStats()
+{
+    EpochGreedySPM::regStats();
+
+    approx_epochs
+        .name(name() + ".approx_epochs")
+        .desc("Number of operating point selection epochs")
+        ;
+
+    faulty_accesses
+        .name(name() + ".faulty_accesses")
+        .desc("Number of accesses to approximate pages that got bit flips")
+        ;
+
+    budget_violations
+        .name(name() + ".budget_violations")
+        .desc("Number of times an application exceeded its error budget in an epoch")
+        ;
+
+    rung_increases
+        .name(name() + ".rung_increases")
+        .desc("Number of times an application moved to a less safe operating point")
+        ;
+
+    rung_decreases
+        .name(name() + ".rung_decreases")
+        .desc("Number of times an application backed off to a safer operating point")
+        ;
+
+    page_moves
+        .name(name() + ".page_moves")
+        .desc("Number of times a slot changed its operating point")
+        ;
+}
+
+bool
+AdaptiveApproxSPM::isApproximate(SPMPage &page)
+{
+    return page.isValid() && page.getAnnotations()->approximation != CRITICAL;
+}
+
+uint64_t
+AdaptiveApproxSPM::getSlotASID(PMMU *host_pmmu, int slot_idx)
+{
+    PMMU *owner_pmmu = getPMMU(host_pmmu->my_spm_ptr->spmSlots[slot_idx].getOwner());
+    ATTEntry *mapping = owner_pmmu->my_att->getMapping(host_pmmu->getMachineID(),
+                                        slot_idx * host_pmmu->getPageSizeBytes());
+    return mapping->asid;
+}
+
+void
+AdaptiveApproxSPM::runEpoch()
+{
+    // the slots of every node are looked at, with all of them paused
+    GOVLock gov_lock;
+
+    approx_epochs++;
+
+    // faults injected into the approximate pages of every application,
+    // which starts at the safest point the first time it is seen
+    std::map<uint64_t, uint64_t> app_faults;
+    for (auto host_pmmu : pmmus) {
+        SPMPage *slots = host_pmmu->my_spm_ptr->spmSlots;
+        for (int slot_idx = 0; slot_idx < host_pmmu->getSPMSizePages(); slot_idx++) {
+            uint64_t epoch_faults = sampleSlot(host_pmmu, slot_idx).fault_count;
+            if (!slots[slot_idx].isFree() && isApproximate(slots[slot_idx])) {
+                uint64_t asid = getSlotASID(host_pmmu, slot_idx);
+                app_states.emplace(asid, AppState{0, 0, 0});
+                app_faults[asid] += epoch_faults;
+                faulty_accesses += epoch_faults;
+            }
+        }
+    }
+
+    for (auto &app : app_states) {
+        AppState &state = app.second;
+        if (app_faults[app.first] > error_budget) {
+            budget_violations++;
+            if (state.rung > 0) {
+                state.rung--;
+                rung_decreases++;
+            }
+            state.backoff = std::min(std::max(2 * state.backoff, 1u), maxBackoff);
+            state.hold = state.backoff;
+        }
+        else if (state.hold > 0) {
+            state.hold--;
+        }
+        else if (state.rung + 1 < ladder.size()) {
+            state.rung++;
+            rung_increases++;
+        }
+
+        DPRINTF(GOV, "%s: ASID %d had %d faulty access(es), now at operating point %d\n",
+                gov_type, app.first, app_faults[app.first], ladder[state.rung]);
+    }
+
+    for (auto host_pmmu : pmmus) {
+        SPM *spm = host_pmmu->my_spm_ptr;
+        SPMPage *slots = spm->spmSlots;
+        for (int slot_idx = 0; slot_idx < host_pmmu->getSPMSizePages(); slot_idx++) {
+            SPMPage &page = slots[slot_idx];
+
+            // pages still being filled or relocated are left alone
+            if (!page.isFree() && !page.isValid()) {
+                continue;
+            }
+
+            int point = ladder[0];
+            if (!page.isFree() && isApproximate(page)) {
+                point = ladder[app_states[getSlotASID(host_pmmu, slot_idx)].rung];
+            }
+
+            if (page.getOperatingPoint() != point) {
+                spm->setPageOperatingPoint(slot_idx, point);
+                page_moves++;
+            }
+        }
+    }
+}
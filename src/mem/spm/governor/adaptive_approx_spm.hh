@@ -0,0 +1,63 @@
+/* This class implements an SPM governor which greedily maps the allocation
+ * requests to the closest free on-chip SPM, and picks the operating point
+ * of every page at runtime. The operating points of the ber file are
+ * ordered into a ladder, from the safest one to the most error prone,
+ * keeping only the points that save energy over the previous one. Every
+ * epoch, an application (i.e. the address space mapping the pages) whose
+ * approximate pages got at most error_budget faulty accesses climbs one
+ * rung, and one that got more steps back down and waits twice as long as
+ * last time before climbing again. Critical pages and free slots stay at the safest
+ * point.
+ * */
+
+#ifndef __ADAPTIVE_APPROX_SPM_HH__
+#define __ADAPTIVE_APPROX_SPM_HH__
+
+#include <map>
+
+#include "params/AdaptiveApproxSPM.hh"
+#include "mem/spm/governor/epoch_greedy_spm.hh"
+
+class AdaptiveApproxSPM : public EpochGreedySPM {
+
+  public:
+    AdaptiveApproxSPM(const Params *p);
+    virtual ~AdaptiveApproxSPM();
+    virtual void init();
+    virtual void regStats();
+
+    // the rung of every application, besides the samples
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+
+  protected:
+    unsigned error_budget;
+
+    // operating points, safest first
+    vector<int> ladder;
+    void buildLadder(const vector<BEREnergyData> &points);
+
+    struct AppState
+    {
+        unsigned rung;     // index into ladder
+        unsigned backoff;  // epochs to wait after the last violation
+        unsigned hold;     // epochs left before climbing again
+    };
+    std::map<uint64_t, AppState> app_states;  // indexed by asid
+
+    // moves every application up or down the ladder
+    void runEpoch() override;
+
+    bool isApproximate(SPMPage &page);
+    // the address space a valid slot is mapped into
+    uint64_t getSlotASID(PMMU *host_pmmu, int slot_idx);
+
+    Stats::Scalar approx_epochs;
+    Stats::Scalar faulty_accesses;
+    Stats::Scalar budget_violations;
+    Stats::Scalar rung_increases;
+    Stats::Scalar rung_decreases;
+    Stats::Scalar page_moves;
+};
+
+#endif  /* __ADAPTIVE_APPROX_SPM_HH__ */
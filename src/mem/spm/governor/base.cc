@@ -1,10 +1,18 @@
 #include "mem/spm/governor/base.hh"
+#include "mem/spm/att.hh"
+#include "mem/spm/governor/adaptive_approx_spm.hh"
 #include "mem/spm/governor/explicit_local_spm.hh"
 #include "mem/spm/governor/greedy_spm.hh"
 #include "mem/spm/governor/guaranteed_greedy_spm.hh"
 #include "mem/spm/governor/local_spm.hh"
+#include "mem/spm/governor/migrating_greedy_spm.hh"
+#include "mem/spm/governor/plan_spm.hh"
+#include "mem/spm/governor/power_gating_spm.hh"
+#include "mem/spm/governor/priority_spm.hh"
 #include "mem/spm/governor/random_spm.hh"
+#include "mem/spm/governor/replicating_greedy_spm.hh"
 
+#include <algorithm>
 #include <iostream>
 using namespace std;
 
@@ -21,6 +29,18 @@ BaseGovernorParams::create()
         return new GreedySPM(this);
     else if (gov_type.compare("GuaranteedGreedy") == 0)
         return new GuaranteedGreedySPM(this);
+    else if (gov_type.compare("MigratingGreedy") == 0)
+        return new MigratingGreedySPM(this);
+    else if (gov_type.compare("AdaptiveApprox") == 0)
+        return new AdaptiveApproxSPM(this);
+    else if (gov_type.compare("Plan") == 0)
+        return new PlanSPM(this);
+    else if (gov_type.compare("PowerGating") == 0)
+        return new PowerGatingSPM(this);
+    else if (gov_type.compare("Priority") == 0)
+        return new PrioritySPM(this);
+    else if (gov_type.compare("ReplicatingGreedy") == 0)
+        return new ReplicatingGreedySPM(this);
     else
         panic ("undefined governor type");
 }
@@ -49,37 +69,275 @@ BaseGovernor::printRequestStatus(GOVRequest *gov_request)
                  gov_request->getNumberOfPages(Unserved_Aligned));
 }
 
+int
+BaseGovernor::transfer(GOVRequest *gov_request)
+{
+    printRequestStatus(gov_request);
+
+    PMMU *requester_pmmu = gov_request->getPMMUPtr();
+    NodeID consumer_node = gov_request->getTransferNode();
+    if (consumer_node == requester_pmmu->getNodeID() || !PMMU::hasPMMU(consumer_node) ||
+        gov_request->getTransferMode() >= NUM_TRANSFER_MODE) {
+        warn("%s: Ignoring transfer of node %d to node %d\n",
+             gov_type, requester_pmmu->getNodeID(), consumer_node);
+        return 0;
+    }
+
+    PMMU *consumer_pmmu = PMMU::getPMMU(consumer_node);
+    bool duplicate = gov_request->getTransferMode() == DUPLICATE;
+
+    const int total_num_pages = gov_request->getNumberOfPages(Unserved_Aligned);
+    const Addr start_v_page_addr = gov_request->getStartAddr(Unserved_Aligned);
+    const int page_size = gov_request->getPageSizeBytes();
+
+    int num_transferred_pages = 0;
+    int page_index = 0;
+    while (page_index < total_num_pages) {
+
+        int run_length = 0;
+        while (page_index + run_length < total_num_pages &&
+               isTransferable(gov_request, consumer_pmmu, page_index + run_length, duplicate)) {
+            run_length++;
+        }
+
+        if (run_length == 0) {
+            // off chip, still on its way, or already known to the consumer
+            page_index++;
+            continue;
+        }
+
+        Addr run_start = start_v_page_addr + page_index*page_size;
+        GOVRequest run_request (gov_request->getThreadContext(), Relocation,
+                                run_start, run_start + run_length*page_size, 0);
+        run_request.setASID(gov_request->getASID());
+
+        num_transferred_pages += duplicate ?
+                                 copy_helper_virtual_address(&run_request, consumer_pmmu) :
+                                 handoff_helper_virtual_address(&run_request, consumer_pmmu);
+        page_index += run_length;
+    }
+
+    DPRINTF(GOV, "%s: %s %d/%d page(s) of node (%d,%d) to node (%d,%d)\n",
+            gov_type, duplicate ? "Copied" : "Handed off",
+            num_transferred_pages, total_num_pages,
+            requester_pmmu->getNodeID() / num_column,
+            requester_pmmu->getNodeID() % num_column,
+            consumer_node / num_column,
+            consumer_node % num_column);
+
+    gov_request->incPagesServed(total_num_pages);
+    return num_transferred_pages;
+}
+
+int
+BaseGovernor::resize(PMMU *host_pmmu, unsigned num_ways)
+{
+    SPM *host_spm = host_pmmu->my_spm_ptr;
+    if (!host_spm->isReconfigurable() || num_ways > host_spm->getMaxSPMWays()) {
+        warn("%s: Ignoring resize of node %d to %d cache ways\n",
+             gov_type, host_pmmu->getNodeID(), num_ways);
+        return host_pmmu->getSPMSizePages();
+    }
+
+    const int num_slots = num_ways * host_spm->getPagesPerWay();
+    SPMPage *slots = host_spm->spmSlots;
+
+    // pages still being filled or relocated can't be moved off yet
+    for (int slot_idx = num_slots; slot_idx < host_pmmu->getSPMSizePages(); slot_idx++) {
+        if (!slots[slot_idx].isFree() && !slots[slot_idx].isValid()) {
+            DPRINTF(GOV, "%s: Can't shrink node (%d,%d), slot %d is busy\n",
+                    gov_type, host_pmmu->getNodeID() / num_column,
+                    host_pmmu->getNodeID() % num_column, slot_idx);
+            return host_pmmu->getSPMSizePages();
+        }
+    }
+
+    // the pages on the slots given back to the cache go off chip
+    for (int slot_idx = num_slots; slot_idx < host_pmmu->getSPMSizePages(); slot_idx++) {
+        if (slots[slot_idx].isFree()) {
+            continue;
+        }
+
+        PMMU *user_pmmu = PMMU::getPMMU(slots[slot_idx].getOwner());
+        HostInfo current_host_info (nullptr, user_pmmu, host_pmmu,
+                                    slot_idx * host_pmmu->getPageSizeBytes(), 1);
+        BaseCPU *user_cpu = dynamic_cast<BaseCPU*>((user_pmmu->my_spm_ptr->
+                            getSlavePort("cpu_side", 0).getMasterPort()).getOwner());
+        current_host_info.setUserThreadContext(user_cpu->getContext(0));
+        current_host_info.setDeallocMode(WRITE_BACK);
+        dallocation_helper_spm_address(&current_host_info);
+    }
+
+    // the cache keeps the ways while it can't evict their blocks, the
+    // program tries again
+    if (!host_spm->setSPMWays(num_ways)) {
+        DPRINTF(GOV, "%s: Can't grow node (%d,%d), its cache is busy\n",
+                gov_type, host_pmmu->getNodeID() / num_column,
+                host_pmmu->getNodeID() % num_column);
+        return host_pmmu->getSPMSizePages();
+    }
+
+    DPRINTF(GOV, "%s: Node (%d,%d) has %d cache way(s) as %d SPM slot(s)\n",
+            gov_type, host_pmmu->getNodeID() / num_column,
+            host_pmmu->getNodeID() % num_column, num_ways,
+            host_pmmu->getSPMSizePages());
+
+    return host_pmmu->getSPMSizePages();
+}
+
+void
+BaseGovernor::collapseReplicas(PMMU *writer_pmmu, uint64_t asid, Addr v_page_addr)
+{
+    panic("%s: Node %d wrote to replicated page %#x, but the governor "
+          "doesn't replicate pages\n", gov_type, writer_pmmu->getNodeID(),
+          v_page_addr);
+}
+
 bool
-BaseGovernor::getMaxContiguousFreePages(HostInfo *host_info, int max_num_pages_needed, int start_page_index)
+BaseGovernor::isTransferable(GOVRequest *gov_request, PMMU *consumer_pmmu,
+                             int page_index, bool duplicate)
+{
+    uint64_t asid = gov_request->getASID();
+    Addr v_page_addr = gov_request->getNthPageStartAddr(Unserved_Aligned, page_index);
+
+    ATTEntry *mapping = gov_request->getPMMUPtr()->my_att->getMapping(asid, v_page_addr);
+    if (!mapping || !mapping->data_valid ||
+        consumer_pmmu->my_att->hasMapping(asid, v_page_addr)) {
+        return false;
+    }
+
+    // a page allocated more than once stays with the requester, a copy
+    // doesn't take it away
+    return duplicate || mapping->num_owners == 1;
+}
+
+int
+BaseGovernor::handoff_helper_virtual_address(GOVRequest *gov_request,
+                                             PMMU *consumer_pmmu)
 {
-    bool satisfied = false;
-    int ctr;
-    int current_max = 0;
-    int max_num_pages_found = 0;
-    Addr current_base_found = Addr(0);
-    Addr base_max_free_pages_found = Addr(0);
-
-    for (ctr = start_page_index; ctr < host_info->getHostPMMU()->getSPMSizePages(); ctr++) {
-        if (!host_info->getHostPMMU()->my_spm_ptr->spmSlots[ctr].isFree()){
-            current_max = 0;
-            current_base_found = Addr((ctr + 1) * host_info->getHostPMMU()->getPageSizeBytes());
-        } else {
-            current_max++;
+    PMMU *requester_pmmu = gov_request->getPMMUPtr();
+    int num_moved_pages = consumer_pmmu->takeOverATTMappingsVAddress(gov_request,
+                                                                     requester_pmmu);
+
+    // the pages are brought to the consumer's spm as far as it has room,
+    // the rest are used where they are
+    const uint64_t asid = gov_request->getASID();
+    const Addr start_v_page_addr = gov_request->getStartAddr(Unserved_Aligned);
+    const int page_size = gov_request->getPageSizeBytes();
+
+    int page_index = 0;
+    while (page_index < num_moved_pages) {
+
+        int run_length = 0;
+        while (page_index + run_length < num_moved_pages &&
+               consumer_pmmu->my_att->getMapping(asid, start_v_page_addr +
+                   (page_index + run_length)*page_size)->destination_node.num !=
+               consumer_pmmu->getNodeID()) {
+            run_length++;
         }
 
-        if (current_max > max_num_pages_found) {
-            max_num_pages_found = current_max;
-            base_max_free_pages_found = current_base_found;
+        if (run_length == 0) {
+            page_index++;
+            continue;
         }
 
-        if (max_num_pages_found >= max_num_pages_needed) {
-            satisfied = true;
+        HostInfo future_host_info (nullptr, consumer_pmmu, consumer_pmmu, Addr(0), 0);
+        getMaxContiguousFreePages(&future_host_info, run_length);
+        int num_pages = std::min(future_host_info.getNumPages(), run_length);
+        if (num_pages == 0) {
             break;
         }
+        future_host_info.setNumPages(num_pages);
+
+        Addr run_start = start_v_page_addr + page_index*page_size;
+        GOVRequest run_request (gov_request->getThreadContext(), Relocation,
+                                run_start, run_start + num_pages*page_size, 0);
+        run_request.setASID(gov_request->getASID());
+        HostInfo current_host_info (gov_request->getThreadContext(), consumer_pmmu,
+                                    nullptr, Addr(0), num_pages);
+
+        consumer_pmmu->changeATTMappingVAddress(&run_request, &current_host_info,
+                                                &future_host_info);
+        consumer_pmmu->setUsedPages(future_host_info.getSPMaddress(), num_pages,
+                                    consumer_pmmu->getNodeID());
+
+        DPRINTF(GOV, "%s: Relocating %d handed off SPM slot(s) to node (%d,%d) "
+                "starting from slot address = %u\n",
+                gov_type, num_pages,
+                consumer_pmmu->getNodeID() / num_column,
+                consumer_pmmu->getNodeID() % num_column,
+                future_host_info.getSPMaddress());
+
+        page_index += num_pages;
     }
 
-    host_info->setNumPages(max_num_pages_found);
-    host_info->setSPMaddress(base_max_free_pages_found);
+    return num_moved_pages;
+}
+
+int
+BaseGovernor::copy_helper_virtual_address(GOVRequest *gov_request,
+                                          PMMU *consumer_pmmu)
+{
+    PMMU *requester_pmmu = gov_request->getPMMUPtr();
+    const int total_num_pages = gov_request->getNumberOfPages(Unserved_Aligned);
+    const Addr start_v_page_addr = gov_request->getStartAddr(Unserved_Aligned);
+    const int page_size = gov_request->getPageSizeBytes();
+
+    // copies only go to the consumer's own spm, pages it has no room for
+    // are left out
+    int num_copied_pages = 0;
+    while (num_copied_pages < total_num_pages) {
+
+        HostInfo future_host_info (nullptr, consumer_pmmu, consumer_pmmu, Addr(0), 0);
+        getMaxContiguousFreePages(&future_host_info, total_num_pages - num_copied_pages);
+        int num_pages = std::min(future_host_info.getNumPages(),
+                                 total_num_pages - num_copied_pages);
+        if (num_pages == 0) {
+            break;
+        }
+        future_host_info.setNumPages(num_pages);
+
+        Addr run_start = start_v_page_addr + num_copied_pages*page_size;
+        GOVRequest run_request (gov_request->getThreadContext(), Relocation,
+                                run_start, run_start + num_pages*page_size, 0);
+        run_request.setASID(gov_request->getASID());
+
+        int num_added_pages = consumer_pmmu->copyATTMappingsVAddress(&run_request,
+                                                                     requester_pmmu,
+                                                                     &future_host_info);
+        consumer_pmmu->setUsedPages(future_host_info.getSPMaddress(), num_added_pages,
+                                    consumer_pmmu->getNodeID());
+
+        DPRINTF(GOV, "%s: Copying %d/%d SPM slot(s) to node (%d,%d) "
+                "starting from slot address = %u\n",
+                gov_type, num_added_pages, num_pages,
+                consumer_pmmu->getNodeID() / num_column,
+                consumer_pmmu->getNodeID() % num_column,
+                future_host_info.getSPMaddress());
+
+        num_copied_pages += num_added_pages;
+        if (num_added_pages < num_pages) {
+            // the consumer's ATT is full
+            break;
+        }
+    }
+
+    return num_copied_pages;
+}
+
+bool
+BaseGovernor::getMaxContiguousFreePages(HostInfo *host_info, int max_num_pages_needed, int start_page_index)
+{
+    PMMU *host_pmmu = host_info->getHostPMMU();
+    unsigned run_start, run_length;
+
+    // first fit, or else the largest free run of the host spm
+    bool satisfied = host_pmmu->my_spm_ptr->freePageIndex.findFreeRun(
+                         std::max(max_num_pages_needed, 0), start_page_index,
+                         run_start, run_length);
+
+    host_info->setNumPages(run_length);
+    host_info->setSPMaddress(Addr(run_start * host_pmmu->getPageSizeBytes()));
 
     return satisfied;
 }
@@ -97,6 +355,7 @@ BaseGovernor::allocation_helper_on_free_pages(GOVRequest *gov_request,
         getMaxContiguousFreePages(host_info, remaining_pages);
 
         if (host_info->getNumPages() > 0) {
+            int num_found_pages = host_info->getNumPages();
             int num_added_pages = requester_pmmu->addATTMappingsVAddress(gov_request, host_info);
             host_info->getHostPMMU()->setUsedPages(host_info->getSPMaddress(), num_added_pages,
                                                    gov_request->getRequesterNodeID());
@@ -112,6 +371,11 @@ BaseGovernor::allocation_helper_on_free_pages(GOVRequest *gov_request,
 
             gov_request->incPagesServed(host_info->getNumPages());
             remaining_pages -= host_info->getNumPages();
+
+            // the ATT of the requester is full, no spm can take the rest
+            if (host_info->getNumPages() < num_found_pages) {
+                break;
+            }
         }
         else {
             // no more space on this spm OR all pages are already mapped on chip
@@ -231,9 +495,10 @@ BaseGovernor::add_mapping_unallocated_pages(GOVRequest *gov_request)
             requester_pmmu->getNodeID() / num_column,
             requester_pmmu->getNodeID() % num_column);
 
-    gov_request->incPagesServed(total_num_pages);
+    // a full ATT leaves the rest of the pages unmapped
+    gov_request->incPagesServed(host_info.getNumPages());
 
-    assert(num_added_pages == total_num_pages);
+    assert(num_added_pages == host_info.getNumPages());
 }
 
 void
@@ -241,6 +506,7 @@ BaseGovernor::cache_invalidator_helper(GOVRequest *gov_request)
 {
     SPM *requester_spm = gov_request->getSPMPtr();
     FuncPageTable *requester_pt = gov_request->getPageTablePtr();
+    GOVNodeContext node_context(gov_request->getPMMUPtr());
     Addr aligned_start_addr = gov_request->getStartAddr(Unserved_Aligned);
     Addr aligned_end_addr = gov_request->getEndAddr(Unserved_Aligned);
 
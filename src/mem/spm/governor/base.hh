@@ -5,6 +5,7 @@
 #include "cpu/thread_context.hh"
 #include "debug/GOV.hh"
 #include "mem/spm/api/spm_types.h"
+#include "mem/spm/governor/GOVLock.hh"
 #include "mem/spm/governor/GOVRequest.hh"
 #include "mem/spm/pmmu.hh"
 #include "mem/spm/spm_class/spm.hh"
@@ -28,6 +29,15 @@ class BaseGovernor : public SimObject {
     // SPM APIs
     virtual int allocate(GOVRequest *gov_request) = 0;
     virtual int deAllocate(GOVRequest *gov_request) = 0;
+    // hands off or copies on-chip pages of the requester to another node
+    virtual int transfer(GOVRequest *gov_request);
+    // gives the spm of host_pmmu num_ways of the cache it shares its
+    // array with, returns the number of slots it has afterwards
+    virtual int resize(PMMU *host_pmmu, unsigned num_ways);
+    // called by a pmmu writing to a replicated page, the copy the writer
+    // maps is left as the only one
+    virtual void collapseReplicas(PMMU *writer_pmmu, uint64_t asid,
+                                  Addr v_page_addr);
 
   protected:
     // dimensions of the mesh
@@ -64,6 +74,17 @@ class BaseGovernor : public SimObject {
     virtual void relocation_helper_spm_address(HostInfo *current_host_info,
                                                HostInfo *future_host_info);
 
+    // SPM to SPM transfer primitives, on runs of pages the requester has
+    // on chip and the consumer has no mapping for
+    bool isTransferable(GOVRequest *gov_request, PMMU *consumer_pmmu,
+                        int page_index, bool duplicate);
+
+    virtual int handoff_helper_virtual_address(GOVRequest *gov_request,
+                                               PMMU *consumer_pmmu);
+
+    virtual int copy_helper_virtual_address(GOVRequest *gov_request,
+                                            PMMU *consumer_pmmu);
+
     virtual void add_mapping_unallocated_pages(GOVRequest *gov_request);
 
     virtual void cache_invalidator_helper(GOVRequest *gov_request);
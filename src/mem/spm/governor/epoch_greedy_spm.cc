@@ -0,0 +1,149 @@
+#include "mem/spm/governor/epoch_greedy_spm.hh"
+
+#include <algorithm>
+#include <iostream>
+
+EpochGreedySPM::EpochGreedySPM(const Params *p, Tick _epoch)
+    : GreedySPM(p),
+      epoch(_epoch),
+      epochEvent([this]{ processEpoch(); }, name()),
+      restored_epoch_tick(0)
+{
+}
+
+EpochGreedySPM::~EpochGreedySPM()
+{
+
+}
+
+void
+EpochGreedySPM::init()
+{
+    GreedySPM::init();
+
+    slot_samples.assign(pmmu_by_node.size(), vector<SlotSample>());
+    for (auto p : pmmus) {
+        slot_samples[p->getNodeID()].assign(p->getSPMMaxPages(), SlotSample{0, 0, 0});
+    }
+}
+
+void
+EpochGreedySPM::startup()
+{
+    if (restored_epoch_tick) {
+        schedule(epochEvent, std::max(restored_epoch_tick, curTick()));
+    }
+    else if (epoch > 0 && !pmmus.empty()) {
+        schedule(epochEvent, curTick() + epoch);
+    }
+}
+
+void
+EpochGreedySPM::serialize(CheckpointOut &cp) const
+{
+    vector<uint64_t> ref_counts;
+    vector<uint64_t> fault_counts;
+    vector<Tick> ticks_inserted;
+    for (auto &samples : slot_samples) {
+        for (auto &sample : samples) {
+            ref_counts.push_back(sample.ref_count);
+            fault_counts.push_back(sample.fault_count);
+            ticks_inserted.push_back(sample.tick_inserted);
+        }
+    }
+    SERIALIZE_CONTAINER(ref_counts);
+    SERIALIZE_CONTAINER(fault_counts);
+    SERIALIZE_CONTAINER(ticks_inserted);
+
+    Tick next_epoch = epochEvent.scheduled() ? epochEvent.when() : 0;
+    SERIALIZE_SCALAR(next_epoch);
+}
+
+void
+EpochGreedySPM::unserialize(CheckpointIn &cp)
+{
+    vector<uint64_t> ref_counts;
+    vector<uint64_t> fault_counts;
+    vector<Tick> ticks_inserted;
+    UNSERIALIZE_CONTAINER(ref_counts);
+    UNSERIALIZE_CONTAINER(fault_counts);
+    UNSERIALIZE_CONTAINER(ticks_inserted);
+
+    vector<uint64_t>::size_type num_slots = 0;
+    for (auto &samples : slot_samples) {
+        num_slots += samples.size();
+    }
+    if (ref_counts.size() != num_slots || fault_counts.size() != num_slots ||
+        ticks_inserted.size() != num_slots)
+        fatal("%s: the SPM configuration changed since the checkpoint\n",
+              name());
+
+    vector<uint64_t>::size_type i = 0;
+    for (auto &samples : slot_samples) {
+        for (auto &sample : samples) {
+            sample.ref_count = ref_counts[i];
+            sample.fault_count = fault_counts[i];
+            sample.tick_inserted = ticks_inserted[i];
+            i++;
+        }
+    }
+
+    Tick next_epoch;
+    UNSERIALIZE_SCALAR(next_epoch);
+    restored_epoch_tick = next_epoch;
+}
+
+int
+EpochGreedySPM::allocate(GOVRequest *gov_request)
+{
+    printRequestStatus(gov_request);
+
+    const int total_num_pages = gov_request->getNumberOfPages(Unserved_Aligned);
+    if (total_num_pages <= 0) {
+        return 0;
+    }
+
+    // GreedySPM leaves these to its subclasses, none of ours overrides
+    // allocate
+    if (hybrid_mem) {
+        cache_invalidator_helper(gov_request);
+    }
+
+    int num_allocated_pages = GreedySPM::allocate(gov_request);
+
+    if (uncacheable_spm) {
+        add_mapping_unallocated_pages(gov_request);
+    }
+
+    return num_allocated_pages;
+}
+
+EpochGreedySPM::SlotSample
+EpochGreedySPM::sampleSlot(PMMU *host_pmmu, int slot_idx)
+{
+    SPMPage *page = &host_pmmu->my_spm_ptr->spmSlots[slot_idx];
+    SlotSample &sample = slot_samples[host_pmmu->getNodeID()][slot_idx];
+
+    uint64_t ref_count = page->getRefCount();
+    uint64_t fault_count = page->getFaultCount();
+    SlotSample epoch_sample{ref_count, fault_count, page->getTickInserted()};
+    if (sample.tick_inserted == page->getTickInserted() &&
+        ref_count >= sample.ref_count && fault_count >= sample.fault_count) {
+        epoch_sample.ref_count = ref_count - sample.ref_count;
+        epoch_sample.fault_count = fault_count - sample.fault_count;
+    }
+
+    sample.ref_count = ref_count;
+    sample.fault_count = fault_count;
+    sample.tick_inserted = page->getTickInserted();
+
+    return epoch_sample;
+}
+
+void
+EpochGreedySPM::processEpoch()
+{
+    runEpoch();
+
+    schedule(epochEvent, curTick() + epoch);
+}
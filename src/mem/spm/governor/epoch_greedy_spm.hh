@@ -0,0 +1,55 @@
+/* This class is the base of the SPM governors which greedily map the
+ * allocation requests to the closest free on-chip SPM, and then look at
+ * every slot once an epoch to act on how its page was used. It samples the
+ * accesses and faulty accesses of every slot, so that the governors get the
+ * ones of the last epoch, checkpoints the samples, and runs runEpoch() every
+ * epoch (never if the epoch is zero).
+ * */
+
+#ifndef __EPOCH_GREEDY_SPM_HH__
+#define __EPOCH_GREEDY_SPM_HH__
+
+#include "mem/spm/governor/greedy_spm.hh"
+#include "sim/eventq.hh"
+
+class EpochGreedySPM : public GreedySPM {
+
+  public:
+    EpochGreedySPM(const Params *p, Tick _epoch);
+    virtual ~EpochGreedySPM();
+    virtual void init();
+    virtual void startup();
+
+    // the samples of the epoch and the next round
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+
+    virtual int allocate(GOVRequest *gov_request);
+
+  protected:
+    Tick epoch;
+
+    // counts of a slot, indexed by host node id and slot; tickInserted
+    // tells a reused slot apart
+    struct SlotSample
+    {
+        uint64_t ref_count;
+        uint64_t fault_count;
+        Tick tick_inserted;
+    };
+    vector<vector<SlotSample>> slot_samples;
+
+    // accesses and faulty accesses of the slot since the last call,
+    // to be called once per slot and epoch
+    SlotSample sampleSlot(PMMU *host_pmmu, int slot_idx);
+
+    // the work of the epoch, the next one is scheduled afterwards
+    virtual void runEpoch() = 0;
+
+  private:
+    EventFunctionWrapper epochEvent;
+    Tick restored_epoch_tick;  // zero unless restored from a checkpoint
+    void processEpoch();
+};
+
+#endif  /* __EPOCH_GREEDY_SPM_HH__ */
@@ -18,14 +18,6 @@ class GreedySPM : public RandomSPM {
     virtual void init();
 
     virtual int allocate(GOVRequest *gov_request);
-    virtual void addPMMU(PMMU *p);
-
-  protected:
-    map<PMMU *, pair<int,int>> pmmu_to_coord;
-
-    int findHopDistance (pair <int, int> pmmu_o, pair <int, int> pmmu_h);
-    void distanceBasedSort(pair <int, int> central_pmmu);
-
 };
 
 #endif  /* __GREEDY_SPM_HH__ */
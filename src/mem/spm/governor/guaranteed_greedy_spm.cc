@@ -26,7 +26,7 @@ GuaranteedGreedySPM::~GuaranteedGreedySPM()
 void
 GuaranteedGreedySPM::init()
 {
-
+    GreedySPM::init();
 }
 
 /* What percentage of owner_pmmu's spm is used by user_pmmu? */
@@ -109,9 +109,7 @@ GuaranteedGreedySPM::findGuestSlotToRelocate(HostInfo *current_host_info, string
     }
 
     NodeID user_id = current_host_info->getHostPMMU()->my_spm_ptr->spmSlots[candidate_slot_idx].getOwner();
-    int user_col = user_id % num_column;
-    int user_row = user_id / num_column;
-    current_host_info->setUserPMMU(coord_to_pmmu[make_pair(user_col,user_row)]);
+    current_host_info->setUserPMMU(getPMMU(user_id));
     BaseCPU *user_cpu = dynamic_cast<BaseCPU*>(((current_host_info->getUserPMMU())->
                         my_spm_ptr->getSlavePort("cpu_side", 0).getMasterPort()).getOwner());
     current_host_info->setUserThreadContext(user_cpu->getContext(0));
@@ -123,16 +121,15 @@ GuaranteedGreedySPM::findGuestSlotToRelocate(HostInfo *current_host_info, string
 bool
 GuaranteedGreedySPM::findClosestFreeSlots(HostInfo *future_host_info)
 {
-    PMMU *previous_center = pmmus[0];
     bool found = false;
     future_host_info->setHostPMMU(nullptr);
 
-    distanceBasedSort(pmmu_to_coord.at(future_host_info->getUserPMMU()));
-    assert(future_host_info->getUserPMMU() == pmmus[0]);
+    auto closest = closestPMMUs(future_host_info->getUserPMMU());
+    assert(future_host_info->getUserPMMU() == *closest);
 
     vector<PMMU *>::size_type pmmu_it = 0;
     while (pmmu_it != pmmus.size()) {
-        future_host_info->setHostPMMU(pmmus[pmmu_it]);
+        future_host_info->setHostPMMU(closest[pmmu_it]);
 
         int pages_needed = future_host_info->getNumPages();
 
@@ -158,8 +155,6 @@ GuaranteedGreedySPM::findClosestFreeSlots(HostInfo *future_host_info)
         pmmu_it++;
     }
 
-    distanceBasedSort(pmmu_to_coord.at(previous_center));
-
     if (!found) {
         future_host_info->setHostPMMU(nullptr);
     }
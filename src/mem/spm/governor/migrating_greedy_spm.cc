@@ -0,0 +1,173 @@
+#include "mem/spm/governor/migrating_greedy_spm.hh"
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+MigratingGreedySPM *
+MigratingGreedySPMParams::create()
+{
+    return new MigratingGreedySPM(this);
+}
+
+MigratingGreedySPM::MigratingGreedySPM(const Params *p)
+    : EpochGreedySPM(p, p->migration_epoch),
+      migration_budget(p->migration_budget),
+      migration_threshold(p->migration_threshold)
+{
+    gov_type = "MigratingGreedy";
+}
+
+MigratingGreedySPM::~MigratingGreedySPM()
+{
+
+}
+
+void
+MigratingGreedySPM::regStats()
+{
+    EpochGreedySPM::regStats();
+
+    migration_epochs
+        .name(name() + ".migration_epochs")
+        .desc("Number of migration epochs")
+        ;
+
+    migration_candidates
+        .name(name() + ".migration_candidates")
+        .desc("Number of remote pages that were hot enough to be migrated")
+        ;
+
+    migrated_pages
+        .name(name() + ".migrated_pages")
+        .desc("Number of pages migrated closer to their user")
+        ;
+
+    migration_hops_saved
+        .name(name() + ".migration_hops_saved")
+        .desc("Sum of the hop distances saved by migrations")
+        ;
+}
+
+bool
+MigratingGreedySPM::findCloserFreeSlot(HostInfo *future_host_info,
+                                       PMMU *current_host_pmmu)
+{
+    PMMU *user_pmmu = future_host_info->getUserPMMU();
+    int current_distance = hopDistance(user_pmmu->getNodeID(),
+                                       current_host_pmmu->getNodeID());
+
+    auto closest = closestPMMUs(user_pmmu);
+
+    vector<PMMU *>::size_type pmmu_it = 0;
+    while (pmmu_it != pmmus.size() &&
+           hopDistance(user_pmmu->getNodeID(),
+                       closest[pmmu_it]->getNodeID()) < current_distance) {
+        future_host_info->setHostPMMU(closest[pmmu_it]);
+        if (getMaxContiguousFreePages(future_host_info, 1)) {
+            return true;
+        }
+
+        // getMaxContiguousFreePages() reassigns the value
+        future_host_info->setNumPages(1);
+        pmmu_it++;
+    }
+
+    future_host_info->setHostPMMU(nullptr);
+    return false;
+}
+
+bool
+MigratingGreedySPM::migrateSlot(const MigrationCandidate &candidate, NodeID user_id)
+{
+    PMMU *user_pmmu = getPMMU(user_id);
+
+    HostInfo future_host_info (nullptr, user_pmmu, nullptr, Addr(0), 1);
+    if (!findCloserFreeSlot(&future_host_info, candidate.host_pmmu)) {
+        return false;
+    }
+
+    HostInfo current_host_info (nullptr, user_pmmu, candidate.host_pmmu,
+                                candidate.slot_idx * user_pmmu->getPageSizeBytes(), 1);
+    BaseCPU *user_cpu = dynamic_cast<BaseCPU*>((user_pmmu->my_spm_ptr->
+                        getSlavePort("cpu_side", 0).getMasterPort()).getOwner());
+    current_host_info.setUserThreadContext(user_cpu->getContext(0));
+
+    DPRINTF(GOV, "%s: Migrating slot %d on node (%d,%d) accessed %d time(s) "
+            "by node (%d,%d) to node (%d,%d)\n",
+            gov_type, candidate.slot_idx,
+            candidate.host_pmmu->getNodeID() / num_column,
+            candidate.host_pmmu->getNodeID() % num_column,
+            candidate.epoch_refs,
+            user_id / num_column, user_id % num_column,
+            future_host_info.getHostPMMU()->getNodeID() / num_column,
+            future_host_info.getHostPMMU()->getNodeID() % num_column);
+
+    relocation_helper_spm_address(&current_host_info, &future_host_info);
+
+    migration_hops_saved += hopDistance(user_id, candidate.host_pmmu->getNodeID()) -
+                            hopDistance(user_id, future_host_info.getHostPMMU()->getNodeID());
+    return true;
+}
+
+void
+MigratingGreedySPM::runEpoch()
+{
+    // the pages of every node are looked at, with all of them paused
+    GOVLock gov_lock;
+
+    migration_epochs++;
+
+    // 1. rank the guest pages of every requester by their accesses in this epoch
+    map<NodeID, vector<MigrationCandidate>> candidates;
+    for (auto host_pmmu : pmmus) {
+        SPMPage *slots = host_pmmu->my_spm_ptr->spmSlots;
+        for (int slot_idx = 0; slot_idx < host_pmmu->getSPMSizePages(); slot_idx++) {
+            if (slots[slot_idx].isFree()) {
+                continue;
+            }
+
+            uint64_t epoch_refs = sampleSlot(host_pmmu, slot_idx).ref_count;
+
+            // pages still being filled or relocated are left alone
+            NodeID user_id = slots[slot_idx].getOwner();
+            if (user_id == host_pmmu->getNodeID() || !slots[slot_idx].isValid() ||
+                epoch_refs < migration_threshold) {
+                continue;
+            }
+
+            candidates[user_id].push_back(MigrationCandidate{host_pmmu, slot_idx, epoch_refs});
+            migration_candidates++;
+        }
+    }
+
+    for (auto &entry : candidates) {
+        stable_sort(entry.second.begin(), entry.second.end(),
+                    [](const MigrationCandidate &a, const MigrationCandidate &b)
+                    { return a.epoch_refs > b.epoch_refs; });
+    }
+
+    // 2. take the hottest page of each requester in turn, so that one
+    // requester can't use up the whole budget
+    unsigned budget = migration_budget;
+    vector<MigrationCandidate>::size_type rank = 0;
+    bool candidates_left = true;
+    while (budget > 0 && candidates_left) {
+        candidates_left = false;
+        for (auto &entry : candidates) {
+            if (budget == 0) {
+                break;
+            }
+            if (rank >= entry.second.size()) {
+                continue;
+            }
+            candidates_left = true;
+
+            if (migrateSlot(entry.second[rank], entry.first)) {
+                migrated_pages++;
+                budget--;
+            }
+        }
+        rank++;
+    }
+}
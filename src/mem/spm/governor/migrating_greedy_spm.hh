@@ -0,0 +1,46 @@
+/* This class implements an SPM governor which greedily maps the allocation
+ * requests to the closest free on-chip SPM, and then periodically migrates
+ * the pages that are hammered by a remote node to free slots closer to it.
+ * Every epoch, the guest pages of each requester are ranked by the number
+ * of accesses they received during the epoch, and the hottest ones are
+ * relocated, at most migration_budget pages per epoch.
+ * */
+
+#ifndef __MIGRATING_GREEDY_SPM_HH__
+#define __MIGRATING_GREEDY_SPM_HH__
+
+#include "params/MigratingGreedySPM.hh"
+#include "mem/spm/governor/epoch_greedy_spm.hh"
+
+class MigratingGreedySPM : public EpochGreedySPM {
+
+  public:
+    MigratingGreedySPM(const Params *p);
+    virtual ~MigratingGreedySPM();
+    virtual void regStats();
+
+  protected:
+    unsigned migration_budget;
+    unsigned migration_threshold;
+
+    // a remote page and the accesses it received during the last epoch
+    struct MigrationCandidate
+    {
+        PMMU *host_pmmu;
+        int slot_idx;
+        uint64_t epoch_refs;
+    };
+
+    // migrates the hottest remote pages of the epoch
+    void runEpoch() override;
+
+    bool findCloserFreeSlot(HostInfo *future_host_info, PMMU *current_host_pmmu);
+    bool migrateSlot(const MigrationCandidate &candidate, NodeID user_id);
+
+    Stats::Scalar migration_epochs;
+    Stats::Scalar migration_candidates;
+    Stats::Scalar migrated_pages;
+    Stats::Scalar migration_hops_saved;
+};
+
+#endif  /* __MIGRATING_GREEDY_SPM_HH__ */
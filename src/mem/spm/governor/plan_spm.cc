@@ -0,0 +1,376 @@
+#include "mem/spm/governor/plan_spm.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "mem/spm/att.hh"
+
+PlanSPM *
+PlanSPMParams::create()
+{
+    return new PlanSPM(this);
+}
+
+PlanSPM::PlanSPM(const Params *p)
+    : GreedySPM(p),
+      plan_file(p->plan_file),
+      next_epoch(0),
+      replayEvent([this]{ replay(); }, name())
+{
+    gov_type = "Plan";
+}
+
+PlanSPM::~PlanSPM()
+{
+
+}
+
+void
+PlanSPM::init()
+{
+    GreedySPM::init();
+
+    loadPlan();
+
+    for (auto &epoch : plan) {
+        for (auto &entry : epoch.hosts) {
+            NodeID user_id = std::get<0>(entry.first);
+            NodeID host_id = entry.second;
+            if (user_id >= pmmu_by_node.size() || !pmmu_by_node[user_id] ||
+                host_id >= pmmu_by_node.size() || !pmmu_by_node[host_id]) {
+                fatal("%s: plan %s doesn't match the spm nodes of this "
+                      "system\n", gov_type, plan_file);
+            }
+        }
+    }
+}
+
+void
+PlanSPM::loadPlan()
+{
+    if (plan_file.empty()) {
+        fatal("%s: no plan file given\n", gov_type);
+    }
+
+    std::ifstream plan_stream(plan_file);
+    if (!plan_stream) {
+        fatal("%s: can't open plan file %s\n", gov_type, plan_file);
+    }
+
+    // "epoch <start tick>" opens the placement of an epoch, followed by
+    // one "<node> <asid> <vpage> <host>" line per page placed on chip
+    std::string line;
+    int line_num = 0;
+    while (std::getline(plan_stream, line)) {
+        line_num++;
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first)) {
+            continue;
+        }
+
+        if (first == "epoch") {
+            PlanEpoch epoch;
+            if (!(fields >> epoch.start) ||
+                (!plan.empty() && epoch.start <= plan.back().start)) {
+                fatal("%s: %s:%d: bad epoch\n", gov_type, plan_file, line_num);
+            }
+            plan.push_back(epoch);
+            continue;
+        }
+
+        std::string asid, vpage;
+        NodeID host;
+        if (plan.empty() || !(fields >> asid >> vpage >> host)) {
+            fatal("%s: %s:%d: bad page placement\n",
+                  gov_type, plan_file, line_num);
+        }
+
+        PageKey key(std::stoul(first), std::stoull(asid, nullptr, 0),
+                    PMMU::spmPageAlign(std::stoull(vpage, nullptr, 0)));
+        plan.back().hosts[key] = host;
+    }
+
+    DPRINTF(GOV, "%s: Loaded %d epoch(s) from %s\n",
+            gov_type, plan.size(), plan_file);
+}
+
+void
+PlanSPM::startup()
+{
+    if (next_epoch < plan.size()) {
+        schedule(replayEvent, std::max(plan[next_epoch].start, curTick()));
+    }
+}
+
+void
+PlanSPM::serialize(CheckpointOut &cp) const
+{
+    vector<NodeID> placed_nodes;
+    vector<uint64_t> placed_asids;
+    vector<Addr> placed_vpages;
+    vector<NodeID> placed_hosts;
+    vector<Addr> placed_spm_addrs;
+    for (auto &entry : placed) {
+        placed_nodes.push_back(std::get<0>(entry.first));
+        placed_asids.push_back(std::get<1>(entry.first));
+        placed_vpages.push_back(std::get<2>(entry.first));
+        placed_hosts.push_back(entry.second.host);
+        placed_spm_addrs.push_back(entry.second.spm_addr);
+    }
+    SERIALIZE_CONTAINER(placed_nodes);
+    SERIALIZE_CONTAINER(placed_asids);
+    SERIALIZE_CONTAINER(placed_vpages);
+    SERIALIZE_CONTAINER(placed_hosts);
+    SERIALIZE_CONTAINER(placed_spm_addrs);
+
+    uint64_t replayed_epochs = next_epoch;
+    SERIALIZE_SCALAR(replayed_epochs);
+}
+
+void
+PlanSPM::unserialize(CheckpointIn &cp)
+{
+    vector<NodeID> placed_nodes;
+    vector<uint64_t> placed_asids;
+    vector<Addr> placed_vpages;
+    vector<NodeID> placed_hosts;
+    vector<Addr> placed_spm_addrs;
+    UNSERIALIZE_CONTAINER(placed_nodes);
+    UNSERIALIZE_CONTAINER(placed_asids);
+    UNSERIALIZE_CONTAINER(placed_vpages);
+    UNSERIALIZE_CONTAINER(placed_hosts);
+    UNSERIALIZE_CONTAINER(placed_spm_addrs);
+
+    placed.clear();
+    for (vector<NodeID>::size_type i = 0; i < placed_nodes.size(); i++) {
+        PageKey key(placed_nodes[i], placed_asids[i], placed_vpages[i]);
+        placed[key] = Placement{placed_hosts[i], placed_spm_addrs[i]};
+    }
+
+    uint64_t replayed_epochs;
+    UNSERIALIZE_SCALAR(replayed_epochs);
+    next_epoch = replayed_epochs;
+}
+
+void
+PlanSPM::regStats()
+{
+    GreedySPM::regStats();
+
+    plan_epochs
+        .name(name() + ".plan_epochs")
+        .desc("Number of plan epochs replayed")
+        ;
+
+    plan_allocated_pages
+        .name(name() + ".plan_allocated_pages")
+        .desc("Number of pages allocated by the plan")
+        ;
+
+    plan_relocated_pages
+        .name(name() + ".plan_relocated_pages")
+        .desc("Number of pages moved to another host by the plan")
+        ;
+
+    plan_deallocated_pages
+        .name(name() + ".plan_deallocated_pages")
+        .desc("Number of pages deallocated by the plan")
+        ;
+
+    plan_skipped_pages
+        .name(name() + ".plan_skipped_pages")
+        .desc("Number of planned pages that couldn't be placed")
+        ;
+}
+
+int
+PlanSPM::allocate(GOVRequest *gov_request)
+{
+    printRequestStatus(gov_request);
+
+    const int total_num_pages = gov_request->getNumberOfPages(Unserved_Aligned);
+    if (total_num_pages <= 0) {
+        return 0;
+    }
+
+    if (!gov_type.compare("Plan") && hybrid_mem) {
+        cache_invalidator_helper(gov_request);
+    }
+
+    int num_allocated_pages = GreedySPM::allocate(gov_request);
+
+    if (!gov_type.compare("Plan") && uncacheable_spm) {
+        add_mapping_unallocated_pages(gov_request);
+    }
+
+    return num_allocated_pages;
+}
+
+/* The context of the user node running the address space, if any */
+ThreadContext *
+PlanSPM::findThreadContext(PMMU *user_pmmu, uint64_t asid)
+{
+    BaseCPU *user_cpu = dynamic_cast<BaseCPU*>((user_pmmu->my_spm_ptr->
+                        getSlavePort("cpu_side", 0).getMasterPort()).getOwner());
+
+    for (int i = 0; i < user_cpu->numContexts(); i++) {
+        ThreadContext *tc = user_cpu->getContext(i);
+        if (tc->getProcessPtr() && tc->getProcessPtr()->tgid() == asid) {
+            return tc;
+        }
+    }
+    return nullptr;
+}
+
+/* Was the page left alone by the program since the plan placed it? */
+bool
+PlanSPM::isStillPlaced(const PageKey &key, const Placement &placement)
+{
+    PMMU *user_pmmu = getPMMU(std::get<0>(key));
+    ATTEntry *mapping = user_pmmu->my_att->getMapping(std::get<1>(key),
+                                                      std::get<2>(key));
+
+    return mapping && mapping->destination_node.num == placement.host &&
+           mapping->spm_slot_addr == placement.spm_addr;
+}
+
+void
+PlanSPM::deallocatePage(const PageKey &key, const Placement &placement)
+{
+    PMMU *user_pmmu = getPMMU(std::get<0>(key));
+    ThreadContext *tc = findThreadContext(user_pmmu, std::get<1>(key));
+    if (!tc) {
+        // the address space is gone, and its mappings with it
+        return;
+    }
+
+    Addr vpage = std::get<2>(key);
+    GOVRequest gov_request (tc, Deallocation, vpage,
+                            vpage + user_pmmu->getPageSizeBytes(), 0);
+    HostInfo host_info (tc, user_pmmu, getPMMU(placement.host),
+                        placement.spm_addr, 1);
+
+    dallocation_helper_virtual_address(&gov_request, &host_info);
+    plan_deallocated_pages++;
+}
+
+bool
+PlanSPM::relocatePage(const PageKey &key, Placement &placement, NodeID host)
+{
+    PMMU *user_pmmu = getPMMU(std::get<0>(key));
+    ThreadContext *tc = findThreadContext(user_pmmu, std::get<1>(key));
+    if (!tc) {
+        return false;
+    }
+
+    HostInfo future_host_info (nullptr, user_pmmu, getPMMU(host), Addr(0), 1);
+    if (!getMaxContiguousFreePages(&future_host_info, 1)) {
+        return false;
+    }
+
+    HostInfo current_host_info (tc, user_pmmu, getPMMU(placement.host),
+                                placement.spm_addr, 1);
+    relocation_helper_spm_address(&current_host_info, &future_host_info);
+
+    placement.host = host;
+    placement.spm_addr = future_host_info.getSPMaddress();
+    plan_relocated_pages++;
+    return true;
+}
+
+bool
+PlanSPM::allocatePage(const PageKey &key, NodeID host)
+{
+    PMMU *user_pmmu = getPMMU(std::get<0>(key));
+    uint64_t asid = std::get<1>(key);
+    Addr vpage = std::get<2>(key);
+
+    // the program might not have touched the page yet, or might have
+    // put it on chip itself
+    ThreadContext *tc = findThreadContext(user_pmmu, asid);
+    Addr p_page_addr;
+    if (!tc || !dynamic_cast<FuncPageTable*>(tc->getProcessPtr()->pTable)->
+               translate(vpage, p_page_addr) ||
+        user_pmmu->my_att->getMapping(asid, vpage)) {
+        return false;
+    }
+
+    GOVRequest gov_request (tc, Allocation, vpage,
+                            vpage + user_pmmu->getPageSizeBytes(), 0);
+    HostInfo host_info (tc, user_pmmu, getPMMU(host), Addr(0), -1);
+    host_info.setAllocMode(COPY);
+
+    if (hybrid_mem) {
+        cache_invalidator_helper(&gov_request);
+    }
+
+    if (allocation_helper_on_free_pages(&gov_request, &host_info) == 0) {
+        return false;
+    }
+
+    placed[key] = Placement{host, host_info.getSPMaddress()};
+    plan_allocated_pages++;
+    return true;
+}
+
+void
+PlanSPM::replay()
+{
+    // the plan moves pages of every node, with all of them paused
+    GOVLock gov_lock;
+
+    const PlanEpoch &epoch = plan[next_epoch];
+    plan_epochs++;
+
+    DPRINTF(GOV, "%s: Replaying epoch %d of the plan, %d page(s) on chip\n",
+            gov_type, next_epoch, epoch.hosts.size());
+
+    // 1. free the pages leaving the chip first, to make room for the rest
+    vector<PageKey> to_move;
+    for (auto it = placed.begin(); it != placed.end(); ) {
+        auto planned = epoch.hosts.find(it->first);
+        if (!isStillPlaced(it->first, it->second)) {
+            it = placed.erase(it);
+        }
+        else if (planned == epoch.hosts.end()) {
+            deallocatePage(it->first, it->second);
+            it = placed.erase(it);
+        }
+        else {
+            if (planned->second != it->second.host) {
+                to_move.push_back(it->first);
+            }
+            ++it;
+        }
+    }
+
+    // 2. move the pages that changed host, or let them go
+    for (auto &key : to_move) {
+        Placement &placement = placed[key];
+        if (!relocatePage(key, placement, epoch.hosts.at(key))) {
+            deallocatePage(key, placement);
+            placed.erase(key);
+            plan_skipped_pages++;
+        }
+    }
+
+    // 3. bring the new pages on chip
+    for (auto &entry : epoch.hosts) {
+        if (placed.count(entry.first)) {
+            continue;
+        }
+        if (!allocatePage(entry.first, entry.second)) {
+            plan_skipped_pages++;
+        }
+    }
+
+    next_epoch++;
+    if (next_epoch < plan.size()) {
+        schedule(replayEvent, std::max(plan[next_epoch].start, curTick() + 1));
+    }
+}
@@ -0,0 +1,75 @@
+/* This class implements an SPM governor which replays a placement plan
+ * computed offline by util/spm_plan.py from the profile of an earlier
+ * run. The plan lists, for every epoch, the virtual pages of each node
+ * that live on chip and the node hosting them. At the start of every
+ * epoch the pages that left the plan are deallocated, the ones that
+ * changed host are relocated, and the new ones are allocated, so code
+ * without any SPM_ALLOC call can use the spms too. Explicit allocation
+ * requests are still served greedily.
+ * */
+
+#ifndef __PLAN_SPM_HH__
+#define __PLAN_SPM_HH__
+
+#include <map>
+#include <tuple>
+
+#include "params/PlanSPM.hh"
+#include "mem/spm/governor/greedy_spm.hh"
+#include "sim/eventq.hh"
+
+class PlanSPM : public GreedySPM {
+
+  public:
+    PlanSPM(const Params *p);
+    virtual ~PlanSPM();
+    virtual void init();
+    virtual void startup();
+    virtual void regStats();
+
+    // the pages placed by the plan and the next epoch to replay
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+
+    virtual int allocate(GOVRequest *gov_request);
+
+  protected:
+    std::string plan_file;
+
+    // user node, address space and virtual page of a planned page
+    typedef std::tuple<NodeID, uint64_t, Addr> PageKey;
+
+    struct PlanEpoch
+    {
+        Tick start;
+        std::map<PageKey, NodeID> hosts;
+    };
+    vector<PlanEpoch> plan;
+    vector<PlanEpoch>::size_type next_epoch;
+
+    // where the pages the plan put on chip are now
+    struct Placement
+    {
+        NodeID host;
+        Addr spm_addr;
+    };
+    std::map<PageKey, Placement> placed;
+
+    EventFunctionWrapper replayEvent;
+    void loadPlan();
+    void replay();
+
+    ThreadContext *findThreadContext(PMMU *user_pmmu, uint64_t asid);
+    bool isStillPlaced(const PageKey &key, const Placement &placement);
+    void deallocatePage(const PageKey &key, const Placement &placement);
+    bool relocatePage(const PageKey &key, Placement &placement, NodeID host);
+    bool allocatePage(const PageKey &key, NodeID host);
+
+    Stats::Scalar plan_epochs;
+    Stats::Scalar plan_allocated_pages;
+    Stats::Scalar plan_relocated_pages;
+    Stats::Scalar plan_deallocated_pages;
+    Stats::Scalar plan_skipped_pages;
+};
+
+#endif  /* __PLAN_SPM_HH__ */
@@ -0,0 +1,113 @@
+#include "mem/spm/governor/power_gating_spm.hh"
+
+#include <algorithm>
+#include <iostream>
+
+PowerGatingSPM *
+PowerGatingSPMParams::create()
+{
+    return new PowerGatingSPM(this);
+}
+
+PowerGatingSPM::PowerGatingSPM(const Params *p)
+    : EpochGreedySPM(p, p->power_epoch),
+      cold_threshold(p->cold_threshold)
+{
+    gov_type = "PowerGating";
+}
+
+PowerGatingSPM::~PowerGatingSPM()
+{
+
+}
+
+void
+PowerGatingSPM::regStats()
+{
+    EpochGreedySPM::regStats();
+
+    power_epochs
+        .name(name() + ".power_epochs")
+        .desc("Number of power management epochs")
+        ;
+
+    gated_slots
+        .name(name() + ".gated_slots")
+        .desc("Number of times a free slot was gated off")
+        ;
+
+    drowsy_slots
+        .name(name() + ".drowsy_slots")
+        .desc("Number of times a cold critical page went drowsy")
+        ;
+
+    lowered_slots
+        .name(name() + ".lowered_slots")
+        .desc("Number of times a cold approximate page moved to the least leaking operating point")
+        ;
+
+    raised_slots
+        .name(name() + ".raised_slots")
+        .desc("Number of times a hot page went back to the nominal operating point")
+        ;
+}
+
+void
+PowerGatingSPM::runEpoch()
+{
+    // the slots of every node are looked at, with all of them paused
+    GOVLock gov_lock;
+
+    power_epochs++;
+
+    for (auto host_pmmu : pmmus) {
+        SPM *spm = host_pmmu->my_spm_ptr;
+        SPMPage *slots = spm->spmSlots;
+        const int nominal_point = spm->getNominalOperatingPoint();
+        const int low_leakage_point = spm->getLowLeakageOperatingPoint();
+
+        for (int slot_idx = 0; slot_idx < host_pmmu->getSPMSizePages(); slot_idx++) {
+            SPMPage &page = slots[slot_idx];
+            uint64_t epoch_refs = sampleSlot(host_pmmu, slot_idx).ref_count;
+
+            if (page.isFree()) {
+                if (page.getPowerState() != PAGE_OFF) {
+                    spm->setPagePowerState(slot_idx, PAGE_OFF);
+                    gated_slots++;
+                }
+                continue;
+            }
+
+            // pages still being filled or relocated are left alone
+            if (!page.isValid()) {
+                continue;
+            }
+
+            if (epoch_refs >= cold_threshold) {
+                if (page.getOperatingPoint() != nominal_point) {
+                    spm->setPageOperatingPoint(slot_idx, nominal_point);
+                    raised_slots++;
+                }
+                continue;
+            }
+
+            // faults are only injected into approximate data
+            Annotations *annotations = page.getAnnotations();
+            if (annotations && annotations->approximation != CRITICAL) {
+                if (page.getOperatingPoint() != low_leakage_point) {
+                    spm->setPageOperatingPoint(slot_idx, low_leakage_point);
+                    lowered_slots++;
+                }
+            }
+            else if (page.getPowerState() == PAGE_ON) {
+                spm->setPagePowerState(slot_idx, PAGE_DROWSY);
+                drowsy_slots++;
+            }
+        }
+
+        DPRINTF(GOV, "%s: Node (%d,%d) has %d free slot(s) gated off\n",
+                gov_type, host_pmmu->getNodeID() / num_column,
+                host_pmmu->getNodeID() % num_column,
+                spm->freePageIndex.getNumFreePages());
+    }
+}
@@ -0,0 +1,37 @@
+/* This class implements an SPM governor which greedily maps the allocation
+ * requests to the closest free on-chip SPM, and manages the power of the
+ * slots of every SPM page by page. Every epoch, the free slots are gated
+ * off, and the pages accessed fewer than cold_threshold times during the
+ * epoch are put to sleep: approximate ones move to the operating point
+ * leaking the least, critical ones go drowsy and keep their data. Pages
+ * accessed often enough run at the nominal operating point again. A slot
+ * that isn't on wakes up when it is accessed, see SPM::setPagePowerState.
+ * */
+
+#ifndef __POWER_GATING_SPM_HH__
+#define __POWER_GATING_SPM_HH__
+
+#include "params/PowerGatingSPM.hh"
+#include "mem/spm/governor/epoch_greedy_spm.hh"
+
+class PowerGatingSPM : public EpochGreedySPM {
+
+  public:
+    PowerGatingSPM(const Params *p);
+    virtual ~PowerGatingSPM();
+    virtual void regStats();
+
+  protected:
+    unsigned cold_threshold;
+
+    // sets the power state and operating point of every slot
+    void runEpoch() override;
+
+    Stats::Scalar power_epochs;
+    Stats::Scalar gated_slots;
+    Stats::Scalar drowsy_slots;
+    Stats::Scalar lowered_slots;
+    Stats::Scalar raised_slots;
+};
+
+#endif  /* __POWER_GATING_SPM_HH__ */
@@ -0,0 +1,181 @@
+#include "mem/spm/governor/priority_spm.hh"
+
+#include <iostream>
+
+PrioritySPM *
+PrioritySPMParams::create()
+{
+    return new PrioritySPM(this);
+}
+
+PrioritySPM::PrioritySPM(const Params *p)
+    : GreedySPM(p)
+{
+    gov_type = "Priority";
+}
+
+PrioritySPM::~PrioritySPM()
+{
+
+}
+
+void
+PrioritySPM::init()
+{
+    GreedySPM::init();
+}
+
+void
+PrioritySPM::regStats()
+{
+    GreedySPM::regStats();
+
+    preempted_pages
+        .name(name() + ".preempted_pages")
+        .desc("Number of pages moved off chip to admit more valuable ones")
+        ;
+
+    offchip_pages
+        .name(name() + ".offchip_pages")
+        .desc("Number of allocated pages that found no slot to take")
+        ;
+
+    preempted_importance
+        .init(NUM_DATA_IMPORTANCE)
+        .name(name() + ".preempted_importance")
+        .desc("Number of preempted pages per data importance")
+        .subname(MAX_IMPORTANCE, "max")
+        .subname(AVG_IMPORTANCE, "avg")
+        .subname(MIN_IMPORTANCE, "min")
+        ;
+}
+
+int
+PrioritySPM::pageRank(const Annotations *annotations) const
+{
+    // pages mapped without annotations are kept at all costs
+    if (!annotations) {
+        return 0;
+    }
+
+    // a shared page serves more than the thread that allocated it
+    ThreadPriority priority = annotations->shared_data ?
+                              HIGH_PRIORITY : annotations->app_priority;
+
+    return annotations->data_importance * NUM_APP_PRIORITY + priority;
+}
+
+bool
+PrioritySPM::findVictimSlot(PMMU *requester_pmmu, int rank,
+                            HostInfo *victim_host_info)
+{
+    auto closest = closestPMMUs(requester_pmmu);
+    assert(requester_pmmu == *closest);
+
+    for (vector<PMMU *>::size_type pmmu_it = 0; pmmu_it != pmmus.size(); pmmu_it++) {
+        PMMU *host_pmmu = closest[pmmu_it];
+        SPMPage *slots = host_pmmu->my_spm_ptr->spmSlots;
+
+        int victim_slot_idx = -1;
+        int victim_rank = rank;
+        Tick victim_tick = MaxTick;
+        for (int slot_idx = 0; slot_idx < host_pmmu->getSPMSizePages(); slot_idx++) {
+            // pages still being filled or relocated can't be moved off yet
+            if (slots[slot_idx].isFree() || !slots[slot_idx].isValid()) {
+                continue;
+            }
+
+            int slot_rank = pageRank(slots[slot_idx].getAnnotations());
+            Tick slot_tick = std::max(slots[slot_idx].getLastTickAccessed(),
+                                      slots[slot_idx].getTickInserted());
+            if (slot_rank > victim_rank ||
+                (victim_slot_idx >= 0 && slot_rank == victim_rank &&
+                 slot_tick < victim_tick)) {
+                victim_slot_idx = slot_idx;
+                victim_rank = slot_rank;
+                victim_tick = slot_tick;
+            }
+        }
+
+        if (victim_slot_idx < 0) {
+            continue;
+        }
+
+        PMMU *user_pmmu = PMMU::getPMMU(slots[victim_slot_idx].getOwner());
+        victim_host_info->setHostPMMU(host_pmmu);
+        victim_host_info->setUserPMMU(user_pmmu);
+        BaseCPU *user_cpu = dynamic_cast<BaseCPU*>((user_pmmu->my_spm_ptr->
+                            getSlavePort("cpu_side", 0).getMasterPort()).getOwner());
+        victim_host_info->setUserThreadContext(user_cpu->getContext(0));
+        victim_host_info->setSPMaddress(victim_slot_idx * host_pmmu->getPageSizeBytes());
+        victim_host_info->setNumPages(1);
+
+        DPRINTF(GOV, "%s: Slot %d on node (%d,%d) of rank %d gives way to "
+                "rank %d of node (%d,%d)\n",
+                gov_type, victim_slot_idx,
+                host_pmmu->getNodeID() / num_column,
+                host_pmmu->getNodeID() % num_column,
+                victim_rank, rank,
+                requester_pmmu->getNodeID() / num_column,
+                requester_pmmu->getNodeID() % num_column);
+        return true;
+    }
+
+    return false;
+}
+
+int
+PrioritySPM::allocate(GOVRequest *gov_request)
+{
+    printRequestStatus(gov_request);
+
+    const int total_num_pages = gov_request->getNumberOfPages(Unserved_Aligned);
+    if (total_num_pages <= 0) {
+        return 0;
+    }
+
+    if (!gov_type.compare("Priority") && hybrid_mem) {
+        cache_invalidator_helper(gov_request);
+    }
+
+    // 1. Take the free slots, closest first
+    int remaining_pages = total_num_pages - GreedySPM::allocate(gov_request);
+
+    // 2. Preempt pages worth less than the requested ones, one at a time
+    PMMU *requester_pmmu = gov_request->getPMMUPtr();
+    const int rank = pageRank(gov_request->getAnnotations());
+    while (remaining_pages > 0) {
+        HostInfo victim_host_info (nullptr, nullptr, nullptr, Addr(0), 1);
+        if (!findVictimSlot(requester_pmmu, rank, &victim_host_info)) {
+            break;
+        }
+
+        PMMU *host_pmmu = victim_host_info.getHostPMMU();
+        SPMPage *victim_slot = &host_pmmu->my_spm_ptr->spmSlots[
+            victim_host_info.getSPMaddress() / host_pmmu->getPageSizeBytes()];
+        const Annotations *victim_annotations = victim_slot->getAnnotations();
+        preempted_importance[victim_annotations->data_importance]++;
+        preempted_pages++;
+
+        // the victim leaves as it would on a free of its owner
+        victim_host_info.setDeallocMode(victim_annotations->dealloc_mode);
+        victim_host_info.setSignalee(requester_pmmu->getNodeID());
+        dallocation_helper_spm_address(&victim_host_info);
+
+        HostInfo host_info = HostInfo(gov_request->getThreadContext(),
+                                      requester_pmmu,
+                                      host_pmmu,
+                                      victim_host_info.getSPMaddress(), 1);
+        host_info.setAllocMode(gov_request->getAnnotations()->alloc_mode);
+        host_info.setSignaler(victim_host_info.getUserPMMU()->getNodeID());
+        remaining_pages -= allocation_helper_on_occupied_page(gov_request, &host_info);
+    }
+
+    offchip_pages += remaining_pages;
+
+    if (!gov_type.compare("Priority") && uncacheable_spm) {
+        add_mapping_unallocated_pages(gov_request);
+    }
+
+    return total_num_pages - remaining_pages;
+}
@@ -0,0 +1,41 @@
+/* This class implements an SPM governor which greedily maps the allocation
+ * requests to the closest free on-chip SPM, and makes room for valuable
+ * data once no slot is free. Every page is ranked by the importance of its
+ * data first and the priority of the thread that allocated it second;
+ * shared pages count as if a high priority thread owned them. A page that
+ * finds no free slot preempts the closest resident page of a strictly lower
+ * rank, the least recently used one among equals, which goes off chip as
+ * its own annotations say.
+ * */
+
+#ifndef __PRIORITY_SPM_HH__
+#define __PRIORITY_SPM_HH__
+
+#include "params/PrioritySPM.hh"
+#include "mem/spm/governor/greedy_spm.hh"
+
+class PrioritySPM : public GreedySPM {
+
+  public:
+    PrioritySPM(const Params *p);
+    virtual ~PrioritySPM();
+    virtual void init();
+    virtual void regStats();
+
+    virtual int allocate(GOVRequest *gov_request);
+
+  protected:
+    // lower is more valuable
+    int pageRank(const Annotations *annotations) const;
+
+    // the closest used slot to the requester worth less than rank, false
+    // if none is
+    bool findVictimSlot(PMMU *requester_pmmu, int rank,
+                        HostInfo *victim_host_info);
+
+    Stats::Scalar preempted_pages;
+    Stats::Scalar offchip_pages;
+    Stats::Vector preempted_importance;
+};
+
+#endif  /* __PRIORITY_SPM_HH__ */
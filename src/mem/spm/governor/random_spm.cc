@@ -3,6 +3,9 @@
 #include <iostream>
 #include <algorithm>
 
+#include "mem/ruby/network/Network.hh"
+#include "mem/ruby/system/RubySystem.hh"
+
 RandomSPM *
 RandomSPMParams::create()
 {
@@ -23,25 +26,103 @@ RandomSPM::~RandomSPM()
 void
 RandomSPM::init()
 {
-
+    buildDistanceTables();
 }
 
-/*
-Example of (col, row) ordering:
-(2,0)  (1,0)  (0,0)
-(2,1)  (1,1)  (0,1)
-(2,2)  (1,2)  (0,2)
-*/
 void
 RandomSPM::addPMMU(PMMU *p)
 {
     vector<PMMU *>::iterator it = pmmus.begin();
     pmmus.insert(it,p);
 
-    int col = p->getMachineID().num % num_column;
-    int row = p->getMachineID().num / num_column;
-    assert (coord_to_pmmu.find(make_pair(col,row)) == coord_to_pmmu.end());
-    coord_to_pmmu[make_pair(col,row)] = p;
+    NodeID node = p->getNodeID();
+    if (node >= pmmu_by_node.size()) {
+        pmmu_by_node.resize(node + 1, nullptr);
+    }
+    assert (pmmu_by_node[node] == nullptr);
+    pmmu_by_node[node] = p;
+}
+
+void
+RandomSPM::buildDistanceTables()
+{
+    int num_pmmus = pmmus.size();
+    if (num_pmmus == 0) {
+        return;
+    }
+
+    // hop counts come from the ruby topology the pmmus are connected to;
+    // fall back to a num_column wide mesh if there is none
+    const Topology *topology = nullptr;
+    RubySystem *ruby_system = pmmus[0]->params()->ruby_system;
+    if (ruby_system && ruby_system->getNetwork()) {
+        topology = ruby_system->getNetwork()->getTopology();
+    }
+
+    Matrix hops;
+    int pmmu_base = MachineType_base_number(MachineType_PMMU);
+    if (topology) {
+        hops = topology->hopDistances();
+    }
+
+    pmmus_by_distance.clear();
+    pmmus_by_distance.reserve(num_pmmus * pmmu_by_node.size());
+    hop_distances.assign(pmmu_by_node.size() * pmmu_by_node.size(), -1);
+    for (NodeID center = 0; center < pmmu_by_node.size(); center++) {
+        vector<pair<int, PMMU *>> row;
+        for (auto p : pmmus) {
+            int distance;
+            if (topology) {
+                distance = hops[pmmu_base + center][pmmu_base + p->getNodeID()];
+                if (distance < 0) {
+                    fatal("%s: node %d can't reach node %d\n",
+                          gov_type, center, p->getNodeID());
+                }
+            }
+            else {
+                // (col, row) ordering as in the mesh configs
+                distance = abs(int(center % num_column) - int(p->getNodeID() % num_column)) +
+                           abs(int(center / num_column) - int(p->getNodeID() / num_column));
+            }
+            hop_distances[center * pmmu_by_node.size() + p->getNodeID()] = distance;
+
+            // the node itself always comes first
+            if (p->getNodeID() == center) {
+                distance = -1;
+            }
+            row.push_back(make_pair(distance, p));
+        }
+
+        // ties keep the order of pmmus
+        stable_sort(row.begin(), row.end(),
+                    [](const pair<int, PMMU *> &a, const pair<int, PMMU *> &b)
+                    { return a.first < b.first; });
+
+        for (auto &entry : row) {
+            pmmus_by_distance.push_back(entry.second);
+        }
+    }
+}
+
+vector<PMMU *>::const_iterator
+RandomSPM::closestPMMUs(PMMU *center) const
+{
+    assert(center->getNodeID() < pmmu_by_node.size());
+    return pmmus_by_distance.begin() + center->getNodeID() * pmmus.size();
+}
+
+int
+RandomSPM::hopDistance(NodeID from, NodeID to) const
+{
+    assert(from < pmmu_by_node.size() && to < pmmu_by_node.size());
+    return hop_distances[from * pmmu_by_node.size() + to];
+}
+
+PMMU *
+RandomSPM::getPMMU(NodeID node) const
+{
+    assert(node < pmmu_by_node.size() && pmmu_by_node[node]);
+    return pmmu_by_node[node];
 }
 
 int
@@ -65,16 +146,14 @@ RandomSPM::allocate(GOVRequest *gov_request)
 
     // 2. If we still need more SPM slots, target randomly selected remote SPMs
     if (remaining_pages > 0) {
-        vector<int> indices;
-        for (int i=0; i < pmmus.size(); i++) {
-            indices.push_back(i);
-        }
-        random_shuffle(indices.begin(), indices.end());
-
-        while (indices.size() > 0 && remaining_pages > 0) {
-            int ind = *indices.begin();
-            indices.erase(indices.begin());
-            PMMU *host_pmmu = pmmus[ind];
+        // the local spm has already been tried, it heads its own row
+        auto closest = closestPMMUs(gov_request->getPMMUPtr());
+        vector<PMMU *> remote_pmmus(closest + 1, closest + pmmus.size());
+        random_shuffle(remote_pmmus.begin(), remote_pmmus.end());
+
+        for (auto it = remote_pmmus.begin();
+             it != remote_pmmus.end() && remaining_pages > 0; it++) {
+            PMMU *host_pmmu = *it;
             HostInfo host_info (gov_request->getThreadContext(),
                                 gov_request->getPMMUPtr(), host_pmmu, Addr(0), -1);
             host_info.setAllocMode(gov_request->getAnnotations()->alloc_mode);
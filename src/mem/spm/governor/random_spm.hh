@@ -28,7 +28,21 @@ class RandomSPM : public LocalSPM {
 
   protected:
     vector<PMMU *> pmmus;
-    map<pair<int,int>, PMMU *> coord_to_pmmu;
+
+    // pmmus indexed by node id
+    vector<PMMU *> pmmu_by_node;
+
+    // flat table of pmmus sorted by hop distance, one row of pmmus.size()
+    // entries per node id, each row starting with the node itself
+    vector<PMMU *> pmmus_by_distance;
+
+    // hop distance between every pair of node ids
+    vector<int> hop_distances;
+
+    void buildDistanceTables();
+    vector<PMMU *>::const_iterator closestPMMUs(PMMU *center) const;
+    int hopDistance(NodeID from, NodeID to) const;
+    PMMU *getPMMU(NodeID node) const;
 
 };
 
@@ -0,0 +1,426 @@
+#include "mem/spm/governor/replicating_greedy_spm.hh"
+
+#include <algorithm>
+#include <iostream>
+
+#include "mem/spm/att.hh"
+
+ReplicatingGreedySPM *
+ReplicatingGreedySPMParams::create()
+{
+    return new ReplicatingGreedySPM(this);
+}
+
+ReplicatingGreedySPM::ReplicatingGreedySPM(const Params *p)
+    : EpochGreedySPM(p, p->replication_epoch),
+      replication_budget(p->replication_budget),
+      replication_threshold(p->replication_threshold)
+{
+    gov_type = "ReplicatingGreedy";
+}
+
+ReplicatingGreedySPM::~ReplicatingGreedySPM()
+{
+
+}
+
+void
+ReplicatingGreedySPM::serialize(CheckpointOut &cp) const
+{
+    vector<uint64_t> written_asids;
+    vector<Addr> written_v_page_addrs;
+    for (auto &page : written_pages) {
+        written_asids.push_back(page.first);
+        written_v_page_addrs.push_back(page.second);
+    }
+    SERIALIZE_CONTAINER(written_asids);
+    SERIALIZE_CONTAINER(written_v_page_addrs);
+
+    EpochGreedySPM::serialize(cp);
+}
+
+void
+ReplicatingGreedySPM::unserialize(CheckpointIn &cp)
+{
+    vector<uint64_t> written_asids;
+    vector<Addr> written_v_page_addrs;
+    UNSERIALIZE_CONTAINER(written_asids);
+    UNSERIALIZE_CONTAINER(written_v_page_addrs);
+
+    written_pages.clear();
+    for (vector<uint64_t>::size_type i = 0; i < written_asids.size(); i++) {
+        written_pages.insert(make_pair(written_asids[i], written_v_page_addrs[i]));
+    }
+
+    EpochGreedySPM::unserialize(cp);
+}
+
+void
+ReplicatingGreedySPM::regStats()
+{
+    EpochGreedySPM::regStats();
+
+    shared_pages
+        .name(name() + ".shared_pages")
+        .desc("Number of allocated pages mapped to a copy already on chip")
+        ;
+
+    replication_epochs
+        .name(name() + ".replication_epochs")
+        .desc("Number of replication epochs")
+        ;
+
+    replication_candidates
+        .name(name() + ".replication_candidates")
+        .desc("Number of shared pages read remotely often enough to be replicated")
+        ;
+
+    replicated_pages
+        .name(name() + ".replicated_pages")
+        .desc("Number of copies of shared pages made on the spm of a reader")
+        ;
+
+    collapsed_pages
+        .name(name() + ".collapsed_pages")
+        .desc("Number of replicated pages written to")
+        ;
+
+    discarded_replicas
+        .name(name() + ".discarded_replicas")
+        .desc("Number of copies dropped because their page was written to")
+        ;
+}
+
+ThreadContext *
+ReplicatingGreedySPM::getUserContext(PMMU *user_pmmu)
+{
+    BaseCPU *user_cpu = dynamic_cast<BaseCPU*>((user_pmmu->my_spm_ptr->
+                        getSlavePort("cpu_side", 0).getMasterPort()).getOwner());
+    return user_cpu->getContext(0);
+}
+
+ATTEntry *
+ReplicatingGreedySPM::findClosestCopy(uint64_t asid, Addr v_page_addr, NodeID node,
+                                      PMMU **owner_pmmu)
+{
+    ATTEntry *closest_copy = nullptr;
+    int closest_distance = 0;
+    for (auto user_pmmu : pmmus) {
+        ATTEntry *mapping = user_pmmu->my_att->getMapping(asid, v_page_addr);
+
+        // only shared pages allocated on chip have a copy others can use
+        if (!mapping || mapping->alias || !mapping->annotations ||
+            !mapping->annotations->shared_data ||
+            mapping->annotations->alloc_mode == NUM_ALLOCATION_MODE) {
+            continue;
+        }
+
+        int distance = hopDistance(node, mapping->destination_node.num);
+        if (!closest_copy || distance < closest_distance) {
+            closest_copy = mapping;
+            closest_distance = distance;
+            *owner_pmmu = user_pmmu;
+        }
+    }
+    return closest_copy;
+}
+
+ATTEntry *
+ReplicatingGreedySPM::findSlotOwner(uint64_t asid, Addr v_page_addr, MachineID node,
+                                    Addr spm_slot_addr, PMMU **owner_pmmu)
+{
+    for (auto user_pmmu : pmmus) {
+        ATTEntry *mapping = user_pmmu->my_att->getMapping(asid, v_page_addr);
+        if (mapping && !mapping->alias &&
+            mapping->destination_node.num == node.num &&
+            mapping->spm_slot_addr == spm_slot_addr) {
+            *owner_pmmu = user_pmmu;
+            return mapping;
+        }
+    }
+    return nullptr;
+}
+
+void
+ReplicatingGreedySPM::setReadOnly(uint64_t asid, Addr v_page_addr, bool read_only)
+{
+    for (auto user_pmmu : pmmus) {
+        ATTEntry *mapping = user_pmmu->my_att->getMapping(asid, v_page_addr);
+        if (mapping) {
+            mapping->read_only = read_only;
+        }
+    }
+}
+
+int
+ReplicatingGreedySPM::shareOnChipPages(GOVRequest *gov_request)
+{
+    PMMU *requester_pmmu = gov_request->getPMMUPtr();
+    const uint64_t asid = gov_request->getASID();
+    const int total_num_pages = gov_request->getNumberOfPages(Unserved_Aligned);
+
+    // the node that allocated the page moves it off chip, the mappings of
+    // the others only use it
+    Annotations alias_annotations = *gov_request->getAnnotations();
+    alias_annotations.alloc_mode = NUM_ALLOCATION_MODE;
+
+    int page_index;
+    for (page_index = 0; page_index < total_num_pages; page_index++) {
+        Addr v_page_addr = gov_request->getNthPageStartAddr(Unserved_Aligned, page_index);
+        if (requester_pmmu->my_att->hasMapping(asid, v_page_addr)) {
+            break;
+        }
+
+        // pages still being filled are allocated as usual
+        PMMU *owner_pmmu = nullptr;
+        ATTEntry *copy = findClosestCopy(asid, v_page_addr,
+                                         requester_pmmu->getNodeID(), &owner_pmmu);
+        if (!copy || !copy->data_valid) {
+            break;
+        }
+
+        MachineID host_node = copy->destination_node;
+        Addr spm_slot_addr = copy->spm_slot_addr;
+        bool read_only = copy->read_only;
+        if (requester_pmmu->my_att->addMapping(asid, v_page_addr, host_node, spm_slot_addr,
+                                               &alias_annotations) != ATT::ATT_Added) {
+            break;
+        }
+
+        ATTEntry *mapping = requester_pmmu->my_att->getMapping(asid, v_page_addr);
+        mapping->alias = true;
+        mapping->read_only = read_only;
+        requester_pmmu->my_att->validateATTEntry(mapping);
+
+        DPRINTF(GOV, "%s: Node (%d,%d) shares page %#x of node (%d,%d) "
+                "on node (%d,%d)\n",
+                gov_type,
+                requester_pmmu->getNodeID() / num_column,
+                requester_pmmu->getNodeID() % num_column,
+                v_page_addr,
+                owner_pmmu->getNodeID() / num_column,
+                owner_pmmu->getNodeID() % num_column,
+                host_node.num / num_column, host_node.num % num_column);
+    }
+
+    gov_request->incPagesServed(page_index);
+    shared_pages += page_index;
+    return page_index;
+}
+
+int
+ReplicatingGreedySPM::allocate(GOVRequest *gov_request)
+{
+    printRequestStatus(gov_request);
+
+    const int total_num_pages = gov_request->getNumberOfPages(Unserved_Aligned);
+    if (total_num_pages <= 0) {
+        return 0;
+    }
+
+    int remaining_pages = total_num_pages;
+
+    if (hybrid_mem) {
+        cache_invalidator_helper(gov_request);
+    }
+
+    // 1. Shared pages on chip already are used where they are
+    if (gov_request->getAnnotations()->shared_data) {
+        remaining_pages -= shareOnChipPages(gov_request);
+    }
+
+    // 2. The rest go to the closest free slots; EpochGreedySPM::allocate
+    // would invalidate the caches and add the unallocated pages twice
+    if (remaining_pages > 0) {
+        remaining_pages -= GreedySPM::allocate(gov_request);
+    }
+
+    if (uncacheable_spm) {
+        add_mapping_unallocated_pages(gov_request);
+    }
+
+    return total_num_pages - remaining_pages;
+}
+
+bool
+ReplicatingGreedySPM::replicatePage(const ReplicationCandidate &candidate)
+{
+    PMMU *reader_pmmu = candidate.reader_pmmu;
+    const uint64_t asid = candidate.asid;
+    const Addr v_page_addr = candidate.v_page_addr;
+
+    ATTEntry *alias = reader_pmmu->my_att->getMapping(asid, v_page_addr);
+    if (!alias || !alias->alias) {
+        return false;
+    }
+
+    // the page is copied from the slot the reader uses now, once filled
+    PMMU *owner_pmmu = nullptr;
+    ATTEntry *source = findSlotOwner(asid, v_page_addr, alias->destination_node,
+                                     alias->spm_slot_addr, &owner_pmmu);
+    if (!source || !source->data_valid) {
+        return false;
+    }
+
+    HostInfo future_host_info (nullptr, reader_pmmu, reader_pmmu, Addr(0), 1);
+    if (!getMaxContiguousFreePages(&future_host_info, 1)) {
+        return false;
+    }
+
+    // the copy takes the place of the mapping to the remote page
+    const MachineID host_node = alias->destination_node;
+    const Addr spm_slot_addr = alias->spm_slot_addr;
+    const unsigned int num_owners = alias->num_owners;
+    Annotations alias_annotations = *alias->annotations;
+    delete alias->annotations;
+    alias->num_owners = 1;
+    reader_pmmu->my_att->removeMapping(asid, v_page_addr);
+
+    GOVRequest copy_request (getUserContext(owner_pmmu), Relocation,
+                             v_page_addr, v_page_addr + reader_pmmu->getPageSizeBytes(), 0);
+    copy_request.setASID(asid);
+
+    ATTEntry *mapping = nullptr;
+    bool replicated = copy_helper_virtual_address(&copy_request, reader_pmmu) > 0;
+    if (replicated) {
+        mapping = reader_pmmu->my_att->getMapping(asid, v_page_addr);
+    }
+    else {
+        reader_pmmu->my_att->addMapping(asid, v_page_addr, host_node, spm_slot_addr,
+                                        &alias_annotations);
+        mapping = reader_pmmu->my_att->getMapping(asid, v_page_addr);
+        mapping->alias = true;
+        reader_pmmu->my_att->validateATTEntry(mapping);
+    }
+    mapping->num_owners = num_owners;
+
+    if (!replicated) {
+        return false;
+    }
+
+    setReadOnly(asid, v_page_addr, true);
+
+    DPRINTF(GOV, "%s: Replicating page %#x read %d time(s) by node (%d,%d) "
+            "from node (%d,%d)\n",
+            gov_type, v_page_addr, candidate.epoch_reads,
+            reader_pmmu->getNodeID() / num_column,
+            reader_pmmu->getNodeID() % num_column,
+            host_node.num / num_column, host_node.num % num_column);
+
+    return true;
+}
+
+void
+ReplicatingGreedySPM::runEpoch()
+{
+    // the mappings of every node are looked at, with all of them paused
+    GOVLock gov_lock;
+
+    replication_epochs++;
+
+    // 1. find the shared pages read remotely often enough in this epoch
+    vector<ReplicationCandidate> candidates;
+    for (auto reader_pmmu : pmmus) {
+        const NodeID reader_id = reader_pmmu->getNodeID();
+        reader_pmmu->my_att->forEachMapping([&](ATTEntry &entry) {
+            if (!entry.alias) {
+                return;
+            }
+
+            unsigned int epoch_reads = entry.num_accesses;
+            entry.num_accesses = 0;
+
+            if (entry.destination_node.num == reader_id || !entry.data_valid ||
+                epoch_reads < replication_threshold ||
+                written_pages.count(make_pair(entry.asid, entry.v_page_addr))) {
+                return;
+            }
+
+            candidates.push_back(ReplicationCandidate{reader_pmmu, entry.asid,
+                                                      entry.v_page_addr, epoch_reads});
+        });
+    }
+    replication_candidates += candidates.size();
+
+    stable_sort(candidates.begin(), candidates.end(),
+                [](const ReplicationCandidate &a, const ReplicationCandidate &b)
+                { return a.epoch_reads > b.epoch_reads; });
+
+    // 2. give the heaviest readers their own copy first
+    unsigned budget = replication_budget;
+    for (auto &candidate : candidates) {
+        if (budget == 0) {
+            break;
+        }
+        if (replicatePage(candidate)) {
+            replicated_pages++;
+            budget--;
+        }
+    }
+}
+
+void
+ReplicatingGreedySPM::collapseReplicas(PMMU *writer_pmmu, uint64_t asid, Addr v_page_addr)
+{
+    ATTEntry *written = writer_pmmu->my_att->getMapping(asid, v_page_addr);
+    assert(written);
+    const MachineID host_node = written->destination_node;
+    const Addr spm_slot_addr = written->spm_slot_addr;
+
+    collapsed_pages++;
+    written_pages.insert(make_pair(asid, v_page_addr));
+
+    DPRINTF(GOV, "%s: Node (%d,%d) writes to replicated page %#x, keeping "
+            "the copy on node (%d,%d)\n",
+            gov_type, writer_pmmu->getNodeID() / num_column,
+            writer_pmmu->getNodeID() % num_column, v_page_addr,
+            host_node.num / num_column, host_node.num % num_column);
+
+    // 1. the readers of other copies move over to the written one
+    vector<PMMU *> replica_users;
+    for (auto user_pmmu : pmmus) {
+        ATTEntry *mapping = user_pmmu->my_att->getMapping(asid, v_page_addr);
+        if (!mapping) {
+            continue;
+        }
+
+        mapping->read_only = false;
+        if (mapping->destination_node.num == host_node.num &&
+            mapping->spm_slot_addr == spm_slot_addr) {
+            continue;
+        }
+
+        if (mapping->alias) {
+            user_pmmu->my_att->changeMapping(asid, v_page_addr, host_node, spm_slot_addr);
+        }
+        else {
+            replica_users.push_back(user_pmmu);
+        }
+    }
+
+    // 2. the other copies are discarded, their nodes read the written one
+    // from now on
+    for (auto user_pmmu : replica_users) {
+        ATTEntry *mapping = user_pmmu->my_att->getMapping(asid, v_page_addr);
+        const unsigned int num_owners = mapping->num_owners;
+        Annotations alias_annotations = *mapping->annotations;
+        alias_annotations.alloc_mode = NUM_ALLOCATION_MODE;
+        mapping->num_owners = 1;
+
+        GOVRequest dealloc_request (getUserContext(user_pmmu), Deallocation,
+                                    v_page_addr, v_page_addr + user_pmmu->getPageSizeBytes(),
+                                    DISCARD);
+        dealloc_request.setASID(asid);
+        HostInfo host_info (dealloc_request.getThreadContext(), user_pmmu, nullptr,
+                            Addr(0), 1);
+        dallocation_helper_virtual_address(&dealloc_request, &host_info);
+        discarded_replicas++;
+
+        user_pmmu->my_att->addMapping(asid, v_page_addr, host_node, spm_slot_addr,
+                                      &alias_annotations);
+        mapping = user_pmmu->my_att->getMapping(asid, v_page_addr);
+        mapping->alias = true;
+        mapping->num_owners = num_owners;
+        user_pmmu->my_att->validateATTEntry(mapping);
+    }
+}
@@ -0,0 +1,81 @@
+/* This class implements an SPM governor which greedily maps the allocation
+ * requests to the closest free on-chip SPM, and keeps a single copy of
+ * shared data that every node reads in place. A node allocating shared
+ * pages that another node has on chip already maps them where they are.
+ * Every epoch, the nodes reading such a page remotely more than
+ * replication_threshold times get their own copy of it on their local spm,
+ * at most replication_budget pages per epoch. All mappings of a page with
+ * copies are read-only; the first write to any of them keeps the copy the
+ * writer maps, discards the others and points their readers back at it.
+ * A page written once isn't replicated again.
+ * */
+
+#ifndef __REPLICATING_GREEDY_SPM_HH__
+#define __REPLICATING_GREEDY_SPM_HH__
+
+#include <set>
+#include <utility>
+
+#include "params/ReplicatingGreedySPM.hh"
+#include "mem/spm/governor/epoch_greedy_spm.hh"
+
+class ReplicatingGreedySPM : public EpochGreedySPM {
+
+  public:
+    ReplicatingGreedySPM(const Params *p);
+    virtual ~ReplicatingGreedySPM();
+    virtual void regStats();
+
+    // the pages barred from replication
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+
+    virtual int allocate(GOVRequest *gov_request);
+
+    virtual void collapseReplicas(PMMU *writer_pmmu, uint64_t asid,
+                                  Addr v_page_addr);
+
+  protected:
+    unsigned replication_budget;
+    unsigned replication_threshold;
+
+    // a shared page a node read remotely during the last epoch
+    struct ReplicationCandidate
+    {
+        PMMU *reader_pmmu;
+        uint64_t asid;
+        Addr v_page_addr;
+        unsigned epoch_reads;
+    };
+
+    // pages written to since they were shared, by address space
+    set<pair<uint64_t, Addr>> written_pages;
+
+    // replicates the shared pages read remotely the most in the epoch
+    void runEpoch() override;
+
+    // maps the leading pages of the request that are on chip already to
+    // their closest copy; returns the number of pages mapped
+    int shareOnChipPages(GOVRequest *gov_request);
+
+    // the mapping of a copy the page has on chip, the closest to the node
+    ATTEntry *findClosestCopy(uint64_t asid, Addr v_page_addr, NodeID node,
+                              PMMU **owner_pmmu);
+    // the mapping that owns the slot on the given node
+    ATTEntry *findSlotOwner(uint64_t asid, Addr v_page_addr, MachineID node,
+                            Addr spm_slot_addr, PMMU **owner_pmmu);
+
+    bool replicatePage(const ReplicationCandidate &candidate);
+    void setReadOnly(uint64_t asid, Addr v_page_addr, bool read_only);
+
+    ThreadContext *getUserContext(PMMU *user_pmmu);
+
+    Stats::Scalar shared_pages;
+    Stats::Scalar replication_epochs;
+    Stats::Scalar replication_candidates;
+    Stats::Scalar replicated_pages;
+    Stats::Scalar collapsed_pages;
+    Stats::Scalar discarded_replicas;
+};
+
+#endif  /* __REPLICATING_GREEDY_SPM_HH__ */
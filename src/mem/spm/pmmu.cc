@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cassert>
 #include <sstream>
 #include <string>
@@ -7,8 +8,11 @@
 
 #include "base/compiler.hh"
 #include "base/cprintf.hh"
+#include "cpu/base.hh"
+#include "cpu/thread_context.hh"
 #include "debug/PMMU.hh"
 #include "debug/ATT.hh"
+#include "debug/Drain.hh"
 #include "mem/page_table.hh"
 #include "mem/protocol/Types.hh"
 #include "mem/ruby/network/Network.hh"
@@ -18,13 +22,17 @@
 #include "mem/spm/att.hh"
 #include "mem/spm/spm_message/SPMRequestMsg.hh"
 #include "mem/spm/spm_message/SPMResponseMsg.hh"
+#include "mem/spm/stream_engine.hh"
+#include "mem/spm/governor/GOVLock.hh"
 #include "mem/spm/governor/local_spm.hh"
 #include "mem/spm/governor/random_spm.hh"
 #include "mem/spm/governor/greedy_spm.hh"
 #include "mem/spm/governor/guaranteed_greedy_spm.hh"
+#include "sim/process.hh"
 
 int PMMU::m_num_controllers = 0;
 int PMMU::m_page_size_bytes;
+std::vector<PMMU *> PMMU::m_pmmus;
 
 PMMU *
 PMMUParams::create()
@@ -35,13 +43,21 @@ PMMUParams::create()
 PMMU::PMMU(const Params *p)
     : AbstractController(p),
       my_spm_ptr(nullptr),
+      m_hop_latency(p->hop_latency),
       my_governor_ptr(p->governor),
-      pending_gov_reqs(0)
+      pending_gov_reqs(0),
+      outstanding_gov_pkts(0),
+      next_ticket(1)
 {
     m_machineID.type = MachineType_PMMU;
     m_machineID.num = m_version;
     m_num_controllers++;
 
+    if (m_version >= m_pmmus.size()) {
+        m_pmmus.resize(m_version + 1, nullptr);
+    }
+    m_pmmus[m_version] = this;
+
     spmSlavePort = new SPMSideSlavePort(p->name + ".spm_s_side", this, 0);
     spmMasterPort = new SPMSideMasterPort(p->name + ".spm_m_side", this, 1);
 
@@ -50,7 +66,7 @@ PMMU::PMMU(const Params *p)
 
     m_in_ports = 2; //@TODO: Should this be 2?
 //    m_dma_sequencer_ptr->setController(this);
-//    m_request_latency = p->request_latency;
+    m_request_latency = p->request_latency;
     m_responseFromSPM_ptr = p->responseFromSPM;
     m_responseToSPM_ptr = p->responseToSPM;
     m_requestFromSPM_ptr = p->requestFromSPM;
@@ -58,9 +74,12 @@ PMMU::PMMU(const Params *p)
     m_responseToNetwork_ptr = p->responseToNetwork;
     m_requestToNetwork_ptr = p->requestToNetwork;
 
-    addToGovernor(p->gov_type);
+    addToGovernor();
 
-    my_att = new ATT();
+    my_att = new ATT(p->att_capacity);
+    my_att_lookaside = new ATTLookasideBuffer(my_att, p->att_lookaside_entries,
+                                              floorLog2(m_page_size_bytes));
+    my_stream_engine = new SPMStreamEngine(this, p->max_streams);
 }
 
 BaseMasterPort &
@@ -86,16 +105,11 @@ PMMU::getSlavePort(const std::string &if_name, PortID idx)
 }
 
 void
-PMMU::addToGovernor(std::string gov_type)
+PMMU::addToGovernor()
 {
-    if (gov_type.compare("Random") == 0) {
-        dynamic_cast<RandomSPM*>(my_governor_ptr)->addPMMU(this);
-    }
-    else if (gov_type.compare("Greedy") == 0) {
-        dynamic_cast<GreedySPM*>(my_governor_ptr)->addPMMU(this);
-    }
-    else if (gov_type.compare("GuaranteedGreedy") == 0) {
-        dynamic_cast<GuaranteedGreedySPM*>(my_governor_ptr)->addPMMU(this);
+    // every governor placing pages on remote spms needs the pmmus
+    if (auto gov = dynamic_cast<RandomSPM*>(my_governor_ptr)) {
+        gov->addPMMU(this);
     }
 }
 
@@ -142,6 +156,36 @@ PMMU::init()
     resetStats();
 }
 
+void
+PMMU::startup()
+{
+    AbstractController::startup();
+
+    // every object is restored by now
+    clearRestoredAnnotations();
+}
+
+void
+PMMU::serialize(CheckpointOut &cp) const
+{
+    if (outstanding_gov_pkts || !pending_tickets.empty())
+        fatal("PMMU %s must be drained before checkpointing\n", name());
+
+    AbstractController::serialize(cp);
+    SERIALIZE_SCALAR(next_ticket);
+    my_att->serializeSection(cp, "att");
+    my_stream_engine->serializeSection(cp, "stream_engine");
+}
+
+void
+PMMU::unserialize(CheckpointIn &cp)
+{
+    AbstractController::unserialize(cp);
+    UNSERIALIZE_SCALAR(next_ticket);
+    my_att->unserializeSection(cp, "att");
+    my_stream_engine->unserializeSection(cp, "stream_engine");
+}
+
 void
 PMMU::setSPM(SPM *_spm)
 {
@@ -153,6 +197,29 @@ void
 PMMU::regStats()
 {
 	AbstractController::regStats();
+
+    my_att_lookaside->regStats(name());
+    my_stream_engine->regStats(name());
+
+    async_gov_reqs
+        .name(name() + ".async_gov_reqs")
+        .desc("Number of asynchronous alloc/dealloc requests")
+        ;
+
+    async_gov_pkts
+        .name(name() + ".async_gov_pkts")
+        .desc("Number of page runs moved for asynchronous requests")
+        ;
+
+    handed_off_pages
+        .name(name() + ".handed_off_pages")
+        .desc("Number of pages whose mappings were handed off to this node")
+        ;
+
+    copied_pages
+        .name(name() + ".copied_pages")
+        .desc("Number of pages of other nodes copied for this node")
+        ;
 }
 
 void
@@ -243,6 +310,11 @@ PMMU::addATTMappingsVAddress(GOVRequest *gov_request, HostInfo *host_info)
     Addr start_v_page_addr = gov_request->getStartAddr(Unserved_Aligned);
     Addr start_p_spm_addr = host_info->getSPMaddress();
 
+    // newly mapped pages are transferred in runs, one bulk request per run;
+    // we keep private copies of annotations kept in ATT for each page of it
+    int run_first_page = 0;
+    std::vector<Annotations*> run_annotations;
+
     int added_pages = 0;
     for (int page_index = 0; page_index < num_pages; page_index++) {
 
@@ -250,29 +322,45 @@ PMMU::addATTMappingsVAddress(GOVRequest *gov_request, HostInfo *host_info)
         Addr p_spm_addr = start_p_spm_addr + page_index*getPageSizeBytes();
 
         // update ATT
-        if (my_att->addMapping(gov_request, host_info, page_index)) {
+        ATT::AddResult result = my_att->addMapping(gov_request, host_info, page_index);
+        if (result == ATT::ATT_Added) {
 
             DPRINTF(ATTMap, "Node %d: Adding ATT mapping for virtual address %x on node %d, spm address %d\n",
                     getNodeID(), v_page_addr, host_pmmu->getMachineID(), p_spm_addr);
 
-            ATTEntry *mapping = my_att->getMapping(v_page_addr);
+            ATTEntry *mapping = my_att->getMapping(gov_request->getASID(), v_page_addr);
             if (host_info->alloc_mode != NUM_ALLOCATION_MODE) {
-                // this hack is needed to pass the pointer to a private copy
-                // of annotations kept in ATT
-                Annotations *orignal_annotations = gov_request->getAnnotations();
-                gov_request->setAnnotations(mapping->annotations);
-                triggerPageAlloc(gov_request, host_info, page_index);
-                gov_request->setAnnotations(orignal_annotations);
+                if (run_annotations.empty()) {
+                    run_first_page = page_index;
+                }
+                run_annotations.push_back(mapping->annotations);
                 if (!(host_info->signaling.wait_for_signal) && host_info->alloc_mode == UNINITIALIZE) {
                     my_att->validateATTEntry(mapping);
                 }
             }
             added_pages++;
         }
-        else {
+        else if (result == ATT::ATT_Exists) {
             DPRINTF(ATTMap, "Node %d: Already Added: ATT mapping for virtual address %x\n",
                     getNodeID(), v_page_addr);
+
+            if (!run_annotations.empty()) {
+                triggerPageAlloc(gov_request, host_info, run_first_page, run_annotations);
+                run_annotations.clear();
+            }
         }
+        else {
+            DPRINTF(ATTMap, "Node %d: ATT full: no mapping for virtual address %x "
+                    "and the %d page(s) after it\n",
+                    getNodeID(), v_page_addr, num_pages - page_index - 1);
+
+            host_info->setNumPages(page_index);
+            break;
+        }
+    }
+
+    if (!run_annotations.empty()) {
+        triggerPageAlloc(gov_request, host_info, run_first_page, run_annotations);
     }
     return added_pages;
 }
@@ -280,36 +368,65 @@ PMMU::addATTMappingsVAddress(GOVRequest *gov_request, HostInfo *host_info)
 void
 PMMU::triggerPageAlloc(GOVRequest *gov_request,
                        HostInfo *host_info,
-                       int page_index)
+                       int first_page_index,
+                       const std::vector<Annotations*> &run_annotations)
 {
-    Addr v_page_addr = gov_request->getStartAddr(Unserved_Aligned) +
-                       page_index * gov_request->getPMMUPtr()->getPageSizeBytes();
+    // the governor may be serving us from the thread of another node
+    GOVNodeContext node_context(this);
+
+    int num_pages = run_annotations.size();
+    Addr start_v_page_addr = gov_request->getStartAddr(Unserved_Aligned) +
+                             first_page_index * getPageSizeBytes();
     Addr p_spm_addr = host_info->getSPMaddress() +
-                      page_index * gov_request->getPMMUPtr()->getPageSizeBytes();
+                      first_page_index * getPageSizeBytes();
+
+    Addr start_p_page_addr = 0;
+    PacketPtr alloc_pkt = nullptr;
+
+    for (int page_index = 0; page_index < num_pages; page_index++) {
+        Addr v_page_addr = start_v_page_addr + page_index * getPageSizeBytes();
+
+        // pages that are contiguous in virtual memory might not be physically
+        Addr p_page_addr;
+        bool translated = gov_request->getPageTablePtr()->translate(v_page_addr, p_page_addr);
+        if (!translated)
+            panic("Virtual page doesn't exist in page table!.\n");
+
+        if (!alloc_pkt) {
+            start_p_page_addr = p_page_addr;
+            RequestPtr alloc_req = new Request(p_page_addr, num_pages * getPageSizeBytes(),
+                                               Request::PHYSICAL, Request::funcMasterId);
+            alloc_pkt = new Packet(alloc_req, MemCmd::ReadReq, num_pages * getPageSizeBytes());
+            pkt_ext_pool.attach(alloc_pkt);
+            alloc_pkt->req->setFlags(Request::UNCACHEABLE | Request::STRICT_ORDER);
+        }
 
-    Addr p_page_addr;
-    bool translated = gov_request->getPageTablePtr()->translate(v_page_addr, p_page_addr);
-    if (!translated)
-        panic("Virtual page doesn't exist in page table!.\n");
+        alloc_pkt->govInfo().addRunPage(p_page_addr, v_page_addr, run_annotations[page_index]);
+    }
 
-    RequestPtr alloc_req = new Request(p_page_addr, getPageSizeBytes(), Request::PHYSICAL, Request::funcMasterId);
-    PacketPtr alloc_pkt = new Packet(alloc_req, MemCmd::ReadReq, getPageSizeBytes());
-    alloc_pkt->allocate();
-    alloc_pkt->req->setFlags(Request::UNCACHEABLE | Request::STRICT_ORDER);
+    // the data itself is moved by the host spm's transfer engine
+    alloc_pkt->govInfo().setAddresses(p_spm_addr, start_p_page_addr, start_v_page_addr);
+    alloc_pkt->govInfo().setASID(gov_request->getASID());
+    alloc_pkt->govInfo().markIncomplete();
+    alloc_pkt->govInfo().makeAllocate();
+    alloc_pkt->govInfo().setAnnotations(run_annotations.front());
 
-    alloc_pkt->govInfo.setAddresses(p_spm_addr, p_page_addr, v_page_addr);
-    alloc_pkt->govInfo.markIncomplete();
-    alloc_pkt->govInfo.makeAllocate();
-    alloc_pkt->govInfo.setAnnotations(gov_request->getAnnotations());
+    alloc_pkt->spmInfo().setOrigin(m_machineID.num);
 
-    alloc_pkt->spmInfo.setOrigin(m_machineID.num);
+    alloc_pkt->govInfo().setSignaling(&(host_info->signaling));
 
-    alloc_pkt->govInfo.setSignaling(&(host_info->signaling));
+    alloc_pkt->govInfo().setStallStatus(alloc_pkt->govInfo().hasSignaler() ||
+                                     (alloc_pkt->govInfo().getAnnotations()->alloc_mode == COPY));
 
-    alloc_pkt->govInfo.setStallStatus(alloc_pkt->govInfo.hasSignaler() ||
-                                     (alloc_pkt->govInfo.getAnnotations()->alloc_mode == COPY));
+    trackAsyncGOVReq(gov_request, alloc_pkt);
+    outstanding_gov_pkts++;
 
-    std::shared_ptr<SPMRequestMsg> msg = std::make_shared<SPMRequestMsg>(clockEdge());
+    if (my_spm_ptr->system->isAtomicMode()) {
+        atomicGOVReq(alloc_pkt, host_info->getHostMachineID());
+        return;
+    }
+
+    RefCountingPtr<SPMRequestMsg> msg = new SPMRequestMsg(clockEdge());
     msg->m_Type = SPMRequestType_ALLOC;
     msg->m_PktPtr = alloc_pkt;
     (msg->m_Destination).add(host_info->getHostMachineID());
@@ -323,15 +440,15 @@ PMMU::triggerPageAlloc(GOVRequest *gov_request,
         m_requestToNetwork_ptr->enqueue(msg, clockEdge(), 1);
     }
 
-    if (alloc_pkt->govInfo.shouldStall()) {
+    if (alloc_pkt->govInfo().shouldStall()) {
         // block the spm's cpu-side port
         my_spm_ptr->setBlocked(BaseSPM::Blocked_Alloc_DeAlloc_Relocate);
         // to make sure we don't unblock the port unless all pages are allocated
         pending_gov_reqs++;
     }
 
-    DPRINTF(PMMU, "Node %d: Allocating a page on node %d, spm address %d, should wait %d, for node %d\n",
-                   getNodeID(), host_info->getHostMachineID().num, p_spm_addr,
+    DPRINTF(PMMU, "Node %d: Allocating %d page(s) on node %d, spm address %d, should wait %d, for node %d\n",
+                   getNodeID(), num_pages, host_info->getHostMachineID().num, p_spm_addr,
                    host_info->signaling.wait_for_signal, host_info->signaling.signaler);
 }
 
@@ -341,15 +458,35 @@ PMMU::removeATTMappingsVAddress(GOVRequest *gov_request, HostInfo *host_info)
     int num_pages = host_info->getNumPages();
     Addr start_v_page_addr = gov_request->getStartAddr(Unserved_Aligned);
 
+    // pages sitting next to each other, both in the address space and on
+    // the same spm, are written back as one run; host_info tracks the node
+    // of the current run
+    int run_first_page = 0;
+    MachineID run_node = host_info->getHostMachineID();
+    Addr run_spm_addr = 0;
+    std::vector<Addr> run_v_page_addrs;
+    std::vector<Annotations*> run_annotations;
+
     int removed_pages = 0;
     for (int page_index = 0; page_index < num_pages; page_index++) {
         Addr v_page_addr = start_v_page_addr + page_index*getPageSizeBytes();
 
-        ATTEntry* mapping =  my_att->getMapping(v_page_addr);
+        ATTEntry* mapping =  my_att->getMapping(gov_request->getASID(), v_page_addr);
 
         // if we havn't allocated this page (=there was no space), then nothing needs to be removed
         if (mapping) {
 
+            if (!run_annotations.empty() &&
+                (page_index != run_first_page + (int)run_annotations.size() ||
+                 mapping->destination_node.num != run_node.num ||
+                 mapping->spm_slot_addr != run_spm_addr + run_annotations.size()*getPageSizeBytes())) {
+                host_info->setHostMachineID(run_node);
+                host_info->setSPMaddress(run_spm_addr);
+                triggerPageDeAlloc(gov_request, host_info, run_v_page_addrs, run_annotations);
+                run_v_page_addrs.clear();
+                run_annotations.clear();
+            }
+
             host_info->setHostMachineID(mapping->destination_node);
             host_info->setSPMaddress(mapping->spm_slot_addr);
 
@@ -361,13 +498,24 @@ PMMU::removeATTMappingsVAddress(GOVRequest *gov_request, HostInfo *host_info)
 
             if (my_att->removeMapping(gov_request, page_index)) {
                 removed_pages++;
-                Annotations *orignal_annotations = gov_request->getAnnotations();
-                gov_request->setAnnotations(mapping_annotations);
-                if (mapping_annotations->alloc_mode != NUM_ALLOCATION_MODE) // if it was actually allocated
-                    triggerPageDeAlloc(gov_request, host_info, page_index);
-                else
+                if (mapping_annotations->shared_data &&
+                    mapping_annotations->alloc_mode != NUM_ALLOCATION_MODE) {
+                    dropSharedAliases(gov_request->getASID(), v_page_addr,
+                                      host_info->getHostMachineID(),
+                                      host_info->getSPMaddress());
+                }
+                if (mapping_annotations->alloc_mode != NUM_ALLOCATION_MODE) { // if it was actually allocated
+                    if (run_annotations.empty()) {
+                        run_first_page = page_index;
+                        run_node = host_info->getHostMachineID();
+                        run_spm_addr = host_info->getSPMaddress();
+                    }
+                    run_v_page_addrs.push_back(v_page_addr);
+                    run_annotations.push_back(mapping_annotations);
+                }
+                else {
                     delete mapping_annotations;
-                gov_request->setAnnotations(orignal_annotations);
+                }
             }
         }
 
@@ -376,6 +524,12 @@ PMMU::removeATTMappingsVAddress(GOVRequest *gov_request, HostInfo *host_info)
                     getNodeID(), v_page_addr);
         }
     }
+
+    if (!run_annotations.empty()) {
+        host_info->setHostMachineID(run_node);
+        host_info->setSPMaddress(run_spm_addr);
+        triggerPageDeAlloc(gov_request, host_info, run_v_page_addrs, run_annotations);
+    }
     return removed_pages;
 }
 
@@ -383,10 +537,13 @@ int
 PMMU::removeATTMappingsSPMAddress(GOVRequest *gov_request, HostInfo *host_info)
 {
     for (int i = 1; i <= host_info->getNumPages(); i++) {
-      Addr start_v_page_addr = my_att->slot2Addr(host_info->getHostPMMU()->getMachineID(),
-                               host_info->getSPMaddress());
+      ATTEntry *mapping = my_att->getMapping(host_info->getHostPMMU()->getMachineID(),
+                                             host_info->getSPMaddress());
+      Addr start_v_page_addr = mapping->v_page_addr;
 
-      gov_request->setAnnotations(my_att->getMapping(start_v_page_addr)->annotations);
+      // the slot may belong to any of the address spaces using this PMMU
+      gov_request->setASID(mapping->asid);
+      gov_request->setAnnotations(mapping->annotations);
 
       gov_request->address_range = AddrRange(start_v_page_addr,
                                                 start_v_page_addr + gov_request->getPageSizeBytes());
@@ -400,34 +557,61 @@ PMMU::removeATTMappingsSPMAddress(GOVRequest *gov_request, HostInfo *host_info)
 void
 PMMU::triggerPageDeAlloc(GOVRequest *gov_request,
                          HostInfo *host_info,
-                         int page_index)
+                         const std::vector<Addr> &run_v_page_addrs,
+                         const std::vector<Annotations*> &run_annotations)
 {
-    Addr v_page_addr = gov_request->getStartAddr(Unserved_Aligned) +
-                       page_index * gov_request->getPMMUPtr()->getPageSizeBytes();
+    GOVNodeContext node_context(this);
+
+    assert(run_v_page_addrs.size() == run_annotations.size());
+    int num_pages = run_annotations.size();
+    Addr start_v_page_addr = run_v_page_addrs.front();
     Addr p_spm_addr = host_info->getSPMaddress();
 
-    Addr p_page_addr;
-    bool translated = gov_request->getPageTablePtr()->translate(v_page_addr, p_page_addr);
-    if (!translated)
-        panic("Virtual page doesn't exist in page table!.\n");
+    Addr start_p_page_addr = 0;
+    PacketPtr dealloc_pkt = nullptr;
 
-    RequestPtr dealloc_req = new Request(p_page_addr, getPageSizeBytes(), Request::PHYSICAL, Request::funcMasterId);
-    PacketPtr dealloc_pkt = new Packet(dealloc_req, MemCmd::WriteReq, getPageSizeBytes());
-    dealloc_pkt->allocate();
-    dealloc_pkt->req->setFlags(Request::UNCACHEABLE | Request::STRICT_ORDER);
+    for (int page_index = 0; page_index < num_pages; page_index++) {
+        Addr v_page_addr = run_v_page_addrs[page_index];
+
+        Addr p_page_addr;
+        bool translated = gov_request->getPageTablePtr()->translate(v_page_addr, p_page_addr);
+        if (!translated)
+            panic("Virtual page doesn't exist in page table!.\n");
+
+        if (!dealloc_pkt) {
+            start_p_page_addr = p_page_addr;
+            RequestPtr dealloc_req = new Request(p_page_addr, num_pages * getPageSizeBytes(),
+                                                 Request::PHYSICAL, Request::funcMasterId);
+            dealloc_pkt = new Packet(dealloc_req, MemCmd::WriteReq, num_pages * getPageSizeBytes());
+            pkt_ext_pool.attach(dealloc_pkt);
+            dealloc_pkt->req->setFlags(Request::UNCACHEABLE | Request::STRICT_ORDER);
+        }
+
+        dealloc_pkt->govInfo().addRunPage(p_page_addr, v_page_addr, run_annotations[page_index]);
+    }
 
-    dealloc_pkt->spmInfo.setOrigin(m_machineID.num);
+    dealloc_pkt->spmInfo().setOrigin(m_machineID.num);
 
-    dealloc_pkt->govInfo.setAddresses(p_spm_addr, p_page_addr, v_page_addr);
-    dealloc_pkt->govInfo.markIncomplete();
-    dealloc_pkt->govInfo.makeDeallocate();
-    dealloc_pkt->govInfo.setAnnotations(gov_request->getAnnotations());
+    // the data itself is moved by the host spm's transfer engine
+    dealloc_pkt->govInfo().setAddresses(p_spm_addr, start_p_page_addr, start_v_page_addr);
+    dealloc_pkt->govInfo().setASID(gov_request->getASID());
+    dealloc_pkt->govInfo().markIncomplete();
+    dealloc_pkt->govInfo().makeDeallocate();
+    dealloc_pkt->govInfo().setAnnotations(run_annotations.front());
 
-    dealloc_pkt->govInfo.setSignaling(&(host_info->signaling));
+    dealloc_pkt->govInfo().setSignaling(&(host_info->signaling));
 
-    dealloc_pkt->govInfo.setStallStatus(dealloc_pkt->govInfo.getAnnotations()->dealloc_mode == WRITE_BACK);
+    dealloc_pkt->govInfo().setStallStatus(dealloc_pkt->govInfo().getAnnotations()->dealloc_mode == WRITE_BACK);
+
+    trackAsyncGOVReq(gov_request, dealloc_pkt);
+    outstanding_gov_pkts++;
+
+    if (my_spm_ptr->system->isAtomicMode()) {
+        atomicGOVReq(dealloc_pkt, host_info->getHostMachineID());
+        return;
+    }
 
-    std::shared_ptr<SPMRequestMsg> msg = std::make_shared<SPMRequestMsg>(clockEdge());
+    RefCountingPtr<SPMRequestMsg> msg = new SPMRequestMsg(clockEdge());
     msg->m_Type = SPMRequestType_DEALLOC;
     msg->m_PktPtr = dealloc_pkt;
     (msg->m_Destination).add(host_info->getHostMachineID());
@@ -441,15 +625,15 @@ PMMU::triggerPageDeAlloc(GOVRequest *gov_request,
         m_requestToNetwork_ptr->enqueue(msg, clockEdge(), 1);
     }
 
-    if (dealloc_pkt->govInfo.shouldStall()) {
+    if (dealloc_pkt->govInfo().shouldStall()) {
         // block the spm's cpu-side port
         my_spm_ptr->setBlocked(BaseSPM::Blocked_Alloc_DeAlloc_Relocate);
         // to make sure we don't unblock the port unless all pages are deallocated
         pending_gov_reqs++;
     }
 
-    DPRINTF(PMMU, "Node %d: Deallocating a page from node %d, spm address %d, should signal %d, node %d\n",
-                   getNodeID(), host_info->getHostMachineID().num, p_spm_addr,
+    DPRINTF(PMMU, "Node %d: Deallocating %d page(s) from node %d, spm address %d, should signal %d, node %d\n",
+                   getNodeID(), num_pages, host_info->getHostMachineID().num, p_spm_addr,
                    host_info->signaling.needs_to_signal, host_info->signaling.signalee);
 }
 
@@ -467,62 +651,247 @@ PMMU::changeATTMappingSPMAddress(HostInfo *current_host_info,
                                  GOVRequest *gov_request)
 {
     int num_pages = current_host_info->getNumPages();
+    Addr start_current_spm_addr = current_host_info->getSPMaddress();
+
+    // pages that are contiguous on both spms are moved as one run
+    Addr run_current_spm_addr = 0;
+    Addr run_future_spm_addr = 0;
+    std::vector<Annotations*> run_annotations;
 
     for (int page_index = 0; page_index < num_pages; page_index++) {
 
+        Addr current_spm_addr = start_current_spm_addr + page_index*getPageSizeBytes();
+        Addr future_spm_addr = future_host_info->getSPMaddress() + page_index*getPageSizeBytes();
+
         // change ATT mapping first
         if (gov_request) { // if virtual address given not spm address
             Addr start_v_page_addr = gov_request->getStartAddr(Unserved_Aligned);
             Addr v_page_addr = start_v_page_addr + page_index*getPageSizeBytes();
 
-            ATTEntry* current_mapping = my_att->getMapping(v_page_addr);
+            ATTEntry* current_mapping = my_att->getMapping(gov_request->getASID(), v_page_addr);
+            current_spm_addr = current_mapping->spm_slot_addr;
+
+            if (!run_annotations.empty() &&
+                (current_mapping->destination_node.num != current_host_info->getHostMachineID().num ||
+                 current_spm_addr != run_current_spm_addr + run_annotations.size()*getPageSizeBytes())) {
+                triggerPageRelocation(current_host_info, future_host_info,
+                                      run_current_spm_addr, run_future_spm_addr, run_annotations);
+                run_annotations.clear();
+            }
             current_host_info->setHostMachineID(current_mapping->destination_node);
-            current_host_info->setSPMaddress(current_mapping->spm_slot_addr);
         }
 
         ATTEntry* mapping = my_att->changeMapping(current_host_info->getHostMachineID(),
-                                                 current_host_info->getSPMaddress(),
+                                                 current_spm_addr,
                                                  future_host_info->getHostMachineID(),
-                                                 future_host_info->getSPMaddress());
+                                                 future_spm_addr);
         assert (mapping);
+        if (mapping->annotations && mapping->annotations->shared_data) {
+            moveSharedAliases(mapping->asid, mapping->v_page_addr,
+                              current_host_info->getHostMachineID(), current_spm_addr,
+                              future_host_info->getHostMachineID(), future_spm_addr);
+        }
         DPRINTF(ATTMap, "Node %d: Changing ATT mapping "
                      "from node %d, spm address %d to node %d, spm address %d\n",
                      getNodeID(),
                      current_host_info->getHostMachineID(),
-                     current_host_info->getSPMaddress(),
+                     current_spm_addr,
                      future_host_info->getHostMachineID(),
-                     future_host_info->getSPMaddress());
+                     future_spm_addr);
         // TODO: invalidate mapping during relocation and validate it again?
 
-        triggerPageRelocation(current_host_info, future_host_info, page_index, mapping->annotations);
+        if (run_annotations.empty()) {
+            run_current_spm_addr = current_spm_addr;
+            run_future_spm_addr = future_spm_addr;
+        }
+        run_annotations.push_back(mapping->annotations);
+    }
+
+    if (!run_annotations.empty()) {
+        triggerPageRelocation(current_host_info, future_host_info,
+                              run_current_spm_addr, run_future_spm_addr, run_annotations);
+    }
+}
+
+void
+PMMU::dropSharedAliases(uint64_t asid, Addr v_page_addr,
+                        MachineID node, Addr spm_slot_addr)
+{
+    for (auto pmmu : m_pmmus) {
+        if (!pmmu || pmmu == this) {
+            continue;
+        }
+
+        ATTEntry *alias = pmmu->my_att->getMapping(asid, v_page_addr);
+        if (!alias || !alias->alias || alias->destination_node.num != node.num ||
+            alias->spm_slot_addr != spm_slot_addr) {
+            continue;
+        }
+
+        DPRINTF(ATTMap, "Node %d: Dropping shared mapping of virtual address %x "
+                     "on node %d, spm address %d\n",
+                     pmmu->getNodeID(), v_page_addr, node.num, spm_slot_addr);
+
+        Annotations *alias_annotations = alias->annotations;
+        alias->num_owners = 1;
+        pmmu->my_att->removeMapping(asid, v_page_addr);
+        delete alias_annotations;
+    }
+}
+
+void
+PMMU::moveSharedAliases(uint64_t asid, Addr v_page_addr,
+                        MachineID node, Addr spm_slot_addr,
+                        MachineID new_node, Addr new_spm_slot_addr)
+{
+    for (auto pmmu : m_pmmus) {
+        if (!pmmu || pmmu == this) {
+            continue;
+        }
+
+        ATTEntry *alias = pmmu->my_att->getMapping(asid, v_page_addr);
+        if (alias && alias->alias && alias->destination_node.num == node.num &&
+            alias->spm_slot_addr == spm_slot_addr) {
+            pmmu->my_att->changeMapping(asid, v_page_addr, new_node, new_spm_slot_addr);
+        }
+    }
+}
+
+int
+PMMU::takeOverATTMappingsVAddress(GOVRequest *gov_request, PMMU *owner_pmmu)
+{
+    int num_pages = gov_request->getNumberOfPages(Unserved_Aligned);
+
+    int page_index;
+    for (page_index = 0; page_index < num_pages; page_index++) {
+        Addr v_page_addr = gov_request->getNthPageStartAddr(Unserved_Aligned, page_index);
+        if (!owner_pmmu->my_att->transferMapping(gov_request->getASID(), v_page_addr, my_att)) {
+            break;
+        }
+
+        // the slot belongs to us now, wherever it is
+        ATTEntry* mapping = my_att->getMapping(gov_request->getASID(), v_page_addr);
+        getPMMU(mapping->destination_node.num)->setUsedPages(mapping->spm_slot_addr, 1, getNodeID());
+
+        DPRINTF(ATTMap, "Node %d: Taking over ATT mapping of virtual address %x "
+                     "from node %d, on node %d, spm address %d\n",
+                     getNodeID(), v_page_addr, owner_pmmu->getNodeID(),
+                     mapping->destination_node, mapping->spm_slot_addr);
+    }
+
+    handed_off_pages += page_index;
+    return page_index;
+}
+
+int
+PMMU::copyATTMappingsVAddress(GOVRequest *gov_request, PMMU *owner_pmmu,
+                              HostInfo *future_host_info)
+{
+    int num_pages = future_host_info->getNumPages();
+    Addr start_v_page_addr = gov_request->getStartAddr(Unserved_Aligned);
+    HostInfo current_host_info (gov_request->getThreadContext(), this, nullptr, Addr(0), num_pages);
+
+    // pages that are contiguous on both spms are copied as one run
+    Addr run_current_spm_addr = 0;
+    Addr run_future_spm_addr = 0;
+    std::vector<Annotations*> run_annotations;
+
+    int page_index;
+    for (page_index = 0; page_index < num_pages; page_index++) {
+        Addr v_page_addr = start_v_page_addr + page_index*getPageSizeBytes();
+        Addr future_spm_addr = future_host_info->getSPMaddress() + page_index*getPageSizeBytes();
+
+        ATTEntry* source_mapping = owner_pmmu->my_att->getMapping(gov_request->getASID(), v_page_addr);
+        assert (source_mapping);
+
+        if (my_att->addMapping(gov_request->getASID(), v_page_addr,
+                               future_host_info->getHostMachineID(), future_spm_addr,
+                               source_mapping->annotations) != ATT::ATT_Added) {
+            break;
+        }
+        // the copy is usable as soon as the relocation lets us in again
+        ATTEntry* mapping = my_att->getMapping(gov_request->getASID(), v_page_addr);
+        my_att->validateATTEntry(mapping);
+
+        if (!run_annotations.empty() &&
+            (source_mapping->destination_node.num != current_host_info.getHostMachineID().num ||
+             source_mapping->spm_slot_addr != run_current_spm_addr + run_annotations.size()*getPageSizeBytes())) {
+            triggerPageRelocation(&current_host_info, future_host_info,
+                                  run_current_spm_addr, run_future_spm_addr, run_annotations, true);
+            run_annotations.clear();
+        }
+        current_host_info.setHostMachineID(source_mapping->destination_node);
+
+        DPRINTF(ATTMap, "Node %d: Copying page of virtual address %x of node %d "
+                     "from node %d, spm address %d to node %d, spm address %d\n",
+                     getNodeID(), v_page_addr, owner_pmmu->getNodeID(),
+                     source_mapping->destination_node, source_mapping->spm_slot_addr,
+                     future_host_info->getHostMachineID(), future_spm_addr);
+
+        if (run_annotations.empty()) {
+            run_current_spm_addr = source_mapping->spm_slot_addr;
+            run_future_spm_addr = future_spm_addr;
+        }
+        run_annotations.push_back(mapping->annotations);
     }
+
+    if (!run_annotations.empty()) {
+        triggerPageRelocation(&current_host_info, future_host_info,
+                              run_current_spm_addr, run_future_spm_addr, run_annotations, true);
+    }
+
+    copied_pages += page_index;
+    return page_index;
 }
 
 void
 PMMU::triggerPageRelocation(HostInfo *current_host_info,
                             HostInfo *future_host_info,
-                            int page_index,
-                            Annotations *att_annotation_ptr)
+                            Addr current_spm_addr,
+                            Addr future_spm_addr,
+                            const std::vector<Annotations*> &run_annotations,
+                            bool keep_source)
 {
-    RequestPtr relocation_req = new Request(0, getPageSizeBytes(), Request::PHYSICAL, Request::funcMasterId);
-    PacketPtr relocate_pkt = new Packet(relocation_req, MemCmd::ReadReq, getPageSizeBytes());
+    GOVNodeContext node_context(this);
+
+    int num_pages = run_annotations.size();
+
+    // the whole run travels in one packet: read on the current host,
+    // then written on the future host
+    RequestPtr relocation_req = new Request(0, num_pages * getPageSizeBytes(),
+                                            Request::PHYSICAL, Request::funcMasterId);
+    PacketPtr relocate_pkt = new Packet(relocation_req, MemCmd::ReadReq,
+                                        num_pages * getPageSizeBytes());
+    pkt_ext_pool.attach(relocate_pkt);
     relocate_pkt->allocate();
 
-    relocate_pkt->spmInfo.setSPMAddress(current_host_info->getSPMaddress());
-    relocate_pkt->spmInfo.setOrigin(m_machineID.num);
+    relocate_pkt->spmInfo().setSPMAddress(current_spm_addr);
+    relocate_pkt->spmInfo().setOrigin(m_machineID.num);
 
-    relocate_pkt->govInfo.setSPMAddress(current_host_info->getSPMaddress() + page_index*getPageSizeBytes());
-    relocate_pkt->govInfo.setFutureHost(future_host_info->getHostMachineID().num);
-    relocate_pkt->govInfo.setFutureSPMAddress(future_host_info->getSPMaddress() + page_index*getPageSizeBytes());
+    relocate_pkt->govInfo().setSPMAddress(current_spm_addr);
+    relocate_pkt->govInfo().setFutureHost(future_host_info->getHostMachineID().num);
+    relocate_pkt->govInfo().setFutureSPMAddress(future_spm_addr);
+    for (int page_index = 0; page_index < num_pages; page_index++) {
+        relocate_pkt->govInfo().addRunPage(0, 0, run_annotations[page_index]);
+    }
 
-    relocate_pkt->govInfo.markIncomplete();
-    relocate_pkt->govInfo.makeRelocationRead();
-    relocate_pkt->govInfo.setAnnotations(att_annotation_ptr);
+    relocate_pkt->govInfo().markIncomplete();
+    relocate_pkt->govInfo().makeRelocationRead();
+    relocate_pkt->govInfo().setAnnotations(run_annotations.front());
+    if (keep_source) {
+        relocate_pkt->govInfo().keepSource();
+    }
+
+    relocate_pkt->govInfo().setSignaling(&(current_host_info->signaling));
+    relocate_pkt->govInfo().setStallStatus(true);
+    outstanding_gov_pkts++;
 
-    relocate_pkt->govInfo.setSignaling(&(current_host_info->signaling));
-    relocate_pkt->govInfo.setStallStatus(true);
+    if (my_spm_ptr->system->isAtomicMode()) {
+        atomicGOVReq(relocate_pkt, current_host_info->getHostMachineID());
+        return;
+    }
 
-    std::shared_ptr<SPMRequestMsg> msg = std::make_shared<SPMRequestMsg>(clockEdge());
+    RefCountingPtr<SPMRequestMsg> msg = new SPMRequestMsg(clockEdge());
     msg->m_Type = SPMRequestType_RELOCATE_READ;
     msg->m_PktPtr = relocate_pkt;
     (msg->m_Destination).add(current_host_info->getHostMachineID());
@@ -536,44 +905,131 @@ PMMU::triggerPageRelocation(HostInfo *current_host_info,
         m_requestToNetwork_ptr->enqueue(msg, clockEdge(), 1);
     }
 
-    if (relocate_pkt->govInfo.shouldStall()) {
+    if (relocate_pkt->govInfo().shouldStall()) {
         // block the spm's cpu-side port
         my_spm_ptr->setBlocked(BaseSPM::Blocked_Alloc_DeAlloc_Relocate);
         // to make sure we don't unblock the port unless all pages are relocated
         pending_gov_reqs++;
     }
 
-    DPRINTF(PMMU, "Node %d: Relocating(read) a page from node %d, spm address %d, "
+    DPRINTF(PMMU, "Node %d: Relocating(read) %d page(s) from node %d, spm address %d, "
                   "to node %d, spm address %d, should signal %d, node %d\n",
-                   getNodeID(),
+                   getNodeID(), num_pages,
                    current_host_info->getHostMachineID(),
-                   current_host_info->getSPMaddress(),
+                   current_spm_addr,
                    future_host_info->getHostMachineID(),
-                   future_host_info->getSPMaddress(),
+                   future_spm_addr,
                    current_host_info->signaling.needs_to_signal,
                    current_host_info->signaling.signalee);
 }
 
+uint64_t
+PMMU::openTicket()
+{
+    async_gov_reqs++;
+    return next_ticket++;
+}
+
+bool
+PMMU::isTicketComplete(uint64_t ticket) const
+{
+    // synchronous requests hand out ticket 0, they are done on return
+    if (ticket == 0)
+        return true;
+
+    // the ticket comes from the guest, which mustn't bring the host down
+    if (ticket >= next_ticket) {
+        warn_once("Node %d: unknown SPM ticket %d, taken as complete\n",
+                  getNodeID(), ticket);
+        return true;
+    }
+
+    return pending_tickets.find(ticket) == pending_tickets.end();
+}
+
+void
+PMMU::trackAsyncGOVReq(GOVRequest *gov_request, PacketPtr gov_pkt)
+{
+    uint64_t ticket = gov_request->getTicket();
+    if (ticket == 0)
+        return;
+
+    // the core keeps running and the spm keeps serving resident pages;
+    // the pages of this run are only safe to touch once the ticket is done
+    gov_pkt->govInfo().setStallStatus(false);
+    gov_pkt->govInfo().setTicket(ticket);
+    pending_tickets[ticket]++;
+    async_gov_pkts++;
+}
+
+void
+PMMU::atomicGOVReq(PacketPtr gov_pkt, const MachineID &host_node)
+{
+    // nothing else is in flight in atomic mode: the request is done before
+    // the governor moves on, so the core never stalls and nobody waits for
+    // a relocation signal
+    bool has_signalee = gov_pkt->govInfo().hasSignalee();
+    gov_pkt->govInfo().setStallStatus(false);
+    gov_pkt->govInfo().shouldNotWait();
+    gov_pkt->govInfo().shouldNotSignal();
+
+    PMMU *host_pmmu = getPMMU(host_node.num);
+    {
+        GOVNodeContext host_context(host_pmmu);
+        host_pmmu->spmMasterPort->sendAtomic(gov_pkt);
+    }
+
+    // a slot handed over to a signalee is already used by its new owner
+    if (gov_pkt->govInfo().isRelocationRead()) {
+        if (!has_signalee && !gov_pkt->govInfo().keepsSource()) {
+            host_pmmu->setFreePages(gov_pkt->govInfo().getSPMAddress(),
+                                    gov_pkt->govInfo().getNumPages());
+        }
+
+        gov_pkt->cmd = MemCmd::WriteReq;
+        gov_pkt->spmInfo().setSPMAddress(gov_pkt->govInfo().getFutureSPMAddress());
+        gov_pkt->govInfo().markIncomplete();
+        gov_pkt->govInfo().makeRelocationWrite();
+
+        PMMU *future_host_pmmu = getPMMU(gov_pkt->govInfo().getFutureHost());
+        GOVNodeContext future_host_context(future_host_pmmu);
+        future_host_pmmu->spmMasterPort->sendAtomic(gov_pkt);
+    }
+    else if (gov_pkt->govInfo().isDeallocate() && !has_signalee) {
+        host_pmmu->setFreePages(gov_pkt->govInfo().getSPMAddress(),
+                                gov_pkt->govInfo().getNumPages());
+    }
+
+    DPRINTF(PMMU, "Node %d: Served gov request of %d page(s) on node %d in atomic mode\n",
+                   getNodeID(), gov_pkt->govInfo().getNumPages(), host_node.num);
+
+    finalizeLocalGOVReq(gov_pkt);
+}
+
 void
 PMMU::continuePageRelocationRequest(PacketPtr relocation_pkt)
 {
     relocation_pkt->cmd = MemCmd::WriteReq;
-    relocation_pkt->spmInfo.setSPMAddress(relocation_pkt->govInfo.getFutureSPMAddress());
+    relocation_pkt->spmInfo().setSPMAddress(relocation_pkt->govInfo().getFutureSPMAddress());
 
-    relocation_pkt->govInfo.markIncomplete();
-    relocation_pkt->govInfo.makeRelocationWrite();
+    relocation_pkt->govInfo().markIncomplete();
+    relocation_pkt->govInfo().makeRelocationWrite();
 
-    relocation_pkt->govInfo.shouldNotWait();
+    relocation_pkt->govInfo().shouldNotWait();
 
-    std::shared_ptr<SPMRequestMsg> msg = std::make_shared<SPMRequestMsg>(clockEdge());
+    RefCountingPtr<SPMRequestMsg> msg = new SPMRequestMsg(clockEdge());
     msg->m_Type = SPMRequestType_RELOCATE_WRITE;
     msg->m_PktPtr = relocation_pkt;
     MachineID future_host_node;
-    future_host_node.num = relocation_pkt->govInfo.getFutureHost();
+    future_host_node.num = relocation_pkt->govInfo().getFutureHost();
     future_host_node.type = MachineType_PMMU;
     (msg->m_Destination).add(future_host_node);
     msg->m_Requestor = m_machineID;
+    // the whole run goes in this one data message, the pages past the
+    // first block ride on top of its size
     msg->m_MessageSize = MessageSizeType_Data;
+    msg->m_ExtraDataBytes = relocation_pkt->govInfo().getNumPages() *
+                            getPageSizeBytes() - RubySystem::getBlockSizeBytes();
 
     if (future_host_node.num == m_machineID.num) {
         m_requestToSPM_ptr->enqueue(msg, clockEdge(), 1);
@@ -583,8 +1039,8 @@ PMMU::continuePageRelocationRequest(PacketPtr relocation_pkt)
     }
 
     DPRINTF(PMMU, "Node %d: Relocating(write) a page to node %d, spm address %d requested by node %d\n",
-                   getNodeID(), relocation_pkt->govInfo.getFutureHost(),
-                   relocation_pkt->govInfo.getFutureSPMAddress(), relocation_pkt->spmInfo.getOrigin());
+                   getNodeID(), relocation_pkt->govInfo().getFutureHost(),
+                   relocation_pkt->govInfo().getFutureSPMAddress(), relocation_pkt->spmInfo().getOrigin());
 }
 
 void
@@ -593,9 +1049,11 @@ PMMU::setFreePages(Addr start_p_spm_addr, int num_pages)
     int ind = start_p_spm_addr / getPageSizeBytes();
     int ctr;
     for (ctr = 0; ctr < num_pages; ctr++) {
-        assert (ctr+ind < getSPMSizePages());
+        assert (ctr+ind < getSPMMaxPages());
         my_spm_ptr->spmSlots[ctr+ind].setFree();
     }
+    my_spm_ptr->freePageIndex.setFree(ind, num_pages);
+    my_spm_ptr->timelineCounters.deallocatedPages += num_pages;
 }
 
 void
@@ -605,30 +1063,32 @@ PMMU::setUsedPages(Addr start_p_spm_addr, int num_pages,
     int ind = start_p_spm_addr / getPageSizeBytes();
     int ctr;
     for (ctr = 0; ctr < num_pages; ctr++) {
-        assert (ctr+ind < getSPMSizePages());
+        assert (ctr+ind < getSPMMaxPages());
         my_spm_ptr->spmSlots[ctr+ind].setUsed();
         my_spm_ptr->spmSlots[ctr+ind].setOwner(owner);
     }
+    my_spm_ptr->freePageIndex.setUsed(ind, num_pages);
+    my_spm_ptr->timelineCounters.allocatedPages += num_pages;
 }
 
 bool
 PMMU::sendRelocationDone(PacketPtr pkt)
 {
-    bool signal_required = pkt->govInfo.hasSignalee();
+    bool signal_required = pkt->govInfo().hasSignalee();
 
     MachineID dest;
-    dest.num = pkt->govInfo.getSignalee();
+    dest.num = pkt->govInfo().getSignalee();
     dest.type = MachineType_PMMU;
 
     if (signal_required){
 
         DPRINTF(PMMU, "Node %d: SPMResponseType_RELOCATION_DONE to node %d \n",
-                getNodeID(), pkt->govInfo.getSignalee());
+                getNodeID(), pkt->govInfo().getSignalee());
 
         //SPMResponseMsg *msg = new SPMResponseMsg(clockEdge());
-        std::shared_ptr<SPMResponseMsg> msg = std::make_shared<SPMResponseMsg>(clockEdge());
+        RefCountingPtr<SPMResponseMsg> msg = new SPMResponseMsg(clockEdge());
 
-        pkt->spmInfo.setOrigin(getNodeID());
+        pkt->spmInfo().setOrigin(getNodeID());
         msg->m_PktPtr = pkt;
         (msg->m_Destination).add(dest);
         msg->m_Sender = m_machineID;
@@ -646,8 +1106,8 @@ PMMU::fireupPendingAllocs(PacketPtr pkt)
 {
     // for all of the local alloc reqs, if their current_user, matches previous_owner, then make them active
 
-    NodeID signalee = pkt->spmInfo.getOrigin();
-    Addr p_spm_addr = pkt->govInfo.getSPMAddress();
+    NodeID signalee = pkt->spmInfo().getOrigin();
+    Addr p_spm_addr = pkt->govInfo().getSPMAddress();
 
     unsigned int size = m_requestToSPM_ptr->getSize(curTick());
     unsigned int it = 0;
@@ -657,9 +1117,9 @@ PMMU::fireupPendingAllocs(PacketPtr pkt)
 
         SPMRequestMsg* msg = const_cast<SPMRequestMsg *>(dynamic_cast<const SPMRequestMsg *>(m_requestToSPM_ptr->peekNthMsg(it)));
 
-        if (msg->m_PktPtr->govInfo.getSignaler() == signalee &&
-            msg->m_PktPtr->govInfo.getSPMAddress() == p_spm_addr) {
-            msg->m_PktPtr->govInfo.shouldNotWait();
+        if (msg->m_PktPtr->govInfo().getSignaler() == signalee &&
+            msg->m_PktPtr->govInfo().getSPMAddress() == p_spm_addr) {
+            msg->m_PktPtr->govInfo().shouldNotWait();
             success++;
         }
     }
@@ -685,7 +1145,7 @@ PMMU::getNextReadyRequestMsg(MessageBuffer *mb) const
 
         assert(msg->m_PktPtr->isRequest());
 
-        if (!msg->m_PktPtr->govInfo.hasSignaler()) {
+        if (!msg->m_PktPtr->govInfo().hasSignaler()) {
             return (msg);
         }
 
@@ -707,31 +1167,41 @@ void
 PMMU::finalizeLocalGOVReq(PacketPtr gov_pkt)
 {
 
-    if (gov_pkt->govInfo.shouldStall()) {
+    assert(outstanding_gov_pkts > 0);
+    outstanding_gov_pkts--;
+    if (gov_pkt->govInfo().shouldStall()) {
         pending_gov_reqs--;
     }
+    if (gov_pkt->govInfo().getTicket()) {
+        auto it = pending_tickets.find(gov_pkt->govInfo().getTicket());
+        assert(it != pending_tickets.end() && it->second > 0);
+        if (--(it->second) == 0) {
+            DPRINTF(PMMU, "Node %d: Ticket %d completed\n", getNodeID(), it->first);
+            pending_tickets.erase(it);
+        }
+    }
     if (pending_gov_reqs == 0 && my_spm_ptr->isBlocked()) {
         my_spm_ptr->clearBlocked(BaseSPM::Blocked_Alloc_DeAlloc_Relocate);
     }
 
-    Addr start_v_page_addr = gov_pkt->govInfo.getVirtualAddress();
+    if (gov_pkt->govInfo().isAllocate()){
+        DPRINTF(PMMU, "Node %d: Finalizing allocation of %d page(s)\n",
+                getNodeID(), gov_pkt->govInfo().getNumPages());
 
-    if (gov_pkt->govInfo.isAllocate()){
-        // if we've not been kicked out by the owner while we were busy allocating the slot on-chip
-        if (my_att->hasMapping(start_v_page_addr)){
+        for (int page_index = 0; page_index < gov_pkt->govInfo().getNumPages(); page_index++) {
+            Addr v_page_addr = gov_pkt->govInfo().getRunPage(page_index).mem_v_addr;
 
-            DPRINTF(PMMU, "Node %d: Finalizing allocation\n", getNodeID());
-
-            ATTEntry *translation = my_att->getMapping(start_v_page_addr);
-            assert (translation);
-
-            my_att->validateATTEntry(translation);
+            // if we've not been kicked out by the owner while we were busy allocating the slot on-chip
+            ATTEntry *translation = my_att->lookup(gov_pkt->govInfo().getASID(), v_page_addr);
+            if (translation){
+                my_att->validateATTEntry(translation);
+            }
         }
     }
-    else if (gov_pkt->govInfo.isDeallocate()) {
+    else if (gov_pkt->govInfo().isDeallocate()) {
         DPRINTF(PMMU, "Node %d: Finalizing deallocation\n", getNodeID());
     }
-    else if (gov_pkt->govInfo.isRelocationWrite()) {
+    else if (gov_pkt->govInfo().isRelocationWrite()) {
         DPRINTF(PMMU, "Node %d: Finalizing relocation\n", getNodeID());
     }
     else {
@@ -745,6 +1215,8 @@ PMMU::finalizeLocalGOVReq(PacketPtr gov_pkt)
         delete gov_pkt->req;
         delete gov_pkt;
     }
+
+    checkDrain();
 }
 
 ////////////////////
@@ -764,14 +1236,14 @@ PMMU::processRemoteRequestMsg(bool *sending_mem_reqs_allowed)
         PacketPtr reqPacket = in_msg_ptr->m_PktPtr;
         assert(reqPacket->isRequest());
 
-        if ((in_msg_ptr->getType() == SPMRequestType_ALLOC) && (in_msg_ptr->m_PktPtr->govInfo.hasSignaler())) {
+        if ((in_msg_ptr->getType() == SPMRequestType_ALLOC) && (in_msg_ptr->m_PktPtr->govInfo().hasSignaler())) {
             // do nothing
             DPRINTF(PMMU, "Node %d: SPMRequestType_ALLOC should wait for node %d\n",
-                    getNodeID(), in_msg_ptr->m_PktPtr->govInfo.getSignaler());
+                    getNodeID(), in_msg_ptr->m_PktPtr->govInfo().getSignaler());
         }
         else if (in_msg_ptr->getType() == SPMRequestType_ALLOC) {
             DPRINTF(PMMU, "Node %d: SPMRequestType_ALLOC from node %d\n",
-                    getNodeID(), reqPacket->spmInfo.getOrigin());
+                    getNodeID(), reqPacket->spmInfo().getOrigin());
             if (*sending_mem_reqs_allowed){
                 // we shouldn't forward any other memory request to spm
                 my_spm_ptr->conditionalBlocking(BaseSPM::Blocked_MaxPendingReqs);
@@ -782,7 +1254,7 @@ PMMU::processRemoteRequestMsg(bool *sending_mem_reqs_allowed)
         }
         else if (in_msg_ptr->getType() == SPMRequestType_DEALLOC) {
             DPRINTF(PMMU, "Node %d: SPMRequestType_DEALLOC from node %d\n",
-                    getNodeID(), reqPacket->spmInfo.getOrigin());
+                    getNodeID(), reqPacket->spmInfo().getOrigin());
             if (*sending_mem_reqs_allowed){
                 // we shouldn't forward any other memory request to spm
                 my_spm_ptr->conditionalBlocking(BaseSPM::Blocked_MaxPendingReqs);
@@ -793,19 +1265,19 @@ PMMU::processRemoteRequestMsg(bool *sending_mem_reqs_allowed)
         }
         else if (in_msg_ptr->getType() == SPMRequestType_RELOCATE_READ) {
             DPRINTF(PMMU, "Node %d: SPMRequestType_RELOCATE_READ from node %d\n",
-                    getNodeID(), reqPacket->spmInfo.getOrigin());
+                    getNodeID(), reqPacket->spmInfo().getOrigin());
             spmMasterPort->schedTimingReq(reqPacket, curTick());
             msg_processed = true;
         }
         else if (in_msg_ptr->getType() == SPMRequestType_RELOCATE_WRITE) {
             DPRINTF(PMMU, "Node %d: SPMRequestType_RELOCATE_WRITE from node %d\n",
-                    getNodeID(), reqPacket->spmInfo.getOrigin());
+                    getNodeID(), reqPacket->spmInfo().getOrigin());
             spmMasterPort->schedTimingReq(reqPacket, curTick());
             msg_processed = true;
         }
         else {
             DPRINTF(PMMU, "Node %d: SPMRequestType_READ/WRITE from node %d\n",
-                    getNodeID(), reqPacket->spmInfo.getOrigin());
+                    getNodeID(), reqPacket->spmInfo().getOrigin());
             spmMasterPort->schedTimingReq(reqPacket, curTick());
             msg_processed = true;
         }
@@ -827,7 +1299,7 @@ PMMU::processLocalRequestMsg(bool *sending_mem_reqs_allowed)
 
     PacketPtr req_packet = in_msg_ptr->m_PktPtr;
 
-    if (in_msg_ptr->m_PktPtr->spmInfo.isLocal()) {
+    if (in_msg_ptr->m_PktPtr->spmInfo().isLocal()) {
         assert(req_packet->needsResponse());
         req_packet->saveCmd();
         req_packet->makeResponse(); // This should be makeResponse because we don't need to fwd it to main memory
@@ -835,11 +1307,11 @@ PMMU::processLocalRequestMsg(bool *sending_mem_reqs_allowed)
         spmSlavePort->schedTimingResp(req_packet, curTick());
         m_requestFromSPM_ptr->dequeue(clockEdge());
     }
-    else if (in_msg_ptr->m_PktPtr->spmInfo.isRemote()){
+    else if (in_msg_ptr->m_PktPtr->spmInfo().isRemote()){
         m_requestFromSPM_ptr->dequeue(clockEdge());
         m_requestToNetwork_ptr->enqueue(msg_ptr, curTick(), 1);
     }
-    else if (!in_msg_ptr->m_PktPtr->spmInfo.isOnChip() && *sending_mem_reqs_allowed){
+    else if (!in_msg_ptr->m_PktPtr->spmInfo().isOnChip() && *sending_mem_reqs_allowed){
         my_spm_ptr->conditionalBlocking(BaseSPM::Blocked_MaxPendingReqs);
         *sending_mem_reqs_allowed = false;
 
@@ -891,7 +1363,7 @@ PMMU::processLocalResponseMsg()
     PacketPtr resp_packet = in_msg_ptr->m_PktPtr;
 
     // local gov_ack
-    if (in_msg_ptr->getType() == SPMResponseType_GOV_ACK && in_msg_ptr->m_PktPtr->spmInfo.getOrigin() == getNodeID()) {
+    if (in_msg_ptr->getType() == SPMResponseType_GOV_ACK && in_msg_ptr->m_PktPtr->spmInfo().getOrigin() == getNodeID()) {
         DPRINTF(PMMU, "Node %d: SPMResponseType_GOV_ACK\n", getNodeID());
 
         finalizeLocalGOVReq(resp_packet);
@@ -899,7 +1371,7 @@ PMMU::processLocalResponseMsg()
     }
     else if (in_msg_ptr->getType() == SPMResponseType_RELOCATION_HALFWAY) { // first part of relocation
         DPRINTF(PMMU, "Node %d: SPMResponseType_RELOCATION_HALFWAY for node %d\n",
-                getNodeID(), resp_packet->spmInfo.getOrigin());
+                getNodeID(), resp_packet->spmInfo().getOrigin());
 
         continuePageRelocationRequest(resp_packet);
         m_responseFromSPM_ptr->dequeue(clockEdge());
@@ -987,55 +1459,92 @@ PMMU::wakeup()
 //
 ////////////////////
 
-bool
-PMMU::generateAccessReqMsg(PacketPtr pkt)
+uint64_t
+PMMU::getRequestASID(PacketPtr pkt) const
+{
+    assert(pkt->req->hasContextId());
+    ThreadContext *tc = my_spm_ptr->system->getThreadContext(pkt->req->contextId());
+    return tc->getProcessPtr()->tgid();
+}
+
+Process *
+PMMU::getASIDProcess(uint64_t asid) const
+{
+    for (auto tc : my_spm_ptr->system->threadContexts) {
+        Process *process = tc->getProcessPtr();
+        if (process && process->tgid() == asid) {
+            return process;
+        }
+    }
+    panic("Node %d: no process has address space %d\n", getNodeID(), asid);
+}
+
+ATTEntry *
+PMMU::translateAccess(PacketPtr pkt)
 {
     assert(pkt->isRequest());
 
     // enhance packet with spm stuff
-    pkt->spmInfo.setOrigin(getNodeID());
+    pkt_ext_pool.attach(pkt);
+    pkt->spmInfo().setOrigin(getNodeID());
     Addr req_v_page_addr = spmPageAlign(pkt->req->getVaddr());
-    bool att_hit = my_att->isHit(req_v_page_addr);
+    uint64_t asid = getRequestASID(pkt);
+    my_stream_engine->observe(asid, req_v_page_addr);
 
     ATTEntry *translation = NULL;
-    Addr spm_p_addr = 0;
+    ATTLookasideBuffer::LookupResult lookup_result =
+        my_att_lookaside->lookup(asid, req_v_page_addr, &translation);
 
-    if (att_hit) {
+    if (lookup_result == ATTLookasideBuffer::ATT_Hit) {
         DPRINTF (ATTLookup, "Node %d, ATT hit for virtual page: %x\n", getNodeID(), pkt->req->getVaddr());
 
-        translation = my_att->getMapping(req_v_page_addr);
-        spm_p_addr = translation->spm_slot_addr | pkt->getOffset(getPageSizeBytes());  //TODO:  needs to be block size
-        pkt->spmInfo.setSPMAddress(spm_p_addr);
+        // a write to a replicated page leaves a single copy behind
+        if (translation->read_only && pkt->isWrite()) {
+            GOVLock gov_lock;
+            my_governor_ptr->collapseReplicas(this, asid, req_v_page_addr);
+            translation = my_att->getMapping(asid, req_v_page_addr);
+            assert(translation && !translation->read_only);
+        }
+
+        Addr spm_p_addr = translation->spm_slot_addr | pkt->getOffset(getPageSizeBytes());  //TODO:  needs to be block size
+        pkt->spmInfo().setSPMAddress(spm_p_addr);
 
         // if on local spm
         if (translation->destination_node.num == getNodeID()) {
-            pkt->spmInfo.makeLocal();
+            pkt->spmInfo().makeLocal();
         }
         else {  // else it's remote
-            pkt->spmInfo.makeRemote();
+            pkt->spmInfo().makeRemote();
         }
+        return translation;
     }
-    else {
-        DPRINTF (ATTLookup, "Node %d, ATT miss for virtual page: %x\n", getNodeID(), pkt->req->getVaddr());
 
-        // it's not allocated on SPM, but there was an allocation request for it
-        if (my_att->hasMapping(req_v_page_addr)) {
-            pkt->req->setFlags(Request::UNCACHEABLE | Request::STRICT_ORDER);
-            pkt->spmInfo.makeUnallocated();
-        }
-        else { // otherwise it should be accessed from cache hierarchy or off-chip mem
-            pkt->spmInfo.makeNotSPMSpace();
-        }
+    DPRINTF (ATTLookup, "Node %d, ATT miss for virtual page: %x\n", getNodeID(), pkt->req->getVaddr());
+
+    // it's not allocated on SPM, but there was an allocation request for it
+    if (lookup_result == ATTLookasideBuffer::ATT_Unallocated) {
+        pkt->req->setFlags(Request::UNCACHEABLE | Request::STRICT_ORDER);
+        pkt->spmInfo().makeUnallocated();
+    }
+    else { // otherwise it should be accessed from cache hierarchy or off-chip mem
+        pkt->spmInfo().makeNotSPMSpace();
     }
+    return NULL;
+}
+
+bool
+PMMU::generateAccessReqMsg(PacketPtr pkt)
+{
+    ATTEntry *translation = translateAccess(pkt);
 
     // create message
-    std::shared_ptr<SPMRequestMsg> msg = std::make_shared<SPMRequestMsg>(curTick());
+    RefCountingPtr<SPMRequestMsg> msg = new SPMRequestMsg(curTick());
     msg->m_PktPtr = pkt;
     msg->m_Requestor = getMachineID();
     msg->m_Type = pkt->isRead() ? SPMRequestType_READ : SPMRequestType_WRITE;
     msg->m_MessageSize = MessageSizeType_Access;
-    (msg->m_Destination).add(att_hit ? translation->destination_node : getMachineID());
-    msg->m_Addr = !pkt->spmInfo.isOnChip() ? pkt->req->getVaddr() : spm_p_addr;
+    (msg->m_Destination).add(translation ? translation->destination_node : getMachineID());
+    msg->m_Addr = !pkt->spmInfo().isOnChip() ? pkt->req->getVaddr() : pkt->spmInfo().getSPMAddress();
 
     m_requestFromSPM_ptr->enqueue(msg, curTick(), 1);
     return true;
@@ -1048,11 +1557,11 @@ PMMU::generateAccessRespMsg(PacketPtr pkt)
     // none!
 
     // create message
-    std::shared_ptr<SPMResponseMsg> msg = std::make_shared<SPMResponseMsg>(curTick());
+    RefCountingPtr<SPMResponseMsg> msg = new SPMResponseMsg(curTick());
     msg->m_PktPtr = pkt; // pkt should already be a response packet from spm
     msg->m_Sender = getMachineID();
     MachineID req_owner;
-    req_owner.num = pkt->spmInfo.getOrigin();
+    req_owner.num = pkt->spmInfo().getOrigin();
     req_owner.type = MachineType_PMMU;
     (msg->m_Destination).add(req_owner);
     msg->m_Type = pkt->isRead() ? SPMResponseType_DATA : SPMResponseType_WRITE_ACK;
@@ -1069,28 +1578,28 @@ PMMU::generateGovRespMsg(PacketPtr pkt)
     // none!
 
     // create message
-    std::shared_ptr<SPMResponseMsg> msg = std::make_shared<SPMResponseMsg>(clockEdge());
+    RefCountingPtr<SPMResponseMsg> msg = new SPMResponseMsg(clockEdge());
     msg->m_PktPtr = pkt; // pkt should already be a response packet from spm
     msg->m_Sender = getMachineID();
     MachineID req_owner;
-    req_owner.num = pkt->spmInfo.getOrigin();
+    req_owner.num = pkt->spmInfo().getOrigin();
     req_owner.type = MachineType_PMMU;
     (msg->m_Destination).add(req_owner);
 
-    if (pkt->govInfo.isComplete()) {
+    if (pkt->govInfo().isComplete()) {
         msg->m_Type = SPMResponseType_GOV_ACK;
-        if (pkt->govInfo.isDeallocate() && !pkt->govInfo.hasSignalee()) {
-            setFreePages(pkt->govInfo.getSPMAddress(), 1); // TODO: Always one slot?
+        if (pkt->govInfo().isDeallocate() && !pkt->govInfo().hasSignalee()) {
+            setFreePages(pkt->govInfo().getSPMAddress(), pkt->govInfo().getNumPages());
         }
     }
-    else if (pkt->govInfo.isRelocationRead()) {
+    else if (pkt->govInfo().isRelocationRead()) {
         msg->m_Type = SPMResponseType_RELOCATION_HALFWAY;
         // TODO: making the page free overrides the fact that already set it to occupied for the next user in the gov
-        if (!pkt->govInfo.hasSignalee()) {
-            setFreePages(pkt->govInfo.getSPMAddress(), 1); // TODO: Always one slot?
+        if (!pkt->govInfo().hasSignalee() && !pkt->govInfo().keepsSource()) {
+            setFreePages(pkt->govInfo().getSPMAddress(), pkt->govInfo().getNumPages());
         }
     }
-    else if (pkt->govInfo.isRelocationWrite()) {
+    else if (pkt->govInfo().isRelocationWrite()) {
         msg->m_Type = SPMResponseType_GOV_ACK;
     }
     else {
@@ -1112,7 +1621,7 @@ PMMU::recvSPMTimingReq(PacketPtr pkt)
 bool
 PMMU::recvSPMTimingResp(PacketPtr pkt)
 {
-    if (pkt->govInfo.isGOVReq()) {
+    if (pkt->govInfo().isGOVReq()) {
         return generateGovRespMsg(pkt);
     }
     else {
@@ -1120,6 +1629,115 @@ PMMU::recvSPMTimingResp(PacketPtr pkt)
     }
 }
 
+Tick
+PMMU::recvSPMAtomicReq(PacketPtr pkt)
+{
+    ATTEntry *translation = translateAccess(pkt);
+    Tick lat = cyclesToTicks(m_request_latency);
+
+    // remote accesses are served by the host spm right away, the network
+    // round trip is estimated from the hop distance
+    if (pkt->spmInfo().isRemote()) {
+        NodeID host_node = translation->destination_node.num;
+        // the host may run in another event queue
+        EventQueue::ScopedMigration migrate(getPMMU(host_node)->eventQueue(),
+                                            inParallelMode && !GOVLock::isHeld());
+        lat += getPMMU(host_node)->spmMasterPort->sendAtomic(pkt);
+        lat += cyclesToTicks(Cycles(2 * getHopDistance(host_node) * m_hop_latency));
+    }
+
+    return lat;
+}
+
+void
+PMMU::recvSPMFunctionalReq(PacketPtr pkt)
+{
+    // same as an atomic access, without side effects on the ATT and spm
+    ATTEntry *translation = my_att->lookup(getRequestASID(pkt),
+                                           spmPageAlign(pkt->req->getVaddr()));
+    if (!translation || !translation->data_valid) {
+        return;
+    }
+
+    pkt_ext_pool.attach(pkt);
+    pkt->spmInfo().setSPMAddress(translation->spm_slot_addr | pkt->getOffset(getPageSizeBytes()));
+    if (translation->destination_node.num == getNodeID()) {
+        pkt->spmInfo().makeLocal();
+    }
+    else {
+        pkt->spmInfo().makeRemote();
+    }
+    EventQueue::ScopedMigration migrate(getPMMU(translation->destination_node.num)->eventQueue(),
+                                        inParallelMode && !GOVLock::isHeld());
+    getPMMU(translation->destination_node.num)->spmMasterPort->sendFunctional(pkt);
+}
+
+PMMU *
+PMMU::getPMMU(NodeID node)
+{
+    assert(node < m_pmmus.size() && m_pmmus[node]);
+    return m_pmmus[node];
+}
+
+PMMU *
+PMMU::getPMMU(ThreadContext *tc)
+{
+    BaseSPM::SPMSlavePort &spm_port = dynamic_cast<BaseSPM::SPMSlavePort&>(
+        tc->getCpuPtr()->getMasterPort("dcache_port", 0).getSlavePort());
+    return dynamic_cast<SPM*>(spm_port.getOwner())->myPMMU;
+}
+
+int
+PMMU::getHopDistance(NodeID node)
+{
+    if (m_hop_distances.empty()) {
+        // one hop to everybody if we don't know the topology
+        m_hop_distances.assign(m_pmmus.size(), 1);
+        m_hop_distances[getNodeID()] = 0;
+
+        const Topology *topology = m_net_ptr ? m_net_ptr->getTopology() : nullptr;
+        if (topology) {
+            Matrix hops = topology->hopDistances();
+            int base = MachineType_base_number(MachineType_PMMU);
+            for (NodeID n = 0; n < m_pmmus.size(); n++) {
+                m_hop_distances[n] = std::max(hops[base + getNodeID()][base + n], 0);
+            }
+        }
+    }
+
+    assert(node < m_hop_distances.size());
+    return m_hop_distances[node];
+}
+
+DrainState
+PMMU::drain()
+{
+    my_stream_engine->drain();
+
+    if (outstanding_gov_pkts == 0) {
+        return DrainState::Drained;
+    }
+
+    DPRINTF(Drain, "Node %d: %d gov packet(s) still in flight\n",
+            getNodeID(), outstanding_gov_pkts);
+    return DrainState::Draining;
+}
+
+void
+PMMU::drainResume()
+{
+    my_stream_engine->drainResume();
+}
+
+void
+PMMU::checkDrain()
+{
+    if (drainState() == DrainState::Draining && outstanding_gov_pkts == 0) {
+        DPRINTF(Drain, "Node %d: drained\n", getNodeID());
+        signalDrainDone();
+    }
+}
+
 ////////////////////
 //
 // SPMSideSlavePort
@@ -1142,10 +1760,19 @@ PMMU::SPMSideSlavePort::recvTimingReq(PacketPtr pkt)
     return my_pmmu->recvSPMTimingReq(pkt);
 }
 
+Tick
+PMMU::SPMSideSlavePort::recvAtomic(PacketPtr pkt)
+{
+    /*
+     * This is called by local spm when the cpu accesses it in atomic mode
+     */
+    return my_pmmu->recvSPMAtomicReq(pkt);
+}
+
 void
 PMMU::SPMSideSlavePort::recvFunctional(PacketPtr pkt)
 {
-    //@TODO:  implement - see rubyport.cc version
+    my_pmmu->recvSPMFunctionalReq(pkt);
 }
 
 ////////////////////
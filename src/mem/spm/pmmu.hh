@@ -4,19 +4,27 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "mem/protocol/Types.hh"
 #include "mem/ruby/slicc_interface/AbstractController.hh"
+#include "mem/spm/SPMPacketExtension.hh"
 #include "mem/spm/spm_class/spm.hh"
 #include "params/PMMU.hh"
 
 class SPMRequestMsg;
 class SPMResponseMsg;
 class ATT;
+class ATTLookasideBuffer;
+class SPMStreamEngine;
+struct ATTEntry;
 class BaseGovernor;
 class GOVRequest;
 class HostInfo;
 class Annotations;
+class ThreadContext;
+class Process;
 
 class PMMU : public AbstractController
 {
@@ -37,8 +45,7 @@ class PMMU : public AbstractController
 
       protected:
 
-        Tick recvAtomic(PacketPtr pkt)
-        { panic("PMMU::SPMSideSlavePort::recvAtomic() not implemented!\n"); }
+        Tick recvAtomic(PacketPtr pkt);
 
         void recvFunctional(PacketPtr pkt);
 
@@ -79,6 +86,11 @@ class PMMU : public AbstractController
     PMMU(const Params *p);
     void init();
     void initNetQueues();
+    void startup() override;
+
+    // the ATT and the ticket counter, governor packets must be drained
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
 
     SPM *my_spm_ptr;
 
@@ -94,6 +106,8 @@ class PMMU : public AbstractController
 
     BaseGovernor *getGovernor() { return my_governor_ptr; }
 
+    SPMStreamEngine *getStreamEngine() { return my_stream_engine; }
+
     // aligns the address to virtual page boundaries
     static Addr spmPageAlign(Addr v_addr)     { return spmPageAlignDown(v_addr); }
     static Addr spmPageAlignDown(Addr v_addr) { return (v_addr & ~(Addr(m_page_size_bytes - 1))); }
@@ -101,11 +115,16 @@ class PMMU : public AbstractController
                                                        ~(Addr(m_page_size_bytes - 1)); }
 
     static int getPageSizeBytes() { return m_page_size_bytes; }
-    int getSPMSizePages() { return my_spm_ptr->getSize()/m_page_size_bytes; }
+    // slots that can be handed out, fewer than the spm has while it
+    // shares its array with a cache
+    int getSPMSizePages() { return my_spm_ptr->freePageIndex.getNumPages(); }
+    int getSPMMaxPages() { return my_spm_ptr->getSize()/m_page_size_bytes; }
 
     NodeID getNodeID() const {return m_machineID.num;};
 
     /* alloc/dealloc/relocation request helper functions */
+    // stops at the first page a full ATT can't take, host_info is
+    // shrunk to the pages before it
     int addATTMappingsVAddress(GOVRequest *gov_request, HostInfo *host_info);
 
     int removeATTMappingsVAddress(GOVRequest *gov_request, HostInfo *host_info);
@@ -120,10 +139,33 @@ class PMMU : public AbstractController
                                     HostInfo *future_host_info,
                                     GOVRequest *gov_request = nullptr);
 
+    // takes the mappings of a range over from another pmmu, the pages stay
+    // where they are; returns the number of leading pages taken over
+    int takeOverATTMappingsVAddress(GOVRequest *gov_request, PMMU *owner_pmmu);
+
+    // maps a range onto the given free slots and fills them with copies of
+    // the pages another pmmu has on chip; returns the number of pages copied
+    int copyATTMappingsVAddress(GOVRequest *gov_request, PMMU *owner_pmmu,
+                                HostInfo *future_host_info);
+
     void setUsedPages(Addr start_p_spm_addr, int num_pages,
                       NodeID owner);
     void setFreePages(Addr start_p_spm_addr, int num_pages);
 
+    /* asynchronous alloc/dealloc requests, completion is polled by the core */
+    uint64_t openTicket();
+    bool isTicketComplete(uint64_t ticket) const;
+
+    // pmmu of the given node, used to reach remote spms in atomic mode
+    static PMMU *getPMMU(NodeID node);
+    // pmmu of the spm in front of the core running tc
+    static PMMU *getPMMU(ThreadContext *tc);
+    static bool hasPMMU(NodeID node) { return node < m_pmmus.size() && m_pmmus[node]; }
+    int getHopDistance(NodeID node);
+
+    DrainState drain() override;
+    void drainResume() override;
+
     void wakeup();
 
   private:
@@ -138,36 +180,86 @@ class PMMU : public AbstractController
     MessageBuffer* m_requestToNetwork_ptr;
 
     static int m_page_size_bytes;
+    static std::vector<PMMU *> m_pmmus;
+
+    // estimated network latency of one hop, for remote atomic accesses
+    Cycles m_hop_latency;
+    std::vector<int> m_hop_distances;
 
     BaseGovernor *my_governor_ptr;
+
+    // spm/governor metadata of the packets this pmmu handles
+    SPMPacketExtensionPool pkt_ext_pool;
     uint32_t pending_gov_reqs;
+    // gov packets sent but not finalized yet, stalling or not
+    uint32_t outstanding_gov_pkts;
+
+    // outstanding gov packets of every ticket still in flight
+    uint64_t next_ticket;
+    std::unordered_map<uint64_t, uint32_t> pending_tickets;
+
+    Stats::Scalar async_gov_reqs;
+    Stats::Scalar async_gov_pkts;
+    Stats::Scalar handed_off_pages;
+    Stats::Scalar copied_pages;
 
   public:
     ATT *my_att;
 
   private:
+    ATTLookasideBuffer *my_att_lookaside;
+
+    // keeps the pages ahead of sequential walks on chip
+    SPMStreamEngine *my_stream_engine;
 
-    void addToGovernor(std::string gov_type);
+
+    void addToGovernor();
 
     bool recvSPMTimingReq(PacketPtr pkt);
     bool recvSPMTimingResp(PacketPtr pkt);
+    Tick recvSPMAtomicReq(PacketPtr pkt);
+    void recvSPMFunctionalReq(PacketPtr pkt);
+
+    void checkDrain();
 
+    // each of these moves a run of contiguous spm slots with a single
+    // request, annotations hold the per-page copies kept in ATT
     void triggerPageAlloc(GOVRequest *gov_request,
                           HostInfo *host_info,
-                          int page_index);
+                          int first_page_index,
+                          const std::vector<Annotations*> &run_annotations);
 
+    // the virtual pages of the run are given one by one, they needn't
+    // follow each other
     void triggerPageDeAlloc(GOVRequest *gov_request,
                             HostInfo *host_info,
-                            int page_index);
+                            const std::vector<Addr> &run_v_page_addrs,
+                            const std::vector<Annotations*> &run_annotations);
 
     void triggerPageRelocation(HostInfo *current_host_info,
                                HostInfo *future_host_info,
-                               int page_index,
-                               Annotations *att_annotation_ptr);
+                               Addr current_spm_addr,
+                               Addr future_spm_addr,
+                               const std::vector<Annotations*> &run_annotations,
+                               bool keep_source = false);
+
+    // attaches a gov packet to the ticket of an asynchronous request
+    void trackAsyncGOVReq(GOVRequest *gov_request, PacketPtr gov_pkt);
+
+    // serves a gov packet on the spot when the system is in atomic mode
+    void atomicGOVReq(PacketPtr gov_pkt, const MachineID &host_node);
 
     void continuePageRelocationRequest(PacketPtr relocation_pkt);
     void finalizeLocalGOVReq(PacketPtr gov_pkt);
 
+    // address space a CPU-side access belongs to, used to tag ATT lookups
+    uint64_t getRequestASID(PacketPtr pkt) const;
+    // the process of an address space, found among the thread contexts
+    Process *getASIDProcess(uint64_t asid) const;
+
+    // looks up the ATT and marks where the access has to go
+    ATTEntry *translateAccess(PacketPtr pkt);
+
     // packet to message routines
     bool generateAccessReqMsg(PacketPtr pkt);
     bool generateAccessRespMsg(PacketPtr pkt);
@@ -179,6 +271,14 @@ class PMMU : public AbstractController
     bool processLocalResponseMsg();
     bool processLocalRequestMsg(bool *sending_mem_reqs_allowed);
 
+    // shared pages mapped by other nodes follow the slot they point at,
+    // and are dropped along with it
+    void dropSharedAliases(uint64_t asid, Addr v_page_addr,
+                           MachineID node, Addr spm_slot_addr);
+    void moveSharedAliases(uint64_t asid, Addr v_page_addr,
+                           MachineID node, Addr spm_slot_addr,
+                           MachineID new_node, Addr new_spm_slot_addr);
+
     // relocation handling
     bool sendRelocationDone(PacketPtr pkt);
     void fireupPendingAllocs(PacketPtr pkt);
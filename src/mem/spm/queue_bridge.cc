@@ -0,0 +1,169 @@
+#include "mem/spm/queue_bridge.hh"
+
+#include <algorithm>
+
+#include "base/trace.hh"
+#include "debug/QueueBridge.hh"
+#include "mem/spm/governor/GOVLock.hh"
+
+QueueBridge *
+QueueBridgeParams::create()
+{
+    return new QueueBridge(this);
+}
+
+QueueBridge::QueueBridge(const Params *p)
+    : MemObject(p),
+      slavePort(p->name + ".slave", *this),
+      masterPort(p->name + ".master", *this),
+      masterQueue(getEventQueue(p->master_eventq_index)),
+      delay(p->delay)
+{
+}
+
+BaseMasterPort &
+QueueBridge::getMasterPort(const std::string &if_name, PortID idx)
+{
+    if (if_name == "master")
+        return masterPort;
+    else
+        return MemObject::getMasterPort(if_name, idx);
+}
+
+BaseSlavePort &
+QueueBridge::getSlavePort(const std::string &if_name, PortID idx)
+{
+    if (if_name == "slave")
+        return slavePort;
+    else
+        return MemObject::getSlavePort(if_name, idx);
+}
+
+void
+QueueBridge::init()
+{
+    if (!slavePort.isConnected() || !masterPort.isConnected())
+        fatal("Both ports of a queue bridge must be connected.\n");
+
+    // a packet must not reach a queue before the queues next synchronize
+    if (masterQueue != eventQueue() && simQuantum == 0)
+        fatal("%s: crossing event queues needs a simulation quantum\n",
+              name());
+
+    slavePort.sendRangeChange();
+}
+
+Tick
+QueueBridge::crossingTime() const
+{
+    return curTick() + std::max(delay, simQuantum);
+}
+
+void
+QueueBridge::cross(EventQueue *eq, PacketPtr pkt, bool is_request)
+{
+    // scheduled from another queue, the event is only inserted when the
+    // queues synchronize
+    eq->schedule(new EventFunctionWrapper([this, pkt, is_request]{
+                     if (is_request) {
+                         reqQueue.push_back(pkt);
+                         if (reqQueue.size() == 1)
+                             trySendReq();
+                     }
+                     else {
+                         respQueue.push_back(pkt);
+                         if (respQueue.size() == 1)
+                             trySendResp();
+                     }
+                 }, name(), true),
+                 crossingTime());
+}
+
+void
+QueueBridge::trySendReq()
+{
+    while (!reqQueue.empty()) {
+        PacketPtr pkt = reqQueue.front();
+        if (!masterPort.sendTimingReq(pkt)) {
+            // wait for the retry
+            return;
+        }
+        DPRINTF(QueueBridge, "Sent request %s addr %#x\n",
+                pkt->cmdString(), pkt->getAddr());
+        reqQueue.pop_front();
+    }
+}
+
+void
+QueueBridge::trySendResp()
+{
+    while (!respQueue.empty()) {
+        PacketPtr pkt = respQueue.front();
+        if (!slavePort.sendTimingResp(pkt)) {
+            return;
+        }
+        DPRINTF(QueueBridge, "Sent response %s addr %#x\n",
+                pkt->cmdString(), pkt->getAddr());
+        respQueue.pop_front();
+    }
+}
+
+bool
+QueueBridge::BridgeSlavePort::recvTimingReq(PacketPtr pkt)
+{
+    panic_if(pkt->cacheResponding(), "Should not see packets where cache "
+             "is responding");
+
+    // the bridge buffers without bounds, the memory side pushes back
+    // on its own queue only
+    bridge.cross(bridge.masterQueue, pkt, true);
+    return true;
+}
+
+void
+QueueBridge::BridgeSlavePort::recvRespRetry()
+{
+    bridge.trySendResp();
+}
+
+Tick
+QueueBridge::BridgeSlavePort::recvAtomic(PacketPtr pkt)
+{
+    // a governor holds all queues already, e.g. when copying a page
+    EventQueue::ScopedMigration migrate(bridge.masterQueue,
+                                        inParallelMode && !GOVLock::isHeld());
+    return bridge.masterPort.sendAtomic(pkt);
+}
+
+void
+QueueBridge::BridgeSlavePort::recvFunctional(PacketPtr pkt)
+{
+    EventQueue::ScopedMigration migrate(bridge.masterQueue,
+                                        inParallelMode && !GOVLock::isHeld());
+    bridge.masterPort.sendFunctional(pkt);
+}
+
+AddrRangeList
+QueueBridge::BridgeSlavePort::getAddrRanges() const
+{
+    return bridge.masterPort.getAddrRanges();
+}
+
+bool
+QueueBridge::BridgeMasterPort::recvTimingResp(PacketPtr pkt)
+{
+    bridge.cross(bridge.eventQueue(), pkt, false);
+    return true;
+}
+
+void
+QueueBridge::BridgeMasterPort::recvReqRetry()
+{
+    bridge.trySendReq();
+}
+
+void
+QueueBridge::BridgeMasterPort::recvRangeChange()
+{
+    bridge.slavePort.sendRangeChange();
+}
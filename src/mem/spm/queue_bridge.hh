@@ -0,0 +1,87 @@
+/* A bridge between the event queue of a node of an spm mesh and the one of
+ * the memory it shares with the other nodes. With the queues run by their
+ * own threads, a timing packet can only be handed over to another queue at
+ * the next synchronization of the queues, so requests and responses reach
+ * the other side one simulation quantum later at the earliest. Atomic and
+ * functional accesses are made in the other queue right away. Snoops don't
+ * cross the bridge, and neither does anything else than memory accesses
+ * coming from the node.
+ * */
+
+#ifndef __SPM_QUEUE_BRIDGE_HH__
+#define __SPM_QUEUE_BRIDGE_HH__
+
+#include <deque>
+
+#include "mem/mem_object.hh"
+#include "params/QueueBridge.hh"
+
+class QueueBridge : public MemObject
+{
+  public:
+    typedef QueueBridgeParams Params;
+    QueueBridge(const Params *p);
+
+    virtual BaseMasterPort &getMasterPort(const std::string &if_name,
+                                          PortID idx = InvalidPortID);
+    virtual BaseSlavePort &getSlavePort(const std::string &if_name,
+                                        PortID idx = InvalidPortID);
+
+    void init() override;
+
+  private:
+    class BridgeSlavePort : public SlavePort
+    {
+      public:
+        BridgeSlavePort(const std::string &_name, QueueBridge &_bridge)
+            : SlavePort(_name, &_bridge), bridge(_bridge) {}
+
+      protected:
+        bool recvTimingReq(PacketPtr pkt) override;
+        void recvRespRetry() override;
+        Tick recvAtomic(PacketPtr pkt) override;
+        void recvFunctional(PacketPtr pkt) override;
+        AddrRangeList getAddrRanges() const override;
+
+      private:
+        QueueBridge &bridge;
+    };
+
+    class BridgeMasterPort : public MasterPort
+    {
+      public:
+        BridgeMasterPort(const std::string &_name, QueueBridge &_bridge)
+            : MasterPort(_name, &_bridge), bridge(_bridge) {}
+
+      protected:
+        bool recvTimingResp(PacketPtr pkt) override;
+        void recvReqRetry() override;
+        void recvRangeChange() override;
+
+      private:
+        QueueBridge &bridge;
+    };
+
+    BridgeSlavePort slavePort;
+    BridgeMasterPort masterPort;
+
+    // queue of the memory side, the node side is in the queue of the bridge
+    EventQueue *masterQueue;
+    const Tick delay;
+
+    // packets waiting for their side to take them, each only touched from
+    // the queue of its side
+    std::deque<PacketPtr> reqQueue;
+    std::deque<PacketPtr> respQueue;
+
+    // the time a packet sent now reaches the other queue
+    Tick crossingTime() const;
+
+    // hands the packet over to the given queue, which sends it on
+    void cross(EventQueue *eq, PacketPtr pkt, bool is_request);
+
+    void trySendReq();
+    void trySendResp();
+};
+
+#endif // __SPM_QUEUE_BRIDGE_HH__
@@ -86,3 +86,32 @@ class SPM(BaseSPM):
     read_ber = Param.Float(-1, "read ber for approximate spm reads")
     write_ber = Param.Float(-1, "write ber for approximate spm writes")
     ber_energy_file = Param.String("", "file that contains ber-energy information")
+    fault_seed = Param.UInt64(1,
+        "Seed of the fault injector, combined with the SPM name")
+    transfer_burst_size = Param.Unsigned(64,
+        "Size of the memory requests used to move allocated pages")
+    transfer_max_outstanding = Param.Unsigned(8,
+        "Max number of page transfer requests in flight")
+    num_banks = Param.Unsigned(0,
+        "Number of banks of the array, 0 for unlimited bandwidth")
+    bank_interleaving = Param.Unsigned(64,
+        "Bytes of consecutive spm addresses mapped to the same bank")
+    ports_per_bank = Param.Unsigned(1,
+        "Number of accesses a bank serves at the same time")
+    bank_busy_cycles = Param.Cycles(1,
+        "Cycles a port is held per interleaving unit of an access")
+    wakeup_latency = Param.Cycles(2,
+        "Cycles to wake a drowsy or gated slot up before accessing it")
+    drowsy_leakage_factor = Param.Float(0.25,
+        "Fraction of its leakage a drowsy slot keeps")
+    huge_pages = Param.Bool(False,
+        "Back the slots with huge pages of the host when it has them")
+    zero_copy_transfers = Param.Bool(True,
+        "Move the contents of pages relocated within the spm and of written "
+        "back pages on the host without copying them, the timing is left "
+        "as modeled")
+    reconfigurable = Param.Bool(False,
+        "Carve the slots from the ways of the cache on the mem side, size "
+        "is then the most the spm can take")
+    cache_ways = Param.Unsigned(0,
+        "Cache ways a reconfigurable spm starts with")
@@ -0,0 +1,105 @@
+#include "mem/spm/spm_class/SPMArena.hh"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdio>
+
+#include "base/intmath.hh"
+#include "base/logging.hh"
+
+// size of the huge pages the arena is rounded up to, the common x86 and
+// arm one
+static const size_t hugePageSize = 2 * 1024 * 1024;
+
+SPMArena::SPMArena(unsigned num_pages, unsigned num_spares,
+                   unsigned page_size, bool huge_pages)
+    : mappingBase(nullptr),
+      base(nullptr),
+      mappedSize(0),
+      numPages(num_pages),
+      pageSize(page_size),
+      hugePages(huge_pages)
+{
+    assert(isPowerOf2(page_size));
+
+    // mmap aligns to the host page, larger spm pages need some slack
+    size_t host_page_size = sysconf(_SC_PAGESIZE);
+    size_t slack = page_size > host_page_size ? page_size : 0;
+    mappedSize = (size_t)(num_pages + num_spares) * page_size + slack;
+    if (hugePages)
+        mappedSize = roundUp(mappedSize, hugePageSize);
+
+    int map_flags = MAP_ANON | MAP_PRIVATE;
+    void *mapping = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (hugePages)
+        mapping = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE,
+                       map_flags | MAP_HUGETLB, -1, 0);
+#endif
+    if (mapping == MAP_FAILED) {
+        mapping = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE,
+                       map_flags, -1, 0);
+        if (mapping == MAP_FAILED) {
+            perror("mmap");
+            fatal("Could not mmap %d bytes for %d spm pages!\n",
+                  mappedSize, num_pages + num_spares);
+        }
+
+        // no huge pages reserved, transparent ones may still do
+        if (hugePages) {
+#ifdef MADV_HUGEPAGE
+            if (madvise(mapping, mappedSize, MADV_HUGEPAGE) != 0)
+                warn("Can't back an spm with huge pages, using normal "
+                     "ones\n");
+#else
+            warn("Huge pages aren't supported on this host, using normal "
+                 "ones for the spms\n");
+#endif
+        }
+    }
+
+    mappingBase = (uint8_t *)mapping;
+    base = (uint8_t *)roundUp((Addr)mappingBase, (Addr)page_size);
+
+    for (unsigned i = 0; i < num_spares; i++) {
+        spares.push_back(base + (size_t)(num_pages + i) * page_size);
+    }
+}
+
+SPMArena::~SPMArena()
+{
+    munmap(mappingBase, mappedSize);
+}
+
+uint8_t *
+SPMArena::getPage(unsigned page_index) const
+{
+    assert(page_index < numPages);
+    return base + (size_t)page_index * pageSize;
+}
+
+bool
+SPMArena::contains(const uint8_t *page) const
+{
+    return page >= base && page < mappingBase + mappedSize;
+}
+
+uint8_t *
+SPMArena::takeSpare()
+{
+    if (spares.empty())
+        return nullptr;
+
+    uint8_t *page = spares.back();
+    spares.pop_back();
+    return page;
+}
+
+void
+SPMArena::returnSpare(uint8_t *page)
+{
+    assert(contains(page));
+    spares.push_back(page);
+}
@@ -0,0 +1,52 @@
+#ifndef __MEM_SPM_ARENA_HH__
+#define __MEM_SPM_ARENA_HH__
+
+#include <cstddef>
+#include <vector>
+
+#include "base/types.hh"
+
+/**
+ * Backing storage of the slots of one SPM: a single block of memory
+ * aligned to the page size, optionally backed by host huge pages, that
+ * the SPMPages of the slots only point into.
+ *
+ * Moving a page to another slot of the same spm, or writing it back,
+ * doesn't copy its contents: the page leaves its slot for one of the
+ * spare pages mapped after the slots, and takes the place of the page of
+ * the slot it is written to, which becomes a spare in turn. Slots only
+ * ever point into the arena of their own spm.
+ */
+class SPMArena
+{
+  public:
+    SPMArena(unsigned num_pages, unsigned num_spares, unsigned page_size,
+             bool huge_pages);
+    ~SPMArena();
+
+    uint8_t *getPage(unsigned page_index) const;
+
+    unsigned getNumPages() const { return numPages; }
+    bool usesHugePages() const { return hugePages; }
+
+    /** A page of the arena nobody points to, nullptr if there is none
+     *  left. Its contents are undefined. */
+    uint8_t *takeSpare();
+    /** Hands back a page of the arena no slot points to anymore. */
+    void returnSpare(uint8_t *page);
+    unsigned getNumSpares() const { return spares.size(); }
+
+    bool contains(const uint8_t *page) const;
+
+  private:
+    uint8_t *mappingBase;
+    uint8_t *base;  // first page, aligned to the page size
+    size_t mappedSize;
+    unsigned numPages;   // slots, the spares come after them
+    unsigned pageSize;
+    bool hugePages;
+
+    std::vector<uint8_t *> spares;
+};
+
+#endif // __MEM_SPM_ARENA_HH__
@@ -0,0 +1,105 @@
+#include "mem/spm/spm_class/SPMFaultInjector.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <sstream>
+
+SPMFaultInjector::SPMFaultInjector()
+{
+    readStream.ber = 0;
+    readStream.skip = 0;
+    writeStream.ber = 0;
+    writeStream.skip = 0;
+}
+
+void
+SPMFaultInjector::seed(uint64_t seed, const std::string &name)
+{
+    // every spm of a system gets its own sequence out of the same seed
+    uint64_t name_hash = std::hash<std::string>()(name);
+    std::seed_seq ss{uint32_t(seed), uint32_t(seed >> 32),
+                     uint32_t(name_hash), uint32_t(name_hash >> 32)};
+    rng.seed(ss);
+
+    readStream.ber = 0;
+    writeStream.ber = 0;
+}
+
+unsigned
+SPMFaultInjector::inject(Stream &stream, uint8_t *data, int len, double ber)
+{
+    // below double precision a bit never flips
+    if (ber <= 0 || 1.0 - ber == 1.0) {
+        return 0;
+    }
+    ber = std::min(ber, 1.0 - std::numeric_limits<double>::epsilon());
+
+    if (ber != stream.ber) {
+        // skips are memoryless, dropping the pending one is fine
+        stream.ber = ber;
+        stream.distance = std::geometric_distribution<uint64_t>(ber);
+        stream.skip = stream.distance(rng);
+    }
+
+    uint64_t num_bits = uint64_t(len) * 8;
+    if (stream.skip >= num_bits) {
+        stream.skip -= num_bits;
+        return 0;
+    }
+
+    uint64_t bit = stream.skip;
+    unsigned num_flips = 0;
+    while (bit < num_bits) {
+        // bit 0 is the msb of the first byte
+        data[bit / 8] ^= uint8_t(0x80 >> (bit % 8));
+        num_flips++;
+        bit += 1 + stream.distance(rng);
+    }
+    stream.skip = bit - num_bits;
+
+    return num_flips;
+}
+
+std::string
+SPMFaultInjector::getState() const
+{
+    std::ostringstream state;
+    state << rng;
+    saveStream(state, readStream);
+    saveStream(state, writeStream);
+    return state.str();
+}
+
+bool
+SPMFaultInjector::setState(const std::string &state)
+{
+    std::istringstream is(state);
+    is >> rng;
+    restoreStream(is, readStream);
+    restoreStream(is, writeStream);
+    return !is.fail();
+}
+
+void
+SPMFaultInjector::saveStream(std::ostream &os, const Stream &stream) const
+{
+    // the exact bits of the ber, a rounded one would redraw the skip
+    uint64_t ber_bits;
+    memcpy(&ber_bits, &stream.ber, sizeof(ber_bits));
+
+    os << " " << ber_bits << " " << stream.skip;
+}
+
+void
+SPMFaultInjector::restoreStream(std::istream &is, Stream &stream)
+{
+    uint64_t ber_bits;
+    is >> ber_bits >> stream.skip;
+    memcpy(&stream.ber, &ber_bits, sizeof(ber_bits));
+
+    if (stream.ber > 0) {
+        stream.distance = std::geometric_distribution<uint64_t>(stream.ber);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef __MEM_SPM_FAULT_INJECTOR_HH__
+#define __MEM_SPM_FAULT_INJECTOR_HH__
+
+#include <random>
+#include <string>
+
+#include "base/types.hh"
+
+/**
+ * Bit-flip injector of one SPM. Instead of a random draw per bit, the
+ * number of error-free bits before the next flip is drawn from a
+ * geometric distribution, so accesses that don't flip anything cost a
+ * subtraction. The pending skip carries over from one access to the next
+ * and is only redrawn when the BER of the access changes. Reads and
+ * writes use separate streams, seeded from the SPM so runs are
+ * reproducible. The SPM counts the flips and checkpoints the state.
+ */
+class SPMFaultInjector
+{
+  public:
+    SPMFaultInjector();
+
+    void seed(uint64_t seed, const std::string &name);
+
+    // flip bits of data[0, len) at the given ber, returns the number of
+    // bits flipped
+    unsigned injectReadFaults(uint8_t *data, int len, double ber)
+    { return inject(readStream, data, len, ber); }
+    unsigned injectWriteFaults(uint8_t *data, int len, double ber)
+    { return inject(writeStream, data, len, ber); }
+
+    // the generator and the pending skips, so restored runs flip the same
+    // bits; setState is false if the state can't be parsed
+    std::string getState() const;
+    bool setState(const std::string &state);
+
+  private:
+    struct Stream
+    {
+        double ber;
+        // error-free bits left before the next flip
+        uint64_t skip;
+        std::geometric_distribution<uint64_t> distance;
+    };
+
+    std::mt19937_64 rng;
+    Stream readStream;
+    Stream writeStream;
+
+    unsigned inject(Stream &stream, uint8_t *data, int len, double ber);
+
+    void saveStream(std::ostream &os, const Stream &stream) const;
+    void restoreStream(std::istream &is, Stream &stream);
+};
+
+#endif // __MEM_SPM_FAULT_INJECTOR_HH__
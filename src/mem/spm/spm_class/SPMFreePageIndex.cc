@@ -0,0 +1,173 @@
+#include "mem/spm/spm_class/SPMFreePageIndex.hh"
+
+#include <algorithm>
+#include <cassert>
+
+#include "base/bitfield.hh"
+
+SPMFreePageIndex::SPMFreePageIndex()
+    : maxPages(0),
+      numPages(0),
+      numFree(0)
+{
+}
+
+void
+SPMFreePageIndex::init(unsigned num_pages)
+{
+    maxPages = num_pages;
+    numPages = num_pages;
+    numFree = 0;
+    words.assign((num_pages + 63) / 64, 0);
+    setFree(0, num_pages);
+}
+
+void
+SPMFreePageIndex::setNumPages(unsigned num_pages)
+{
+    assert(num_pages <= maxPages);
+
+    numPages = num_pages;
+    numFree = 0;
+    for (unsigned word_index = 0; word_index < words.size(); word_index++)
+        numFree += popCount(words[word_index] & activeBits(word_index));
+}
+
+uint64_t
+SPMFreePageIndex::activeBits(unsigned word_index) const
+{
+    unsigned first = word_index * 64;
+    if (first + 64 <= numPages)
+        return ~uint64_t(0);
+    return first < numPages ? mask(numPages - first) : 0;
+}
+
+void
+SPMFreePageIndex::setFree(unsigned first_page_index, unsigned num_pages)
+{
+    assert(first_page_index + num_pages <= maxPages);
+
+    unsigned page_index = first_page_index;
+    unsigned end = first_page_index + num_pages;
+    while (page_index < end) {
+        unsigned bit = page_index % 64;
+        unsigned len = std::min(64 - bit, end - page_index);
+        uint64_t run_mask = mask(len) << bit;
+        uint64_t &word = words[page_index / 64];
+
+        numFree += popCount(run_mask & ~word & activeBits(page_index / 64));
+        word |= run_mask;
+        page_index += len;
+    }
+}
+
+void
+SPMFreePageIndex::setUsed(unsigned first_page_index, unsigned num_pages)
+{
+    assert(first_page_index + num_pages <= maxPages);
+
+    unsigned page_index = first_page_index;
+    unsigned end = first_page_index + num_pages;
+    while (page_index < end) {
+        unsigned bit = page_index % 64;
+        unsigned len = std::min(64 - bit, end - page_index);
+        uint64_t run_mask = mask(len) << bit;
+        uint64_t &word = words[page_index / 64];
+
+        numFree -= popCount(run_mask & word & activeBits(page_index / 64));
+        word &= ~run_mask;
+        page_index += len;
+    }
+}
+
+bool
+SPMFreePageIndex::isFree(unsigned page_index) const
+{
+    assert(page_index < maxPages);
+    return page_index < numPages &&
+           bits(words[page_index / 64], page_index % 64);
+}
+
+unsigned
+SPMFreePageIndex::nextFree(unsigned page_index) const
+{
+    if (page_index >= numPages)
+        return numPages;
+
+    unsigned word_index = page_index / 64;
+    uint64_t word = words[word_index] & ~mask(page_index % 64) &
+                    activeBits(word_index);
+    while (!word) {
+        if (++word_index == words.size())
+            return numPages;
+        word = words[word_index] & activeBits(word_index);
+    }
+    return word_index * 64 + findLsbSet(word);
+}
+
+unsigned
+SPMFreePageIndex::nextUsed(unsigned page_index) const
+{
+    if (page_index >= numPages)
+        return numPages;
+
+    unsigned word_index = page_index / 64;
+    uint64_t word = ~words[word_index] & ~mask(page_index % 64);
+    while (!word) {
+        if (++word_index == words.size())
+            return numPages;
+        word = ~words[word_index];
+    }
+    // slots past numPages count as used, clamp them
+    return std::min(numPages, unsigned(word_index * 64 + findLsbSet(word)));
+}
+
+bool
+SPMFreePageIndex::findFreeRun(unsigned num_needed, unsigned start_page_index,
+                              unsigned &run_start, unsigned &run_length) const
+{
+    run_start = start_page_index;
+    run_length = 0;
+
+    if (num_needed == 0)
+        return true;
+    if (numFree == 0)
+        return false;
+
+    unsigned page_index = nextFree(start_page_index);
+    while (page_index < numPages) {
+        unsigned end = nextUsed(page_index);
+        if (end - page_index > run_length) {
+            run_start = page_index;
+            run_length = end - page_index;
+            if (run_length >= num_needed) {
+                run_length = num_needed;
+                return true;
+            }
+        }
+        page_index = nextFree(end);
+    }
+    return false;
+}
+
+unsigned
+SPMFreePageIndex::getLargestFreeRun() const
+{
+    unsigned largest = 0;
+    unsigned page_index = nextFree(0);
+    while (page_index < numPages) {
+        unsigned end = nextUsed(page_index);
+        largest = std::max(largest, end - page_index);
+        page_index = nextFree(end);
+    }
+    return largest;
+}
+
+double
+SPMFreePageIndex::getFragmentation() const
+{
+    if (numFree == 0)
+        return 0;
+
+    return 1.0 - double(getLargestFreeRun()) / numFree;
+}
@@ -0,0 +1,62 @@
+#ifndef __MEM_SPM_FREE_PAGE_INDEX_HH__
+#define __MEM_SPM_FREE_PAGE_INDEX_HH__
+
+#include <vector>
+
+#include "base/types.hh"
+
+/**
+ * Free-space index of one SPM: a bitmap with one bit per slot (set when
+ * the slot is free). Runs of free slots are found a word at a time, so
+ * governors no longer walk the slots one by one on every allocation.
+ */
+class SPMFreePageIndex
+{
+  public:
+    SPMFreePageIndex();
+
+    /** Sizes the index, all slots start out free. */
+    void init(unsigned num_pages);
+
+    /**
+     * Only the first num_pages slots can be handed out, e.g. when the
+     * spm shares its array with a cache. The slots past them keep their
+     * state but are never reported free.
+     */
+    void setNumPages(unsigned num_pages);
+
+    void setFree(unsigned first_page_index, unsigned num_pages);
+    void setUsed(unsigned first_page_index, unsigned num_pages);
+
+    bool isFree(unsigned page_index) const;
+    unsigned getNumPages() const { return numPages; }
+    unsigned getNumFreePages() const { return numFree; }
+
+    /**
+     * First-fit search for num_needed free slots, starting at
+     * start_page_index. On success the run is trimmed to num_needed;
+     * otherwise the (first) largest free run is returned.
+     */
+    bool findFreeRun(unsigned num_needed, unsigned start_page_index,
+                     unsigned &run_start, unsigned &run_length) const;
+
+    unsigned getLargestFreeRun() const;
+
+    // 0 when all free slots are contiguous, close to 1 when they are scattered
+    double getFragmentation() const;
+
+  private:
+    std::vector<uint64_t> words;
+    unsigned maxPages;
+    unsigned numPages;
+    unsigned numFree;
+
+    // bits of the given word that are below numPages
+    uint64_t activeBits(unsigned word_index) const;
+
+    // first free (resp. used) slot at or after page_index, numPages if none
+    unsigned nextFree(unsigned page_index) const;
+    unsigned nextUsed(unsigned page_index) const;
+};
+
+#endif // __MEM_SPM_FREE_PAGE_INDEX_HH__
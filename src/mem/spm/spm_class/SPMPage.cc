@@ -1,7 +1,8 @@
 #include "mem/spm/spm_class/SPMPage.hh"
+#include "mem/spm/att.hh"
 #include "mem/spm/pmmu.hh"
 #include "mem/spm/governor/GOVRequest.hh"
-#include <random>
+#include "mem/spm/spm_class/SPMFaultInjector.hh"
 #include <iostream>
 
 void
@@ -10,14 +11,6 @@ SPMPage::obtainPageSize()
     pageSize = PMMU::getPageSizeBytes();
 }
 
-void
-SPMPage::alloc()
-{
-    m_data = new uint8_t[pageSize];
-    m_alloc = true;
-    clear();
-}
-
 void
 SPMPage::clear()
 {
@@ -27,6 +20,8 @@ SPMPage::clear()
 bool
 SPMPage::equal(const SPMPage& obj) const
 {
+    if (!m_data || !obj.m_data)
+        return m_data == obj.m_data;
     return !memcmp(m_data, obj.m_data, pageSize);
 }
 
@@ -35,7 +30,7 @@ SPMPage::print(std::ostream& out) const
 {
     using namespace std;
 
-    int size = pageSize;
+    int size = m_data ? pageSize : 0;
     out << "[ ";
     for (int i = 0; i < size; i++) {
         out << setw(2) << setfill('0') << hex << "0x" << (int)m_data[i] << " ";
@@ -58,7 +53,7 @@ SPMPage::setData(uint8_t *data, int offset, int len)
     memcpy(&m_data[offset], data, len);
 }
 
-void
+unsigned
 SPMPage::performRead(PacketPtr pkt)
 {
     assert(isValid());
@@ -69,13 +64,18 @@ SPMPage::performRead(PacketPtr pkt)
 
     // this injects fault into the data after it is from SPM
     // but not the data stored in the SPM itself
-    if (annotations->approximation != CRITICAL && getReadBER() != 0 && !pkt->govInfo.isGOVReq()) {
-        if (injectFault(pkt->getPtr<uint8_t>(), pkt->getSize(), getReadBER())) {
+    unsigned num_flips = 0;
+    if (annotations->approximation != CRITICAL && getReadBER() != 0 && !pkt->govInfo().isGOVReq()) {
+        num_flips = faultInjector->injectReadFaults(pkt->getPtr<uint8_t>(), pkt->getSize(),
+                                                    getReadBER());
+        if (num_flips) {
+            faultCount++;
         }
     }
+    return num_flips;
 }
 
-void
+unsigned
 SPMPage::performWrite(PacketPtr pkt)
 {
     assert(annotations);
@@ -84,18 +84,25 @@ SPMPage::performWrite(PacketPtr pkt)
     pkt->writeDataToBlock(m_data, pageSize);
 
     // this injects fault into data stored in the SPM
-    if (annotations->approximation != CRITICAL && getWriteBER() != 0 && !pkt->govInfo.isGOVReq()) {
-        if (injectFault(m_data + pkt->getOffset(pageSize), pkt->getSize(), getWriteBER())) {
+    unsigned num_flips = 0;
+    if (annotations->approximation != CRITICAL && getWriteBER() != 0 && !pkt->govInfo().isGOVReq()) {
+        num_flips = faultInjector->injectWriteFaults(m_data + pkt->getOffset(pageSize),
+                                                     pkt->getSize(), getWriteBER());
+        if (num_flips) {
             status |= PageFaulty;
+            faultCount++;
         }
     }
+    return num_flips;
 }
 
 SPMPage &
 SPMPage::operator=(const SPMPage & obj)
 {
-//	assert (obj);
-    assert (obj.m_data);
+    // the pages of messages carry no data
+    if (!obj.m_data)
+        return *this;
+    assert (m_data);
     memcpy(m_data, obj.m_data, pageSize);
     return *this;
 }
@@ -202,6 +209,12 @@ SPMPage::getWriteEnergy()
     return berEnergyData[operatingPoint].write_access_energy;
 }
 
+double
+SPMPage::getLeakagePower()
+{
+    return berEnergyData[operatingPoint].leakage_power;
+}
+
 void
 SPMPage::overrideActiveBERPoint(double read_ber, double write_ber)
 {
@@ -225,32 +238,10 @@ SPMPage::getWriteBER()
 }
 
 
-bool
-SPMPage::injectFault(uint8_t *data, int len, double ber)
-{
-    std::mt19937_64 rng;
-    //std::default_random_engine generator;
-    // initialize the random number generator with time-dependent seed
-    uint64_t timeSeed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-    std::seed_seq ss{uint32_t(timeSeed & 0xffffffff), uint32_t(timeSeed>>32)};
-    rng.seed(ss);
-    std::uniform_real_distribution<double> distribution(0.0,1.0);
-
-    bool fault_injected = false;
-    for (int byte = 0; byte < len; byte++) {
-        uint8_t bit_mask = 0x80;
-        for (int bit = 0; bit < 8; bit++) {
-            double random_probability = distribution(rng);
-            if(random_probability < ber) {
-                uint8_t fault_mask = bit_mask >> bit;
-                if (fault_mask != 0) {
-                    data[byte] = data[byte] ^ fault_mask;
-                    fault_injected = true;
-                }
-            }
-        }
-    }
-    return fault_injected;
+void
+SPMPage::setFaultInjector(SPMFaultInjector *_fault_injector)
+{
+    faultInjector = _fault_injector;
 }
 
 void
@@ -279,6 +270,73 @@ SPMPage::getAnnotations()
     return annotations;
 }
 
+void
+SPMPage::serialize(CheckpointOut &cp) const
+{
+    int occupancy = this->occupancy;
+    int power_state = powerState;
+    uint64_t write_latency = writeLatency;
+    uint64_t read_latency = readLatency;
+
+    SERIALIZE_SCALAR(occupancy);
+    SERIALIZE_SCALAR(status);
+    SERIALIZE_SCALAR(operatingPoint);
+    SERIALIZE_SCALAR(power_state);
+    SERIALIZE_SCALAR(ownerNode);
+    SERIALIZE_SCALAR(write_latency);
+    SERIALIZE_SCALAR(read_latency);
+    SERIALIZE_SCALAR(readRefCount);
+    SERIALIZE_SCALAR(writeRefCount);
+    SERIALIZE_SCALAR(faultCount);
+    SERIALIZE_SCALAR(lastTickAccessed);
+    SERIALIZE_SCALAR(tickInserted);
+
+    paramOut(cp, "has_annotations", annotations != nullptr);
+    if (annotations) {
+        ScopedCheckpointSection sec(cp, "annotations");
+        serializeAnnotations(cp, annotations);
+    }
+}
+
+void
+SPMPage::unserialize(CheckpointIn &cp)
+{
+    int occupancy;
+    int power_state = PAGE_ON;
+    uint64_t write_latency;
+    uint64_t read_latency;
+
+    UNSERIALIZE_SCALAR(occupancy);
+    UNSERIALIZE_SCALAR(status);
+    UNSERIALIZE_SCALAR(operatingPoint);
+    UNSERIALIZE_OPT_SCALAR(power_state);
+    UNSERIALIZE_SCALAR(ownerNode);
+    UNSERIALIZE_SCALAR(write_latency);
+    UNSERIALIZE_SCALAR(read_latency);
+    UNSERIALIZE_SCALAR(readRefCount);
+    UNSERIALIZE_SCALAR(writeRefCount);
+    faultCount = 0;
+    UNSERIALIZE_OPT_SCALAR(faultCount);
+    UNSERIALIZE_SCALAR(lastTickAccessed);
+    UNSERIALIZE_SCALAR(tickInserted);
+
+    // the operating points come from the ber file of the configuration
+    if (operatingPoint < 0 || operatingPoint >= berEnergyData.size())
+        fatal("Checkpointed SPM page uses operating point %d, but only %d "
+              "are configured\n", operatingPoint, berEnergyData.size());
+
+    setOccupancy(static_cast<SPMSlotOccupancyStatus>(occupancy));
+    setPowerState(static_cast<SPMPagePowerState>(power_state));
+    setSpeed(Cycles(write_latency), Cycles(read_latency));
+
+    bool has_annotations;
+    paramIn(cp, "has_annotations", has_annotations);
+    if (has_annotations) {
+        ScopedCheckpointSection sec(cp, "annotations");
+        annotations = unserializeAnnotations(cp);
+    }
+}
+
 void
 SPMPage::resetStatsForNewlyAddedPage()
 {
@@ -287,6 +345,7 @@ SPMPage::resetStatsForNewlyAddedPage()
     tickInserted = curTick();
     readRefCount = 0;
     writeRefCount = 0;
+    faultCount = 0;
     lastTickAccessed = 0;
 }
 
@@ -321,6 +380,12 @@ SPMPage::getLastTickAccessed()
     return lastTickAccessed;
 }
 
+Tick
+SPMPage::getTickInserted()
+{
+    return tickInserted;
+}
+
 float
 SPMPage::pageUtlization()
 {
@@ -4,6 +4,7 @@
 #include "base/types.hh"
 #include "mem/packet.hh"
 #include "mem/ruby/common/TypeDefines.hh"
+#include "sim/serialize.hh"
 
 #include <cassert>
 #include <fstream>
@@ -12,6 +13,7 @@
 #include <inttypes.h>
 
 class Annotations;
+class SPMFaultInjector;
 
 //TODO: Unused for now -- just placeholder
 enum SPMPageStatusBits : unsigned {
@@ -39,6 +41,14 @@ enum SPMSlotOccupancyStatus {
     NUM_SLOT_OCCUPANCY
 };
 
+// power state of the cells of a slot
+enum SPMPagePowerState {
+    PAGE_ON = 0,      // accessed at its operating point
+    PAGE_DROWSY = 1,  // keeps its data leaking less, must be woken up to be accessed
+    PAGE_OFF = 2,     // gated, neither leakage nor data
+    NUM_PAGE_POWER_STATES
+};
+
 typedef struct BEREnergyData
 {
     double knob1;  // voltage or read current
@@ -60,7 +70,7 @@ typedef struct BEREnergyData
     {}
 }BEREnergyData;
 
-class SPMPage
+class SPMPage : public Serializable
 {
   public:
 
@@ -72,24 +82,22 @@ class SPMPage
         init();
     }
 
-    ~SPMPage()
-    {
-        if (m_alloc)
-            delete [] m_data;
-    }
-
     void init()
     {
         obtainPageSize();
-        alloc();
+        m_data = nullptr;
         status = 0;
         setOccupancy(FREE_SLOT);
         setSpeed(Cycles(0), Cycles(0));
         readRefCount = 0;
         writeRefCount = 0;
+        faultCount = 0;
         tickInserted = 0;
         lastTickAccessed = 0;
         operatingPoint = 0;
+        powerState = PAGE_ON;
+        annotations = nullptr;
+        faultInjector = nullptr;
     }
 
     void readBERInfo(std::string ber_energy_file)
@@ -134,10 +142,16 @@ class SPMPage
         assert (_operating_point < berEnergyData.size());
         operatingPoint = _operating_point;
     }
+    int getOperatingPoint() const { return operatingPoint; }
 
     SPMPage& operator=(const SPMPage& obj);
 
+    // points the page to data, e.g. to its slot in the arena of the spm
     void assign(uint8_t *data);
+    // points the page to data and returns what it pointed to, the
+    // contents of the page move along without being copied
+    uint8_t *exchange(uint8_t *data);
+    bool hasData() const { return m_data != nullptr; }
 
     void clear();
     uint8_t getByte(int whichByte) const;
@@ -148,8 +162,9 @@ class SPMPage
     bool equal(const SPMPage& obj) const;
     void print(std::ostream& out) const;
 
-    void performRead(PacketPtr pkt);
-    void performWrite(PacketPtr pkt);
+    // both return the number of bits the access flipped
+    unsigned performRead(PacketPtr pkt);
+    unsigned performWrite(PacketPtr pkt);
 
     void setOccupancy (SPMSlotOccupancyStatus occupancy);
     void setUsed ();
@@ -163,13 +178,21 @@ class SPMPage
 
     float getReadEnergy();
     float getWriteEnergy();
+    // of the whole array at the operating point of the page
+    double getLeakagePower();
+
+    // the spm charges the leakage of the state, see SPM::setPagePowerState
+    void setPowerState(SPMPagePowerState _power_state) { powerState = _power_state; }
+    SPMPagePowerState getPowerState() const { return powerState; }
 
     std::vector<BEREnergyData> berEnergyData;
     int operatingPoint;
     void overrideActiveBERPoint(double read_ber, double write_ber);
     double getReadBER();
     double getWriteBER();
-    bool injectFault(uint8_t *data, int len, double ber);
+
+    // bit flips of approximate accesses come from the spm's injector
+    void setFaultInjector(SPMFaultInjector *_fault_injector);
 
     void setOwner (NodeID owner);
     NodeID getOwner();
@@ -177,7 +200,11 @@ class SPMPage
     void setAnnotations(Annotations *_annotation);
     Annotations *getAnnotations();
 
-    uint8_t *m_data; // TODO: this needs to be made private
+    // state of the page, its data is saved by the spm with the used slots
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+
+    uint8_t *m_data; // not owned, null for the pages of messages. TODO: this needs to be made private
 
     /** block state: OR of SPMPageStatusBits */
     typedef unsigned State;
@@ -195,15 +222,21 @@ class SPMPage
     Cycles writeLatency;
     Cycles readLatency;
 
+    SPMPagePowerState powerState;
+
     Annotations *annotations;
     NodeID ownerNode;
 
+    SPMFaultInjector *faultInjector;
+
     int pageSize;
     void obtainPageSize();
 
     /** Number of references to this page since it was brought in. */
     uint64_t readRefCount;
     uint64_t writeRefCount;
+    /** Number of accesses that got bit flips since it was brought in. */
+    uint64_t faultCount;
     /** Last time this page was accessed */
     Tick lastTickAccessed;
     /** When this page was inserted */
@@ -214,7 +247,9 @@ class SPMPage
     void readRefOccurred();
     void writeRefOccurred();
     uint64_t getRefCount();
+    uint64_t getFaultCount() const { return faultCount; }
     Tick getLastTickAccessed();
+    Tick getTickInserted();
     float pageUtlization();
 
   private:
@@ -261,21 +296,22 @@ class SPMPage
     void trackLoadLocked(PacketPtr pkt);
     void clearLoadLocks(RequestPtr req = nullptr);
     bool checkWrite(PacketPtr pkt);
-
-  private:
-    void alloc();
-    bool m_alloc;
 };
 
 inline void
 SPMPage::assign(uint8_t *data)
 {
     assert(data != NULL);
-    if (m_alloc) {
-        delete [] m_data;
-    }
     m_data = data;
-    m_alloc = false;
+}
+
+inline uint8_t *
+SPMPage::exchange(uint8_t *data)
+{
+    assert(data != NULL);
+    uint8_t *old_data = m_data;
+    m_data = data;
+    return old_data;
 }
 
 inline uint8_t
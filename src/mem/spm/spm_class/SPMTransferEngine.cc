@@ -0,0 +1,248 @@
+#include "mem/spm/spm_class/SPMTransferEngine.hh"
+
+#include <algorithm>
+#include <cstring>
+
+#include "debug/SPM.hh"
+#include "mem/spm/governor/GOVRequest.hh"
+#include "mem/spm/spm_class/SPMArena.hh"
+#include "mem/spm/spm_class/spm.hh"
+
+SPMTransferEngine::SPMTransferEngine(SPM *_spm, unsigned burst_size,
+                                     unsigned max_outstanding)
+    : spm(_spm),
+      burstSize(burst_size),
+      maxOutstanding(max_outstanding),
+      outstandingBursts(0)
+{
+    assert(burstSize > 0 && maxOutstanding > 0);
+}
+
+void
+SPMTransferEngine::startAllocation(PacketPtr run_pkt)
+{
+    Transfer *transfer = new Transfer;
+    transfer->run_pkt = run_pkt;
+    transfer->to_spm = true;
+    transfer->owns_pages = false;
+    transfer->ready_tick = curTick();
+
+    startTransfer(transfer);
+}
+
+void
+SPMTransferEngine::startDeallocation(PacketPtr run_pkt, Tick ready_tick)
+{
+    Transfer *transfer = new Transfer;
+    transfer->run_pkt = run_pkt;
+    transfer->to_spm = false;
+    transfer->ready_tick = ready_tick;
+
+    unsigned page_size = spm->pageSizeBytes;
+    unsigned first_page_index = spm->pAddress2PageIndex(run_pkt->govInfo().getSPMAddress());
+    int num_pages = run_pkt->govInfo().getNumPages();
+
+    // the run is copied unless the arena has a spare for each page
+    transfer->owns_pages = spm->zeroCopyTransfers &&
+                           spm->arena->getNumSpares() >= (unsigned)num_pages;
+
+    if (!transfer->owns_pages) {
+        transfer->data.resize(num_pages * page_size);
+    }
+    for (int page_index = 0; page_index < num_pages; page_index++) {
+        SPMPage *page = &spm->spmSlots[first_page_index + page_index];
+        assert(page->isValid());
+        if (transfer->owns_pages) {
+            // the slot is refilled before it is read again
+            transfer->pages.push_back(page->exchange(spm->arena->takeSpare()));
+        }
+        else {
+            memcpy(&transfer->data[page_index * page_size],
+                   page->getData(0, page_size), page_size);
+            transfer->pages.push_back(&transfer->data[page_index * page_size]);
+        }
+    }
+
+    startTransfer(transfer);
+}
+
+void
+SPMTransferEngine::startTransfer(Transfer *transfer)
+{
+    transfer->total_bytes = transfer->run_pkt->govInfo().getNumPages() * spm->pageSizeBytes;
+    transfer->issued_bytes = 0;
+    transfer->completed_bytes = 0;
+    assert(transfer->total_bytes > 0);
+
+    DPRINTF(SPM, "Transfer engine: %s run of %d page(s) from SPM address %d\n",
+            transfer->to_spm ? "filling" : "writing back",
+            transfer->run_pkt->govInfo().getNumPages(),
+            transfer->run_pkt->govInfo().getSPMAddress());
+
+    runs++;
+    transfers.push_back(transfer);
+    issueBursts();
+}
+
+void
+SPMTransferEngine::issueBursts()
+{
+    unsigned page_size = spm->pageSizeBytes;
+
+    while (outstandingBursts < maxOutstanding && !transfers.empty()) {
+        Transfer *transfer = transfers.front();
+
+        unsigned run_offset = transfer->issued_bytes;
+        int page_index = run_offset / page_size;
+        unsigned page_offset = run_offset % page_size;
+        unsigned size = std::min(burstSize, page_size - page_offset);
+
+        Addr mem_p_addr = transfer->run_pkt->govInfo().getRunPage(page_index).mem_p_addr;
+
+        RequestPtr req = new Request(mem_p_addr + page_offset, size,
+                                     Request::PHYSICAL, Request::funcMasterId);
+        req->setFlags(Request::UNCACHEABLE | Request::STRICT_ORDER);
+        PacketPtr burst = new Packet(req, transfer->to_spm ? MemCmd::ReadReq :
+                                                             MemCmd::WriteReq);
+        burst->allocate();
+        if (!transfer->to_spm) {
+            burst->setData(transfer->pages[page_index] + page_offset);
+        }
+        burst->pushSenderState(new BurstState(transfer, run_offset));
+
+        spm->memSidePort->schedTimingReq(burst, std::max(transfer->ready_tick, curTick()));
+
+        bursts++;
+        outstandingBursts++;
+        transfer->issued_bytes += size;
+        if (transfer->issued_bytes == transfer->total_bytes) {
+            transfers.pop_front();
+        }
+    }
+}
+
+bool
+SPMTransferEngine::recvBurstResp(PacketPtr pkt)
+{
+    BurstState *state = dynamic_cast<BurstState*>(pkt->senderState);
+    if (!state) {
+        return false;
+    }
+    pkt->popSenderState();
+
+    Transfer *transfer = state->transfer;
+    unsigned run_offset = state->run_offset;
+    delete state;
+
+    if (transfer->to_spm) {
+        unsigned page_size = spm->pageSizeBytes;
+        unsigned first_page_index = spm->pAddress2PageIndex(transfer->run_pkt->govInfo().getSPMAddress());
+        SPMPage *page = &spm->spmSlots[first_page_index + run_offset / page_size];
+        page->setData(pkt->getPtr<uint8_t>(), run_offset % page_size, pkt->getSize());
+    }
+
+    bytes += pkt->getSize();
+    transfer->completed_bytes += pkt->getSize();
+    outstandingBursts--;
+
+    delete pkt->req;
+    delete pkt;
+
+    if (transfer->completed_bytes == transfer->total_bytes) {
+        finishTransfer(transfer);
+    }
+
+    issueBursts();
+    return true;
+}
+
+Tick
+SPMTransferEngine::transferAtomic(PacketPtr run_pkt, bool to_spm)
+{
+    unsigned page_size = spm->pageSizeBytes;
+    unsigned first_page_index = spm->pAddress2PageIndex(run_pkt->govInfo().getSPMAddress());
+    unsigned total_bytes = run_pkt->govInfo().getNumPages() * page_size;
+    assert(total_bytes > 0);
+
+    DPRINTF(SPM, "Transfer engine: atomically %s run of %d page(s) from SPM address %d\n",
+            to_spm ? "filling" : "writing back",
+            run_pkt->govInfo().getNumPages(), run_pkt->govInfo().getSPMAddress());
+
+    Tick total_latency = 0;
+    unsigned num_bursts = 0;
+    unsigned run_offset = 0;
+    while (run_offset < total_bytes) {
+        int page_index = run_offset / page_size;
+        unsigned page_offset = run_offset % page_size;
+        unsigned size = std::min(burstSize, page_size - page_offset);
+
+        SPMPage *page = &spm->spmSlots[first_page_index + page_index];
+        Addr mem_p_addr = run_pkt->govInfo().getRunPage(page_index).mem_p_addr;
+
+        Request req(mem_p_addr + page_offset, size,
+                    Request::PHYSICAL, Request::funcMasterId);
+        req.setFlags(Request::UNCACHEABLE | Request::STRICT_ORDER);
+        Packet burst(&req, to_spm ? MemCmd::ReadReq : MemCmd::WriteReq);
+        burst.allocate();
+        if (!to_spm) {
+            burst.setData(page->getData(page_offset, size));
+        }
+
+        total_latency += spm->memSidePort->sendAtomic(&burst);
+
+        if (to_spm) {
+            page->setData(burst.getPtr<uint8_t>(), page_offset, size);
+        }
+
+        bursts++;
+        bytes += size;
+        num_bursts++;
+        run_offset += size;
+    }
+    runs++;
+
+    return total_latency / std::min(num_bursts, maxOutstanding);
+}
+
+void
+SPMTransferEngine::finishTransfer(Transfer *transfer)
+{
+    PacketPtr run_pkt = transfer->run_pkt;
+    bool to_spm = transfer->to_spm;
+    if (transfer->owns_pages) {
+        for (auto page : transfer->pages) {
+            spm->arena->returnSpare(page);
+        }
+    }
+    delete transfer;
+
+    // the whole run counted as a single pending memory request
+    spm->conditionalUnblocking(BaseSPM::Blocked_MaxPendingReqs);
+
+    run_pkt->makeResponse();
+    if (to_spm) {
+        spm->satisfyPageAllocation(run_pkt);
+    }
+    else {
+        spm->satisfyPageDeallocation(run_pkt);
+    }
+}
+
+void
+SPMTransferEngine::regStats(const std::string &name)
+{
+    runs
+        .name(name + ".transfer_runs")
+        .desc("Number of page runs moved by the transfer engine")
+        ;
+
+    bursts
+        .name(name + ".transfer_bursts")
+        .desc("Number of burst requests sent by the transfer engine")
+        ;
+
+    bytes
+        .name(name + ".transfer_bytes")
+        .desc("Number of bytes moved by the transfer engine")
+        ;
+}
@@ -0,0 +1,98 @@
+#ifndef __MEM_SPM_TRANSFER_ENGINE_HH__
+#define __MEM_SPM_TRANSFER_ENGINE_HH__
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "base/statistics.hh"
+#include "base/types.hh"
+#include "mem/packet.hh"
+
+class SPM;
+
+/**
+ * DMA-like engine moving whole runs of SPM pages between the SPM and the
+ * memory hierarchy. A run arrives from the PMMU as a single allocation or
+ * deallocation packet and is split into burst-sized memory requests, of
+ * which a bounded number is kept in flight. The run packet is handed back
+ * to the SPM once its last burst has completed.
+ */
+class SPMTransferEngine
+{
+  public:
+    SPMTransferEngine(SPM *_spm, unsigned burst_size,
+                      unsigned max_outstanding);
+
+    /** Fills the pages of a run from memory (COPY allocations). */
+    void startAllocation(PacketPtr run_pkt);
+
+    /**
+     * Writes the pages of a run back to memory (WRITE_BACK deallocations).
+     * The data is captured here, so the pages can be invalidated right
+     * after; with zero copy transfers the pages are taken out of their
+     * slots for spares of the arena rather than copied, if it has enough. No burst is sent before ready_tick.
+     */
+    void startDeallocation(PacketPtr run_pkt, Tick ready_tick);
+
+    /** Returns false if pkt is not one of our bursts. */
+    bool recvBurstResp(PacketPtr pkt);
+
+    /**
+     * Moves a whole run right away in atomic mode, from memory to the
+     * spm if to_spm is set and the other way around otherwise. Returns
+     * the latency of the run, with maxOutstanding bursts in flight.
+     */
+    Tick transferAtomic(PacketPtr run_pkt, bool to_spm);
+
+    /** No run is queued and no burst is in flight. */
+    bool isIdle() const
+    { return transfers.empty() && outstandingBursts == 0; }
+
+    void regStats(const std::string &name);
+
+  private:
+    typedef struct Transfer
+    {
+        PacketPtr run_pkt;
+        bool to_spm;
+        // snapshot of the run for write backs, a pointer per page into
+        // data or, if taken out of their slots, to spare pages
+        std::vector<uint8_t> data;
+        std::vector<uint8_t *> pages;
+        bool owns_pages;
+        unsigned total_bytes;
+        unsigned issued_bytes;
+        unsigned completed_bytes;
+        Tick ready_tick;
+    } Transfer;
+
+    class BurstState : public Packet::SenderState
+    {
+      public:
+        Transfer *transfer;
+        unsigned run_offset;
+
+        BurstState(Transfer *_transfer, unsigned _run_offset)
+            : transfer(_transfer), run_offset(_run_offset)
+        {}
+    };
+
+    SPM *spm;
+    const unsigned burstSize;
+    const unsigned maxOutstanding;
+
+    unsigned outstandingBursts;
+    // transfers that still have bursts to issue, served in order
+    std::deque<Transfer*> transfers;
+
+    void startTransfer(Transfer *transfer);
+    void issueBursts();
+    void finishTransfer(Transfer *transfer);
+
+    Stats::Scalar runs;
+    Stats::Scalar bursts;
+    Stats::Scalar bytes;
+};
+
+#endif // __MEM_SPM_TRANSFER_ENGINE_HH__
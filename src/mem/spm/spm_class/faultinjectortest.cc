@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "mem/spm/spm_class/SPMFaultInjector.hh"
+
+namespace {
+
+const int pageSize = 4096;
+const int numAccesses = 16;
+
+// the pages of numAccesses alternating writes and reads, starting out zero
+std::vector<std::vector<uint8_t>>
+injectFaults(uint64_t seed, const std::string &name, double ber)
+{
+    SPMFaultInjector injector;
+    injector.seed(seed, name);
+
+    std::vector<std::vector<uint8_t>> pages;
+    for (int i = 0; i < numAccesses; i++) {
+        pages.emplace_back(pageSize, 0);
+        if (i % 2)
+            injector.injectReadFaults(pages.back().data(), pageSize, ber);
+        else
+            injector.injectWriteFaults(pages.back().data(), pageSize, ber);
+    }
+    return pages;
+}
+
+int
+countFlips(const std::vector<std::vector<uint8_t>> &pages)
+{
+    int num_flips = 0;
+    for (auto &page : pages) {
+        for (auto byte : page)
+            num_flips += __builtin_popcount(byte);
+    }
+    return num_flips;
+}
+
+} // anonymous namespace
+
+TEST(SPMFaultInjectorTest, SameSeedSameFlips)
+{
+    auto pages = injectFaults(1, "system.spm0", 1e-3);
+
+    EXPECT_GT(countFlips(pages), 0);
+    EXPECT_EQ(pages, injectFaults(1, "system.spm0", 1e-3));
+}
+
+TEST(SPMFaultInjectorTest, SeedsAndSPMsDiffer)
+{
+    auto pages = injectFaults(1, "system.spm0", 1e-3);
+
+    EXPECT_NE(pages, injectFaults(2, "system.spm0", 1e-3));
+    EXPECT_NE(pages, injectFaults(1, "system.spm1", 1e-3));
+}
+
+TEST(SPMFaultInjectorTest, ReseedRestartsTheSequence)
+{
+    SPMFaultInjector injector;
+    std::vector<uint8_t> first(pageSize, 0);
+    std::vector<uint8_t> second(pageSize, 0);
+
+    injector.seed(7, "system.spm0");
+    injector.injectReadFaults(first.data(), pageSize, 1e-3);
+    injector.injectReadFaults(second.data(), pageSize, 1e-3);
+    EXPECT_NE(first, second);
+
+    std::vector<uint8_t> again(pageSize, 0);
+    injector.seed(7, "system.spm0");
+    injector.injectReadFaults(again.data(), pageSize, 1e-3);
+    EXPECT_EQ(first, again);
+}
+
+TEST(SPMFaultInjectorTest, ReturnsTheNumberOfFlips)
+{
+    SPMFaultInjector injector;
+    injector.seed(1, "system.spm0");
+    std::vector<uint8_t> page(pageSize, 0);
+
+    EXPECT_EQ(injector.injectReadFaults(page.data(), pageSize, 0), 0u);
+    EXPECT_EQ(injector.injectWriteFaults(page.data(), pageSize, 1e-30), 0u);
+    EXPECT_EQ(countFlips({page}), 0);
+
+    unsigned num_flips = injector.injectReadFaults(page.data(), pageSize, 0.5);
+    EXPECT_GT(num_flips, 0u);
+    EXPECT_EQ(countFlips({page}), (int)num_flips);
+}
+
+TEST(SPMFaultInjectorTest, RestoredStateFlipsTheSameBits)
+{
+    SPMFaultInjector injector;
+    injector.seed(3, "system.spm0");
+    std::vector<uint8_t> page(pageSize, 0);
+    // leaves a pending skip in both streams
+    injector.injectReadFaults(page.data(), pageSize, 1e-3);
+    injector.injectWriteFaults(page.data(), pageSize, 1e-4);
+
+    SPMFaultInjector restored;
+    ASSERT_TRUE(restored.setState(injector.getState()));
+
+    for (int i = 0; i < numAccesses; i++) {
+        std::vector<uint8_t> expected(pageSize, 0);
+        std::vector<uint8_t> actual(pageSize, 0);
+        if (i % 2) {
+            injector.injectReadFaults(expected.data(), pageSize, 1e-3);
+            restored.injectReadFaults(actual.data(), pageSize, 1e-3);
+        }
+        else {
+            injector.injectWriteFaults(expected.data(), pageSize, 1e-4);
+            restored.injectWriteFaults(actual.data(), pageSize, 1e-4);
+        }
+        EXPECT_EQ(expected, actual) << "access " << i;
+    }
+
+    EXPECT_FALSE(restored.setState("not a state"));
+}
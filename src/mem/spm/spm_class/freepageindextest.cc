@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+
+#include "mem/spm/spm_class/SPMFreePageIndex.hh"
+
+TEST(SPMFreePageIndexTest, StartsFree)
+{
+    SPMFreePageIndex index;
+    index.init(100);
+
+    EXPECT_EQ(index.getNumPages(), 100u);
+    EXPECT_EQ(index.getNumFreePages(), 100u);
+    EXPECT_EQ(index.getLargestFreeRun(), 100u);
+    EXPECT_EQ(index.getFragmentation(), 0);
+
+    unsigned run_start, run_length;
+    EXPECT_TRUE(index.findFreeRun(10, 0, run_start, run_length));
+    EXPECT_EQ(run_start, 0u);
+    EXPECT_EQ(run_length, 10u);
+}
+
+TEST(SPMFreePageIndexTest, FirstFit)
+{
+    SPMFreePageIndex index;
+    index.init(100);
+    index.setUsed(0, 10);
+    index.setUsed(50, 5);
+
+    EXPECT_EQ(index.getNumFreePages(), 85u);
+    EXPECT_FALSE(index.isFree(9));
+    EXPECT_TRUE(index.isFree(10));
+
+    unsigned run_start, run_length;
+    EXPECT_TRUE(index.findFreeRun(40, 0, run_start, run_length));
+    EXPECT_EQ(run_start, 10u);
+    EXPECT_EQ(run_length, 40u);
+
+    // the first run is too short, the second one fits
+    EXPECT_TRUE(index.findFreeRun(41, 0, run_start, run_length));
+    EXPECT_EQ(run_start, 55u);
+    EXPECT_EQ(run_length, 41u);
+
+    EXPECT_TRUE(index.findFreeRun(5, 60, run_start, run_length));
+    EXPECT_EQ(run_start, 60u);
+    EXPECT_EQ(run_length, 5u);
+}
+
+TEST(SPMFreePageIndexTest, LargestRunWhenNothingFits)
+{
+    SPMFreePageIndex index;
+    index.init(100);
+    index.setUsed(0, 10);
+    index.setUsed(50, 5);
+
+    unsigned run_start, run_length;
+    EXPECT_FALSE(index.findFreeRun(50, 0, run_start, run_length));
+    EXPECT_EQ(run_start, 55u);
+    EXPECT_EQ(run_length, 45u);
+
+    EXPECT_EQ(index.getLargestFreeRun(), 45u);
+    EXPECT_DOUBLE_EQ(index.getFragmentation(), 1.0 - 45.0 / 85.0);
+}
+
+TEST(SPMFreePageIndexTest, RunsAcrossWords)
+{
+    SPMFreePageIndex index;
+    index.init(200);
+    index.setUsed(0, 60);
+    index.setUsed(70, 60);
+
+    unsigned run_start, run_length;
+    EXPECT_TRUE(index.findFreeRun(10, 0, run_start, run_length));
+    EXPECT_EQ(run_start, 60u);
+    EXPECT_EQ(run_length, 10u);
+
+    // from the middle of a word to the end of the index
+    EXPECT_TRUE(index.findFreeRun(70, 0, run_start, run_length));
+    EXPECT_EQ(run_start, 130u);
+    EXPECT_EQ(run_length, 70u);
+
+    index.setFree(0, 200);
+    EXPECT_EQ(index.getNumFreePages(), 200u);
+    EXPECT_EQ(index.getLargestFreeRun(), 200u);
+}
+
+TEST(SPMFreePageIndexTest, NoFreePages)
+{
+    SPMFreePageIndex index;
+    index.init(64);
+    index.setUsed(0, 64);
+
+    unsigned run_start, run_length;
+    EXPECT_FALSE(index.findFreeRun(1, 0, run_start, run_length));
+    EXPECT_EQ(run_length, 0u);
+    EXPECT_TRUE(index.findFreeRun(0, 0, run_start, run_length));
+    EXPECT_EQ(index.getLargestFreeRun(), 0u);
+    EXPECT_EQ(index.getFragmentation(), 0);
+}
+
+TEST(SPMFreePageIndexTest, SetNumPagesHidesTheSlotsPastIt)
+{
+    SPMFreePageIndex index;
+    index.init(128);
+    index.setNumPages(64);
+
+    EXPECT_EQ(index.getNumPages(), 64u);
+    EXPECT_EQ(index.getNumFreePages(), 64u);
+    EXPECT_TRUE(index.isFree(63));
+    EXPECT_FALSE(index.isFree(64));
+    EXPECT_EQ(index.getLargestFreeRun(), 64u);
+
+    unsigned run_start, run_length;
+    EXPECT_FALSE(index.findFreeRun(65, 0, run_start, run_length));
+    EXPECT_EQ(run_start, 0u);
+    EXPECT_EQ(run_length, 64u);
+    EXPECT_FALSE(index.findFreeRun(1, 64, run_start, run_length));
+}
+
+TEST(SPMFreePageIndexTest, SetNumPagesLimitInsideAWord)
+{
+    SPMFreePageIndex index;
+    index.init(128);
+    index.setUsed(0, 10);
+    index.setNumPages(40);
+
+    EXPECT_EQ(index.getNumFreePages(), 30u);
+
+    unsigned run_start, run_length;
+    EXPECT_FALSE(index.findFreeRun(31, 0, run_start, run_length));
+    EXPECT_EQ(run_start, 10u);
+    EXPECT_EQ(run_length, 30u);
+}
+
+TEST(SPMFreePageIndexTest, SetNumPagesKeepsTheHiddenSlots)
+{
+    SPMFreePageIndex index;
+    index.init(128);
+    index.setNumPages(64);
+
+    // the slots past the limit keep their state, uncounted
+    index.setUsed(100, 10);
+    EXPECT_EQ(index.getNumFreePages(), 64u);
+
+    index.setNumPages(128);
+    EXPECT_EQ(index.getNumFreePages(), 118u);
+    EXPECT_FALSE(index.isFree(100));
+    EXPECT_TRUE(index.isFree(110));
+
+    unsigned run_start, run_length;
+    EXPECT_TRUE(index.findFreeRun(18, 100, run_start, run_length));
+    EXPECT_EQ(run_start, 110u);
+    EXPECT_EQ(run_length, 18u);
+}
+
+TEST(SPMFreePageIndexTest, SetNumPagesToZero)
+{
+    SPMFreePageIndex index;
+    index.init(64);
+    index.setNumPages(0);
+
+    EXPECT_EQ(index.getNumFreePages(), 0u);
+    EXPECT_EQ(index.getLargestFreeRun(), 0u);
+
+    unsigned run_start, run_length;
+    EXPECT_FALSE(index.findFreeRun(1, 0, run_start, run_length));
+}
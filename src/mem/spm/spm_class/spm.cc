@@ -51,11 +51,20 @@
  * SPM definitions.
  */
 
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "base/callback.hh"
 #include "base/types.hh"
+#include "debug/Checkpoint.hh"
+#include "debug/Drain.hh"
 #include "debug/SPM.hh"
 #include "debug/SPMPort.hh"
 #include "mem/spm/governor/GOVRequest.hh"
 #include "mem/spm/spm_class/spm.hh"
+#include "mem/spm/spm_class/SPMTransferEngine.hh"
 #include "mem/spm/pmmu.hh"
 #include "mem/cache/cache.hh"
 #include "sim/sim_exit.hh"
@@ -65,7 +74,22 @@ SPM::SPM(const SPMParams *p)
       read_ber(p->read_ber),
       write_ber(p->write_ber),
       ber_energy_file(p->ber_energy_file),
-      pendingReqs(0)
+      pendingReqs(0),
+      outstandingCPUReqs(0),
+      numBanks(p->num_banks),
+      bankInterleaving(p->bank_interleaving),
+      portsPerBank(p->ports_per_bank),
+      bankBusyCycles(p->bank_busy_cycles),
+      wakeupLatency(p->wakeup_latency),
+      drowsyLeakageFactor(p->drowsy_leakage_factor),
+      nominalOperatingPoint(0),
+      lowLeakageOperatingPoint(0),
+      hugePages(p->huge_pages),
+      zeroCopyTransfers(p->zero_copy_transfers),
+      reconfigurable(p->reconfigurable),
+      reconfigCache(nullptr),
+      spmWays(p->cache_ways),
+      resizeReadyTick(0)
 {
     cpuSidePort = new CpuSidePort(p->name + ".cpu_side", this,
                                   "CpuSidePort");
@@ -74,6 +98,16 @@ SPM::SPM(const SPMParams *p)
 
     pmmuSlavePort = new PMMUSideSlavePort(p->name + ".pmmu_s_side", this, 1);
     pmmuMasterPort = new PMMUSideMasterPort(p->name + ".pmmu_m_side", this, 0);
+
+    transferEngine = new SPMTransferEngine(this, p->transfer_burst_size,
+                                           p->transfer_max_outstanding);
+
+    faultInjector.seed(p->fault_seed, name());
+
+    fatal_if(numBanks && (bankInterleaving == 0 || portsPerBank == 0),
+             "%s: banks need an interleaving and at least one port\n",
+             name());
+    portBusyUntil.assign(numBanks * portsPerBank, 0);
 }
 
 void
@@ -84,26 +118,404 @@ SPM::init()
 
     myPMMU->setSPM(this);
     pageSizeBytes = myPMMU->getPageSizeBytes();
+    // a spare for every slot, so that each can have a page in flight
+    arena = new SPMArena(size/pageSizeBytes,
+                         zeroCopyTransfers ? size/pageSizeBytes : 0,
+                         pageSizeBytes, hugePages);
     spmSlots = new SPMPage[size/pageSizeBytes];
     for(int i = 0; i < size/pageSizeBytes; i++) {
+        spmSlots[i].assign(arena->getPage(i));
         spmSlots[i].readBERInfo(ber_energy_file);
         if (read_ber >= 0 || write_ber >= 0)  // if not their default values
             spmSlots[i].overrideActiveBERPoint(read_ber, write_ber);
+        spmSlots[i].setFaultInjector(&faultInjector);
+    }
+    freePageIndex.init(size/pageSizeBytes);
+
+    // the slots start at the configured point, the one leaking the
+    // least is the safest of the least leaking ones
+    nominalOperatingPoint = spmSlots[0].getOperatingPoint();
+    std::vector<BEREnergyData> &points = spmSlots[0].berEnergyData;
+    for (int point = 0; point < points.size(); point++) {
+        const BEREnergyData &lowest = points[lowLeakageOperatingPoint];
+        if (points[point].leakage_power < lowest.leakage_power ||
+            (points[point].leakage_power == lowest.leakage_power &&
+             points[point].read_ber < lowest.read_ber)) {
+            lowLeakageOperatingPoint = point;
+        }
+    }
+    leakageChargedUntil.assign(getNumSlots(), curTick());
+
+    if (reconfigurable) {
+        reconfigCache = dynamic_cast<Cache*>(memSidePort->getSlavePort().getOwner());
+        fatal_if(!reconfigCache, "%s: a reconfigurable spm needs a cache on "
+                 "its mem side\n", name());
+
+        unsigned way_size = reconfigCache->getWaySize();
+        fatal_if(size % way_size || way_size % pageSizeBytes,
+                 "%s: %d bytes of %d byte pages don't fill ways of %d bytes\n",
+                 name(), size, pageSizeBytes, way_size);
+        fatal_if(getMaxSPMWays() >= reconfigCache->getNumWays(),
+                 "%s: the cache must keep at least one of its %d ways\n",
+                 name(), reconfigCache->getNumWays());
+
+        // nothing is cached yet
+        bool M5_VAR_USED resized = setSPMWays(spmWays);
+        assert(resized);
     }
 }
 
+unsigned
+SPM::getMaxSPMWays() const
+{
+    return reconfigurable ? size / reconfigCache->getWaySize() : 0;
+}
+
+unsigned
+SPM::getPagesPerWay() const
+{
+    return reconfigCache->getWaySize() / pageSizeBytes;
+}
+
+bool
+SPM::setSPMWays(unsigned num_ways)
+{
+    assert(reconfigurable);
+    fatal_if(num_ways > getMaxSPMWays(), "%s can take %d ways at most\n",
+             name(), getMaxSPMWays());
+
+    // the tags of the spm ways aren't looked up anymore and the cache
+    // doesn't replace into them
+    Tick ready_tick;
+    bool resized = reconfigCache->setAllocatableWays(
+        reconfigCache->getNumWays() - num_ways, ready_tick);
+    resizeReadyTick = std::max(resizeReadyTick, ready_tick);
+    if (!resized) {
+        DPRINTF(SPM, "The cache can't give %d way(s) away yet\n", num_ways);
+        return false;
+    }
+
+    DPRINTF(SPM, "Taking %d of %d cache ways, %d slot(s)\n",
+            num_ways, reconfigCache->getNumWays(),
+            num_ways * getPagesPerWay());
+
+    // the slots given back to the cache don't leak for the spm anymore
+    chargeLeakage();
+
+    if (num_ways != spmWays)
+        spmResizes++;
+    spmWays = num_ways;
+
+    freePageIndex.setNumPages(num_ways * getPagesPerWay());
+    return true;
+}
+
 SPM::~SPM()
 {
     delete cpuSidePort;
     delete memSidePort;
+    delete transferEngine;
 
     delete [] spmSlots;
+    delete arena;
 }
 
 void
 SPM::regStats()
 {
     BaseSPM::regStats();
+
+    transferEngine->regStats(name());
+
+    spmResizes
+        .name(name() + ".spm_resizes")
+        .desc("Number of times the spm took or gave back cache ways")
+        ;
+
+    bankAccesses
+        .init(std::max(numBanks, 1u))
+        .name(name() + ".bank_accesses")
+        .desc("Number of accesses to every bank")
+        .flags(Stats::nozero)
+        ;
+
+    bankConflicts
+        .name(name() + ".bank_conflicts")
+        .desc("Number of accesses that waited for a port of a bank")
+        ;
+
+    bankQueueingCycles
+        .name(name() + ".bank_queueing_cycles")
+        .desc("Total cycles accesses waited for ports of banks")
+        ;
+
+    avgBankQueueing
+        .name(name() + ".avg_bank_queueing")
+        .desc("Average cycles an access that conflicted waited for its banks")
+        ;
+    avgBankQueueing = bankQueueingCycles / bankConflicts;
+
+    staticEnergy
+        .name(name() + ".static_energy")
+        .desc("Leakage energy of the slots of the spm (nJ)")
+        ;
+
+    pageWakeups
+        .name(name() + ".page_wakeups")
+        .desc("Number of accesses that woke a drowsy or gated slot up")
+        ;
+
+    freePages
+        .method(&freePageIndex, &SPMFreePageIndex::getNumFreePages)
+        .name(name() + ".free_pages")
+        .desc("Number of free SPM slots")
+        ;
+
+    largestFreeRun
+        .method(&freePageIndex, &SPMFreePageIndex::getLargestFreeRun)
+        .name(name() + ".largest_free_run")
+        .desc("Number of slots in the largest run of free SPM slots")
+        ;
+
+    fragmentation
+        .method(&freePageIndex, &SPMFreePageIndex::getFragmentation)
+        .name(name() + ".fragmentation")
+        .desc("Fraction of free SPM slots outside the largest free run")
+        ;
+
+    readBitFlips
+        .name(name() + ".read_bit_flips")
+        .desc("Number of bits flipped on reads of approximate data")
+        ;
+
+    writeBitFlips
+        .name(name() + ".write_bit_flips")
+        .desc("Number of bits flipped on writes of approximate data")
+        ;
+
+    faultyReads
+        .name(name() + ".faulty_reads")
+        .desc("Number of reads that returned at least one flipped bit")
+        ;
+
+    faultyWrites
+        .name(name() + ".faulty_writes")
+        .desc("Number of writes that stored at least one flipped bit")
+        ;
+
+    Stats::registerDumpCallback(new MakeCallback<SPM, &SPM::chargeLeakage>(this));
+    Stats::registerResetCallback(new MakeCallback<SPM, &SPM::resetLeakage>(this));
+}
+
+void
+SPM::chargeSlotLeakage(unsigned page_index)
+{
+    SPMPage &page = spmSlots[page_index];
+    Tick since = leakageChargedUntil[page_index];
+    leakageChargedUntil[page_index] = curTick();
+
+    // the slots past the spm's ways belong to the cache
+    if (page_index >= freePageIndex.getNumPages() || page.getPowerState() == PAGE_OFF) {
+        return;
+    }
+
+    double factor = page.getPowerState() == PAGE_DROWSY ? drowsyLeakageFactor : 1;
+    double seconds = (double)(curTick() - since) / SimClock::Frequency;
+    // mW for the whole array over s gives mJ, 1e6 nJ each
+    staticEnergy += page.getLeakagePower() / getNumSlots() * factor * seconds * 1e6;
+}
+
+void
+SPM::chargeLeakage()
+{
+    for (unsigned i = 0; i < getNumSlots(); i++) {
+        chargeSlotLeakage(i);
+    }
+}
+
+void
+SPM::resetLeakage()
+{
+    leakageChargedUntil.assign(getNumSlots(), curTick());
+}
+
+void
+SPM::setPagePowerState(unsigned page_index, SPMPagePowerState state)
+{
+    assert(page_index < getNumSlots());
+    if (spmSlots[page_index].getPowerState() == state) {
+        return;
+    }
+
+    chargeSlotLeakage(page_index);
+    spmSlots[page_index].setPowerState(state);
+}
+
+void
+SPM::setPageOperatingPoint(unsigned page_index, int operating_point)
+{
+    assert(page_index < getNumSlots());
+    if (spmSlots[page_index].getOperatingPoint() == operating_point) {
+        return;
+    }
+
+    chargeSlotLeakage(page_index);
+    spmSlots[page_index].setOperatingPoint(operating_point);
+}
+
+Cycles
+SPM::wakePage(unsigned page_index)
+{
+    if (spmSlots[page_index].getPowerState() == PAGE_ON) {
+        return Cycles(0);
+    }
+
+    setPagePowerState(page_index, PAGE_ON);
+    pageWakeups++;
+    return wakeupLatency;
+}
+
+Cycles
+SPM::accessBanks(Addr spm_addr, unsigned access_size)
+{
+    // contention is only modeled with timing
+    if (!numBanks || !system->isTimingMode() || access_size == 0) {
+        return Cycles(0);
+    }
+
+    // every bank serves the interleaving units of the access it has on
+    // its earliest free port, the access completes with the last of them
+    const Addr first_unit = spm_addr / bankInterleaving;
+    const Addr last_unit = (spm_addr + access_size - 1) / bankInterleaving;
+    const Tick now = clockEdge();
+    Tick done = now;
+    Tick wait = 0;
+    for (Addr unit = first_unit;
+         unit <= last_unit && unit < first_unit + numBanks; unit++) {
+        unsigned bank = unit % numBanks;
+        uint64_t bank_units = (last_unit - unit) / numBanks + 1;
+
+        auto port_begin = portBusyUntil.begin() + bank * portsPerBank;
+        auto port = std::min_element(port_begin, port_begin + portsPerBank);
+        Tick start = std::max(now, *port);
+        *port = start + cyclesToTicks(Cycles(bankBusyCycles * bank_units));
+
+        wait = std::max(wait, start - now);
+        done = std::max(done, *port);
+        bankAccesses[bank]++;
+    }
+
+    Cycles wait_cycles = ticksToCycles(wait);
+    if (wait_cycles > 0) {
+        bankConflicts++;
+        bankQueueingCycles += wait_cycles;
+        DPRINTF(SPM, "Access of %d byte(s) at SPM address %#x waits %d "
+                "cycle(s) for its banks\n", access_size, spm_addr,
+                wait_cycles);
+    }
+
+    // the first unit of a bank overlaps with the array access itself
+    Cycles busy_cycles = ticksToCycles(done - now);
+    return busy_cycles > bankBusyCycles ? busy_cycles - bankBusyCycles :
+                                          Cycles(0);
+}
+
+void
+SPM::regProbePoints()
+{
+    ppAccess.reset(new ProbePointArg<PacketPtr>(getProbeManager(), "Access"));
+}
+
+void
+SPM::serialize(CheckpointOut &cp) const
+{
+    if (!transferEngine->isIdle() || outstandingCPUReqs)
+        fatal("SPM %s must be drained before checkpointing\n", name());
+
+    BaseSPM::serialize(cp);
+
+    std::vector<unsigned> used_slots;
+    for (unsigned i = 0; i < size/pageSizeBytes; i++) {
+        if (!spmSlots[i].isFree()) {
+            used_slots.push_back(i);
+            spmSlots[i].serializeSection(cp, csprintf("slot%d", i));
+        }
+    }
+
+    std::string filename = name() + ".spm";
+    SERIALIZE_CONTAINER(used_slots);
+    SERIALIZE_SCALAR(filename);
+    SERIALIZE_SCALAR(spmWays);
+
+    DPRINTF(Checkpoint, "Serializing %d used page(s) of %s\n",
+            used_slots.size(), name());
+
+    std::string filepath = CheckpointIn::dir() + "/" + filename;
+    gzFile compressed_spm = gzopen(filepath.c_str(), "wb");
+    if (compressed_spm == NULL)
+        fatal("Can't open SPM checkpoint file '%s'\n", filename);
+
+    for (unsigned i : used_slots) {
+        if (gzwrite(compressed_spm, spmSlots[i].getData(0, pageSizeBytes),
+                    pageSizeBytes) != (int)pageSizeBytes)
+            fatal("Write failed on SPM checkpoint file '%s'\n", filename);
+    }
+
+    if (gzclose(compressed_spm))
+        fatal("Close failed on SPM checkpoint file '%s'\n", filename);
+
+    std::string fault_state = faultInjector.getState();
+    SERIALIZE_SCALAR(fault_state);
+}
+
+void
+SPM::unserialize(CheckpointIn &cp)
+{
+    BaseSPM::unserialize(cp);
+
+    std::vector<unsigned> used_slots;
+    std::string filename;
+    UNSERIALIZE_CONTAINER(used_slots);
+    UNSERIALIZE_SCALAR(filename);
+
+    if (reconfigurable) {
+        unsigned spm_ways;
+        paramIn(cp, "spmWays", spm_ways);
+        fatal_if(!setSPMWays(spm_ways), "%s: the cache can't give %d "
+                 "way(s) away while restoring\n", name(), spm_ways);
+    }
+
+    DPRINTF(Checkpoint, "Unserializing %d used page(s) of %s\n",
+            used_slots.size(), name());
+
+    std::string filepath = cp.cptDir + "/" + filename;
+    gzFile compressed_spm = gzopen(filepath.c_str(), "rb");
+    if (compressed_spm == NULL)
+        fatal("Can't open SPM checkpoint file '%s'\n", filename);
+
+    uint8_t *page_data = new uint8_t[pageSizeBytes];
+    for (unsigned i : used_slots) {
+        if (i >= size/pageSizeBytes)
+            fatal("SPM %s has no slot %d, did its size change?\n", name(), i);
+
+        spmSlots[i].unserializeSection(cp, csprintf("slot%d", i));
+
+        if (gzread(compressed_spm, page_data, pageSizeBytes) != (int)pageSizeBytes)
+            fatal("Read failed on SPM checkpoint file '%s'\n", filename);
+        spmSlots[i].setData(page_data, 0, pageSizeBytes);
+        freePageIndex.setUsed(i, 1);
+    }
+    delete [] page_data;
+
+    if (gzclose(compressed_spm))
+        fatal("Close failed on SPM checkpoint file '%s'\n", filename);
+
+    std::string fault_state;
+    UNSERIALIZE_SCALAR(fault_state);
+    fatal_if(!faultInjector.setState(fault_state),
+             "%s: can't restore the state of the fault injector\n", name());
+
+    resetLeakage();
 }
 
 /////////////////////////////////////////////////////
@@ -141,8 +553,48 @@ SPM::recvTimingSnoopResp(PacketPtr pkt)
 Tick
 SPM::recvAtomic(PacketPtr pkt)
 {
-    panic("recvAtomic()");
-    return 0;
+    assert(pkt->isRequest());
+
+    if (system->bypassCaches()) {
+        return memSidePort->sendAtomic(pkt);
+    }
+
+    ppAccess->notify(pkt);
+
+    // the pmmu translates the access, and serves it right away
+    // if the page is on a remote spm
+    Tick lat = pmmuMasterPort->sendAtomic(pkt);
+
+    if (pkt->spmInfo().isLocal()) {
+        incLocalHitCount(pkt);
+        timelineCounters.localBytes += pkt->getSize();
+
+        Cycles access_lat;
+        satisfySPMAccess(pkt, &access_lat);
+        lat += cyclesToTicks(access_lat);
+
+        pkt->makeResponse();
+
+    } else if (pkt->spmInfo().isRemote()) {
+        pkt->retrieveCmd();
+        incRemoteHitCount(pkt);
+        timelineCounters.remoteBytes += pkt->getSize();
+        lat += cyclesToTicks(forwardLatency);
+
+        pkt->makeResponse();
+
+    } else if (pkt->spmInfo().isUnallocated()) {
+        incMissCount(pkt);
+        lat += memSidePort->sendAtomic(pkt);
+
+    } else if (pkt->spmInfo().isNotSPMSpace()) {
+        lat += memSidePort->sendAtomic(pkt);
+
+    } else {
+        panic("Invalid data holder!");
+    }
+
+    return lat;
 }
 
 
@@ -160,6 +612,15 @@ SPM::functionalAccess(PacketPtr pkt, bool fromCpuSide)
         return;
     }
 
+    // pages on the spms are only known by their virtual address
+    if (fromCpuSide && pkt->req->hasVaddr() && pkt->req->hasContextId()) {
+        pmmuMasterPort->sendFunctional(pkt);
+        if (pkt->isResponse()) {
+            pkt->popLabel();
+            return;
+        }
+    }
+
     bool done = cpuSidePort->checkFunctional(pkt)
         || memSidePort->checkFunctional(pkt);
 
@@ -332,17 +793,12 @@ MemSidePort::MemSidePort(const std::string &_name, SPM *_spm,
 void
 SPM::recvTimingResp(PacketPtr pkt)
 {
-    if (pkt->govInfo.isAllocate()) {
-        // unblock the cpu port
-        conditionalUnblocking(Blocked_MaxPendingReqs);
-        satisfyPageAllocation (pkt);
-    }
-    else if (pkt->govInfo.isDeallocate()) {
-        // unblock the cpu port
-        conditionalUnblocking(Blocked_MaxPendingReqs);
-        satisfyPageDeallocation(pkt);
+    // page allocations/deallocations are moved in bursts by the engine,
+    // which unblocks the cpu port once a whole run is done
+    if (transferEngine->recvBurstResp(pkt)) {
+        return;
     }
-    else if (!pkt->spmInfo.isOnChip()) {
+    else if (!pkt->spmInfo().isOnChip()) {
         // unblock the cpu port
         conditionalUnblocking(Blocked_MaxPendingReqs);
         sendTimingRespToCPU(pkt, forwardLatency);
@@ -372,6 +828,12 @@ SPM::recvTimingReq(PacketPtr pkt)
     //memSidePort->schedTimingReq(pkt, curTick()+1);
     //return true;
 
+    if (pkt->needsResponse()) {
+        outstandingCPUReqs++;
+    }
+
+    ppAccess->notify(pkt);
+
     // Query PPMU for data holder or ask for performing a remote access
     pmmuMasterPort->schedTimingReq(pkt, curTick());
 
@@ -384,15 +846,15 @@ SPM::recvPMMUTimingReq(PacketPtr pkt)
     assert(pkt->isRequest());
 
     //case 1: page allocation
-    if (pkt->govInfo.isAllocate()) {
+    if (pkt->govInfo().isAllocate()) {
         // forward it to main memory,
         // once response returned from memory we will fill the SPM
-        if (pkt->govInfo.getAnnotations()->alloc_mode == COPY) {
+        if (pkt->govInfo().getAnnotations()->alloc_mode == COPY) {
             initializePageAllocation(pkt);
         }
 
         else {
-            assert(pkt->govInfo.getAnnotations()->alloc_mode == UNINITIALIZE);
+            assert(pkt->govInfo().getAnnotations()->alloc_mode == UNINITIALIZE);
             pkt->makeResponse();
             conditionalUnblocking(Blocked_MaxPendingReqs);
             satisfyPageAllocation(pkt);
@@ -401,16 +863,16 @@ SPM::recvPMMUTimingReq(PacketPtr pkt)
         return true;
     }
     //case 2: page deallocation
-    else if (pkt->govInfo.isDeallocate()) {
+    else if (pkt->govInfo().isDeallocate()) {
         // page number should be in the pkt
         // i) find the page
         // ii) call a pageDeallocation function
-        if (pkt->govInfo.getAnnotations()->dealloc_mode == WRITE_BACK) {
+        if (pkt->govInfo().getAnnotations()->dealloc_mode == WRITE_BACK) {
             initializePageDeallocation(pkt);
         }
 
         else {
-            assert(pkt->govInfo.getAnnotations()->dealloc_mode == DISCARD);
+            assert(pkt->govInfo().getAnnotations()->dealloc_mode == DISCARD);
             initializePageDeallocation(pkt);
             pkt->makeResponse();
             conditionalUnblocking(Blocked_MaxPendingReqs);
@@ -421,9 +883,9 @@ SPM::recvPMMUTimingReq(PacketPtr pkt)
     }
     //case 3: relocations
     //TODO: Consolidate this with the next case?
-    else if (pkt->govInfo.isRelocationRead() || pkt->govInfo.isRelocationWrite()) {
+    else if (pkt->govInfo().isRelocationRead() || pkt->govInfo().isRelocationWrite()) {
         Cycles lat;
-        satisfySPMAccess(pkt, &lat);
+        satisfyPageRelocation(pkt, &lat);
 
         pkt->saveCmd();
         pkt->makeResponse();
@@ -432,7 +894,7 @@ SPM::recvPMMUTimingReq(PacketPtr pkt)
         return true;
     }
     //case 4: remote requests
-    else if (pkt->spmInfo.isRemote()) {
+    else if (pkt->spmInfo().isRemote()) {
         Cycles lat;
         satisfySPMAccess(pkt, &lat);
 
@@ -447,6 +909,87 @@ SPM::recvPMMUTimingReq(PacketPtr pkt)
     }
 }
 
+Tick
+SPM::recvPMMUAtomicReq(PacketPtr pkt)
+{
+    assert(pkt->isRequest());
+
+    Cycles lat = Cycles(0);
+    Tick mem_lat = 0;
+
+    //case 1: page allocation
+    if (pkt->govInfo().isAllocate()) {
+        if (pkt->govInfo().getAnnotations()->alloc_mode == COPY) {
+            mem_lat = transferEngine->transferAtomic(pkt, true);
+        }
+        else {
+            assert(pkt->govInfo().getAnnotations()->alloc_mode == UNINITIALIZE);
+        }
+
+        lat = fillPageRun(pkt);
+        pkt->govInfo().markComplete();
+    }
+    //case 2: page deallocation
+    else if (pkt->govInfo().isDeallocate()) {
+        unsigned int first_page_index = pAddress2PageIndex(pkt->govInfo().getSPMAddress());
+        int num_pages = pkt->govInfo().getNumPages();
+
+        if (pkt->govInfo().getAnnotations()->dealloc_mode == WRITE_BACK) {
+            for (int page_index = 0; page_index < num_pages; page_index++) {
+                SPMPage* page = &spmSlots[first_page_index + page_index];
+                incDynamicEnergy(pkt, page->getReadEnergy()*(pageSizeBytes));
+                lat = std::max(lat, page->getReadSpeed() + fillLatency +
+                                    wakePage(first_page_index + page_index));
+            }
+            mem_lat = transferEngine->transferAtomic(pkt, false);
+        }
+        else {
+            assert(pkt->govInfo().getAnnotations()->dealloc_mode == DISCARD);
+        }
+
+        for (int page_index = 0; page_index < num_pages; page_index++) {
+            spmSlots[first_page_index + page_index].invalidate(true);
+        }
+        pkt->govInfo().markComplete();
+    }
+    //case 3: relocations
+    else if (pkt->govInfo().isRelocationRead() || pkt->govInfo().isRelocationWrite()) {
+        satisfyPageRelocation(pkt, &lat);
+    }
+    //case 4: remote requests
+    else if (pkt->spmInfo().isRemote()) {
+        satisfySPMAccess(pkt, &lat);
+        pkt->saveCmd();
+    }
+    else {
+        panic("Invalid request type received from PMMU");
+    }
+
+    pkt->makeResponse();
+    return cyclesToTicks(lat) + mem_lat;
+}
+
+void
+SPM::recvPMMUFunctionalReq(PacketPtr pkt)
+{
+    unsigned int spm_page_index = pAddress2PageIndex(pkt->spmInfo().getSPMAddress());
+    assert (spm_page_index < size/pageSizeBytes);
+
+    SPMPage *page = &spmSlots[spm_page_index];
+    unsigned offset = pkt->req->getVaddr() % pageSizeBytes;
+    assert(offset + pkt->getSize() <= pageSizeBytes);
+
+    // no timing, energy or fault bookkeeping for functional accesses
+    if (pkt->isRead()) {
+        pkt->setData(page->getData(offset, pkt->getSize()));
+    }
+    else if (pkt->isWrite()) {
+        page->setData(pkt->getPtr<uint8_t>(), offset, pkt->getSize());
+    }
+
+    pkt->makeResponse();
+}
+
 void
 SPM::recvPMMUTimingResp(PacketPtr pkt)
 {
@@ -454,7 +997,7 @@ SPM::recvPMMUTimingResp(PacketPtr pkt)
     assert(pkt->isResponse());
 
     DPRINTF(SPM, "SPM <== PMMU - VA = %x\t - Data holder = %s\n",
-            pkt->req->getVaddr(), (pkt->spmInfo.toString()));
+            pkt->req->getVaddr(), (pkt->spmInfo().toString()));
 
     bool is_error = pkt->isError();
 
@@ -471,29 +1014,31 @@ SPM::recvPMMUTimingResp(PacketPtr pkt)
         return;
     }
 
-    if (pkt->spmInfo.isLocal()) {
+    if (pkt->spmInfo().isLocal()) {
 
         DPRINTF(SPM, "CPU <== SPM - VA = %x\n", pkt->req->getVaddr());
 
         // @TODO: temporary work-around for stats as hits should be counted for a req not resp
         pkt->retrieveCmd();
         incLocalHitCount(pkt);
+        timelineCounters.localBytes += pkt->getSize();
 
         Cycles lat;
         satisfySPMAccess (pkt, &lat);
 
         sendTimingRespToCPU(pkt, lat);
 
-    } else if (pkt->spmInfo.isRemote()){
+    } else if (pkt->spmInfo().isRemote()){
 
         DPRINTF(SPM, "CPU <== SPM - VA = %x\n", pkt->req->getVaddr());
 
         pkt->retrieveCmd();
         incRemoteHitCount(pkt);
+        timelineCounters.remoteBytes += pkt->getSize();
 
         sendTimingRespToCPU(pkt, forwardLatency);
 
-    } else if (pkt->spmInfo.isUnallocated()) {
+    } else if (pkt->spmInfo().isUnallocated()) {
         assert (pendingReqs <= MAX_PENDING_REQS);
 
         pkt->retrieveCmd();
@@ -502,7 +1047,7 @@ SPM::recvPMMUTimingResp(PacketPtr pkt)
 
         memSidePort->schedTimingReq(pkt, curTick());
 
-    } else if (pkt->spmInfo.isNotSPMSpace()) {
+    } else if (pkt->spmInfo().isNotSPMSpace()) {
         assert (pendingReqs <= MAX_PENDING_REQS);
 
         pkt->retrieveCmd();
@@ -520,50 +1065,116 @@ SPM::satisfySPMAccess(PacketPtr pkt, Cycles* lat)
     DPRINTF(SPM, "%s for %s VA = %x size %d\n", __func__,
             pkt->cmdString(), pkt->req->getVaddr(), pkt->getSize());
 
-    unsigned int spm_page_index = pAddress2PageIndex(pkt->spmInfo.getSPMAddress());
+    unsigned int spm_page_index = pAddress2PageIndex(pkt->spmInfo().getSPMAddress());
     assert (spm_page_index < size/pageSizeBytes);
 
     SPMPage *page =  &spmSlots[spm_page_index]; // TODO: we need to do some bookkeeping for accesses, latencies, etc
 
     if (pkt->isWrite()) {
         if (page->checkWrite(pkt)) {
-            *lat = page->getWriteSpeed() + lookupLatency;
-            if (pkt->govInfo.isRelocationWrite()) {
-                page->resetStatsForNewlyAddedPage();
-                page->setAnnotations(pkt->govInfo.getAnnotations());
-                page->performWrite(pkt);
-                incDynamicEnergy(pkt, page->getWriteEnergy()*(pageSizeBytes));
-            }
-            else {
-                pkt->setAddr(pkt->req->getVaddr()); // because offset calculation requires virtual address
-                page->performWrite(pkt);
-                page->writeRefOccurred();
-                incDynamicEnergy(pkt, page->getWriteEnergy()*(pkt->getSize()));
+            *lat = page->getWriteSpeed() + lookupLatency +
+                   wakePage(spm_page_index) +
+                   accessBanks(pkt->spmInfo().getSPMAddress(), pkt->getSize());
+            pkt->setAddr(pkt->req->getVaddr()); // because offset calculation requires virtual address
+            unsigned num_flips = page->performWrite(pkt);
+            if (num_flips) {
+                writeBitFlips += num_flips;
+                faultyWrites++;
             }
+            page->writeRefOccurred();
+            incDynamicEnergy(pkt, page->getWriteEnergy()*(pkt->getSize()));
         }
 
     } else if (pkt->isRead()) {
         if (pkt->isLLSC()) {
             page->trackLoadLocked(pkt);
         }
-        *lat = page->getReadSpeed() + lookupLatency;
-        if (pkt->govInfo.isRelocationRead()) {
-            page->performRead(pkt);
-            page->invalidate(false);
-            incDynamicEnergy(pkt, page->getReadEnergy()*(pageSizeBytes));
-        }
-        else {
-            pkt->setAddr(pkt->req->getVaddr()); // because offset calculation requires virtual address
-            page->performRead(pkt);
-            page->readRefOccurred();
-            incDynamicEnergy(pkt, page->getReadEnergy()*(pkt->getSize()));
+        *lat = page->getReadSpeed() + lookupLatency +
+               wakePage(spm_page_index) +
+               accessBanks(pkt->spmInfo().getSPMAddress(), pkt->getSize());
+        pkt->setAddr(pkt->req->getVaddr()); // because offset calculation requires virtual address
+        unsigned num_flips = page->performRead(pkt);
+        if (num_flips) {
+            readBitFlips += num_flips;
+            faultyReads++;
         }
+        page->readRefOccurred();
+        incDynamicEnergy(pkt, page->getReadEnergy()*(pkt->getSize()));
 
     }
 
     return true;
 }
 
+void
+SPM::satisfyPageRelocation(PacketPtr pkt, Cycles* lat)
+{
+    unsigned int first_page_index = pAddress2PageIndex(pkt->spmInfo().getSPMAddress());
+    int num_pages = pkt->govInfo().getNumPages();
+    assert (first_page_index + num_pages <= size/pageSizeBytes);
+    assert (pkt->getSize() == num_pages * pageSizeBytes);
+
+    DPRINTF(SPM, "%s for %d page(s) from SPM Page = %d\n", __func__,
+            num_pages, first_page_index);
+
+    if (pkt->govInfo().isRelocationWrite()) {
+        timelineCounters.relocatedPages += num_pages;
+    }
+
+    // the pages of a run are accessed back to back
+    *lat = Cycles(0);
+    for (int page_index = 0; page_index < num_pages; page_index++) {
+        SPMPage *page = &spmSlots[first_page_index + page_index];
+        uint8_t *page_data = pkt->getPtr<uint8_t>() + page_index * pageSizeBytes;
+        Addr page_addr = (first_page_index + page_index) * pageSizeBytes;
+
+        GOVRunPage &run_page = pkt->govInfo().getRunPage(page_index);
+
+        if (pkt->govInfo().isRelocationWrite()) {
+            page->checkWrite(pkt);
+            page->resetStatsForNewlyAddedPage();
+            page->setAnnotations(run_page.annotations);
+            if (run_page.page_data) {
+                // the page taken out of its old slot takes this one's place
+                arena->returnSpare(page->exchange(run_page.page_data));
+                run_page.page_data = nullptr;
+            }
+            else {
+                page->setData(page_data, 0, pageSizeBytes);
+            }
+            incDynamicEnergy(pkt, page->getWriteEnergy()*(pageSizeBytes));
+            *lat = std::max(*lat, page->getWriteSpeed() + lookupLatency +
+                                  wakePage(first_page_index + page_index) +
+                                  accessBanks(page_addr, pageSizeBytes));
+        }
+        else {
+            assert(pkt->govInfo().isRelocationRead());
+            assert(page->isValid());
+            // the page travels on the side, the timing still follows the
+            // data of the packet; pages going to another spm are copied,
+            // so that slots stay in the arena of their own spm
+            uint8_t *spare = nullptr;
+            if (zeroCopyTransfers && !pkt->govInfo().keepsSource() &&
+                pkt->govInfo().getFutureHost() == myPMMU->getNodeID()) {
+                spare = arena->takeSpare();
+            }
+            if (spare) {
+                run_page.page_data = page->exchange(spare);
+            }
+            else {
+                memcpy(page_data, page->getData(0, pageSizeBytes), pageSizeBytes);
+            }
+            if (!pkt->govInfo().keepsSource()) {
+                page->invalidate(false);
+            }
+            incDynamicEnergy(pkt, page->getReadEnergy()*(pageSizeBytes));
+            *lat = std::max(*lat, page->getReadSpeed() + lookupLatency +
+                                  wakePage(first_page_index + page_index) +
+                                  accessBanks(page_addr, pageSizeBytes));
+        }
+    }
+}
+
 void
 SPM::sendTimingRespToCPU(PacketPtr pkt, Cycles lat)
 {
@@ -574,18 +1185,18 @@ SPM::sendTimingRespToCPU(PacketPtr pkt, Cycles lat)
     // has been received from PMMU
     Tick completion_time = clockEdge(lat - Cycles(1));
 
-    if (pkt->spmInfo.isLocal()) {
+    if (pkt->spmInfo().isLocal()) {
     }
 
-    else if (pkt->spmInfo.isRemote()) {
+    else if (pkt->spmInfo().isRemote()) {
     }
 
-    else if (pkt->spmInfo.isUnallocated()) {
+    else if (pkt->spmInfo().isUnallocated()) {
         missLatency[pkt->cmdToIndex()][pkt->req->masterId()] +=
             completion_time - pkt->req->time();
     }
 
-    else if (pkt->spmInfo.isNotSPMSpace()) {
+    else if (pkt->spmInfo().isNotSPMSpace()) {
     }
 
     // path for local/remote spm is already a response
@@ -594,6 +1205,10 @@ SPM::sendTimingRespToCPU(PacketPtr pkt, Cycles lat)
         pkt->makeResponse();
 
     cpuSidePort->schedTimingResp(pkt, completion_time);
+
+    assert(outstandingCPUReqs > 0);
+    outstandingCPUReqs--;
+    checkDrain();
 }
 
 ///////////////
@@ -608,30 +1223,45 @@ SPM::initializePageAllocation(PacketPtr pkt)
     //conditionalBlocking(Blocked_MaxPendingReqs);
     assert (pendingReqs <= MAX_PENDING_REQS);
 
-    memSidePort->schedTimingReq(pkt, curTick());
+    transferEngine->startAllocation(pkt);
 }
 
-void
-SPM::satisfyPageAllocation(PacketPtr pkt)
+Cycles
+SPM::fillPageRun(PacketPtr pkt)
 {
-    unsigned int spm_page_index = pAddress2PageIndex(pkt->govInfo.getSPMAddress());
-
-    DPRINTF(SPM, "satisfyPageAllocation on SPM Page = %d\n", spm_page_index);
-
-    SPMPage* page = &spmSlots[spm_page_index];
-//  page->setOwner(pkt->origin); // we do it before allocation in governor
-    page->resetStatsForNewlyAddedPage();
-    page->setAnnotations(pkt->govInfo.getAnnotations());
-    if (pkt->govInfo.getAnnotations()->alloc_mode == COPY) {
-        assert(pkt->getOffset(pageSizeBytes) == 0);
-        page->performWrite(pkt);
-        incDynamicEnergy(pkt, page->getWriteEnergy()*(pageSizeBytes));
+    unsigned int first_page_index = pAddress2PageIndex(pkt->govInfo().getSPMAddress());
+    int num_pages = pkt->govInfo().getNumPages();
+
+    DPRINTF(SPM, "fillPageRun on SPM Pages = %d-%d\n",
+            first_page_index, first_page_index + num_pages - 1);
+
+    // for COPY allocations the data was already filled in by the transfer engine
+    Cycles page_write_latency = Cycles(0);
+    for (int page_index = 0; page_index < num_pages; page_index++) {
+        SPMPage* page = &spmSlots[first_page_index + page_index];
+//      page->setOwner(pkt->origin); // we do it before allocation in governor
+        page->resetStatsForNewlyAddedPage();
+        page->setAnnotations(pkt->govInfo().getRunPage(page_index).annotations);
+        if (pkt->govInfo().getAnnotations()->alloc_mode == COPY) {
+            incDynamicEnergy(pkt, page->getWriteEnergy()*(pageSizeBytes));
+        }
+        page_write_latency = std::max(page_write_latency,
+                                      page->getWriteSpeed() + fillLatency +
+                                      wakePage(first_page_index + page_index) +
+                                      accessBanks((first_page_index + page_index) *
+                                                  pageSizeBytes, pageSizeBytes));
     }
 
-    Cycles page_write_latency = page->getWriteSpeed() + fillLatency;
+    return page_write_latency;
+}
+
+void
+SPM::satisfyPageAllocation(PacketPtr pkt)
+{
+    Cycles page_write_latency = fillPageRun(pkt);
 
     // return a response to PMMU
-    pkt->govInfo.markComplete();
+    pkt->govInfo().markComplete();
     pmmuSlavePort->schedTimingResp(pkt, clockEdge(page_write_latency));
 }
 
@@ -641,21 +1271,31 @@ SPM::initializePageDeallocation (PacketPtr pkt)
     // conditionalBlocking(Blocked_MaxPendingReqs);
     assert (pendingReqs <= MAX_PENDING_REQS);
 
-    unsigned int spm_page_index = pAddress2PageIndex(pkt->govInfo.getSPMAddress());
+    unsigned int first_page_index = pAddress2PageIndex(pkt->govInfo().getSPMAddress());
+    int num_pages = pkt->govInfo().getNumPages();
+    bool write_back = pkt->govInfo().getAnnotations()->dealloc_mode == WRITE_BACK;
 
-    DPRINTF(SPM, "initializePageDeallocation on SPM Page = %d\n", spm_page_index);
+    DPRINTF(SPM, "initializePageDeallocation on SPM Pages = %d-%d\n",
+            first_page_index, first_page_index + num_pages - 1);
 
-    // read the page copy it to the pkt
-    SPMPage* page = &spmSlots[spm_page_index];
-    if (pkt->govInfo.getAnnotations()->dealloc_mode == WRITE_BACK) {
-        assert(pkt->getOffset(pageSizeBytes) == 0);
-        page->performRead(pkt);
+    Cycles page_read_latency = Cycles(0);
+    if (write_back) {
+        for (int page_index = 0; page_index < num_pages; page_index++) {
+            SPMPage* page = &spmSlots[first_page_index + page_index];
+            incDynamicEnergy(pkt, page->getReadEnergy()*(pageSizeBytes));
+            page_read_latency = std::max(page_read_latency,
+                                         page->getReadSpeed() + fillLatency +
+                                         wakePage(first_page_index + page_index) +
+                                         accessBanks((first_page_index + page_index) *
+                                                     pageSizeBytes, pageSizeBytes));
+        }
+
+        // read the pages and write them back to memory
+        transferEngine->startDeallocation(pkt, clockEdge(page_read_latency));
     }
-    page->invalidate(true);
-    if (pkt->govInfo.getAnnotations()->dealloc_mode == WRITE_BACK) {
-        incDynamicEnergy(pkt, page->getReadEnergy()*(pageSizeBytes));
-        Cycles page_read_latency = page->getReadSpeed() + fillLatency;
-        memSidePort->schedTimingReq(pkt, clockEdge(page_read_latency));
+
+    for (int page_index = 0; page_index < num_pages; page_index++) {
+        spmSlots[first_page_index + page_index].invalidate(true);
     }
 }
 
@@ -663,7 +1303,7 @@ void
 SPM::satisfyPageDeallocation (PacketPtr pkt)
 {
     // returning a response to PPMU
-    pkt->govInfo.markComplete();
+    pkt->govInfo().markComplete();
     pmmuSlavePort->schedTimingResp(pkt, curTick());
 }
 
@@ -689,6 +1329,29 @@ SPM::conditionalUnblocking(BlockedCause cause)
     pendingReqs--;
     if (pendingReqs <= MAX_PENDING_REQS && isBlocked())
         clearBlocked(cause);
+
+    checkDrain();
+}
+
+DrainState
+SPM::drain()
+{
+    if (outstandingCPUReqs == 0 && transferEngine->isIdle()) {
+        return DrainState::Drained;
+    }
+
+    DPRINTF(Drain, "%d cpu request(s) still in flight\n", outstandingCPUReqs);
+    return DrainState::Draining;
+}
+
+void
+SPM::checkDrain()
+{
+    if (drainState() == DrainState::Draining &&
+        outstandingCPUReqs == 0 && transferEngine->isIdle()) {
+        DPRINTF(Drain, "SPM drained\n");
+        signalDrainDone();
+    }
 }
 
 bool
@@ -756,11 +1419,17 @@ SPM::PMMUSideSlavePort::recvTimingReq(PacketPtr pkt)
     return true;
 }
 
+Tick
+SPM::PMMUSideSlavePort::recvAtomic(PacketPtr pkt)
+{
+    // this is called by a pmmu when SPM needs to fill a remote request or alloc/dealloc in atomic mode
+    return my_spm->recvPMMUAtomicReq(pkt);
+}
+
 void
 SPM::PMMUSideSlavePort::recvFunctional(PacketPtr pkt)
 {
-    //@TODO:  implement - see rubyport.cc version
-    panic("recvFunctional not implemented for PMMUSideSlavePort");
+    my_spm->recvPMMUFunctionalReq(pkt);
 }
 
 void
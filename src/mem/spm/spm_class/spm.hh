@@ -54,14 +54,20 @@
 
 #include "base/logging.hh" // fatal, panic, and warn
 #include "mem/spm/spm_class/base.hh"
+#include "mem/spm/spm_class/SPMArena.hh"
+#include "mem/spm/spm_class/SPMFaultInjector.hh"
+#include "mem/spm/spm_class/SPMFreePageIndex.hh"
 #include "mem/spm/spm_class/SPMPage.hh"
 #include "params/SPM.hh"
 #include "sim/eventq.hh"
+#include "sim/probe/probe.hh"
 
 #define MAX_PENDING_REQS 5
 
 //Forward decleration
+class Cache;
 class PMMU;
+class SPMTransferEngine;
 
 /**
  * A template-policy based spm. The behavior of the spm can be altered by
@@ -71,6 +77,7 @@ class PMMU;
 class SPM : public BaseSPM
 {
   friend class PMMU;
+  friend class SPMTransferEngine;
 
   protected:
 
@@ -190,8 +197,7 @@ class SPM : public BaseSPM
 
       protected:
 
-        Tick recvAtomic(PacketPtr pkt)
-        { panic("SPM::PMMUSideSlavePort::recvAtomic() not implemented!\n"); }
+        Tick recvAtomic(PacketPtr pkt);
 
         void recvFunctional(PacketPtr pkt);
 
@@ -303,21 +309,90 @@ class SPM : public BaseSPM
 
     PMMU *myPMMU;            //PMMU connected to this SPM
     SPMPage *spmSlots;
+    SPMArena *arena;         //Backing storage spmSlots point into
+    SPMFreePageIndex freePageIndex;  //Free slots of spmSlots, kept by the PMMU
     unsigned pageSizeBytes;  //Page size of this SPM
 
     double read_ber;
     double write_ber;
     std::string ber_energy_file;
+    SPMFaultInjector faultInjector;  //Bit flips of approximate accesses to spmSlots
+
+    /**
+     * Running totals an SPMTimeline samples every epoch. They are plain
+     * counters rather than stats, so resetting the stats doesn't break
+     * the time series.
+     */
+    struct TimelineCounters
+    {
+        uint64_t allocatedPages;    // slots handed out by the governor
+        uint64_t deallocatedPages;  // slots given back
+        uint64_t relocatedPages;    // pages moved in from another slot
+        uint64_t localBytes;        // cpu accesses served by this spm
+        uint64_t remoteBytes;       // cpu accesses served by another spm
+
+        TimelineCounters()
+          : allocatedPages(0)
+          , deallocatedPages(0)
+          , relocatedPages(0)
+          , localBytes(0)
+          , remoteBytes(0)
+        {}
+    };
+    TimelineCounters timelineCounters;
 
     void init();
     void regStats();
+    void regProbePoints() override;
+
+    /** Notified with every request coming from the cpu side. */
+    std::unique_ptr<ProbePointArg<PacketPtr>> ppAccess;
+
+    /**
+     * Only the used slots are saved, their data goes to a compressed
+     * file next to the checkpoint.
+     */
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+
+    /** Drained once no CPU request or page transfer is in flight. */
+    DrainState drain() override;
+    void checkDrain();
 
     bool recvPMMUTimingReq(PacketPtr pkt);
     void recvPMMUTimingResp(PacketPtr pkt);
+    Tick recvPMMUAtomicReq(PacketPtr pkt);
+    void recvPMMUFunctionalReq(PacketPtr pkt);
     void sendTimingRespToCPU(PacketPtr pkt, Cycles lat);
     bool satisfySPMAccess(PacketPtr pkt, Cycles *lat);
 
+    /**
+     * Takes a port of every bank the access touches, see num_banks, and
+     * returns the cycles it adds to the latency of the array: the wait
+     * for the ports, and the units a bank serves one after the other.
+     */
+    Cycles accessBanks(Addr spm_addr, unsigned access_size);
+
+    /**
+     * Power states and operating points of the slots. The leakage of the
+     * array, from the ber file, is split evenly between its slots and
+     * charged for the time each spends in a state: all of it when on,
+     * drowsyLeakageFactor of it when drowsy, none when off. Accessing a
+     * slot that isn't on first wakes it up, which takes wakeupLatency.
+     */
+    void setPagePowerState(unsigned page_index, SPMPagePowerState state);
+    void setPageOperatingPoint(unsigned page_index, int operating_point);
+    int getNominalOperatingPoint() const { return nominalOperatingPoint; }
+    int getLowLeakageOperatingPoint() const { return lowLeakageOperatingPoint; }
+
+    // leakage of all the slots up to now, e.g. before the stats are dumped
+    void chargeLeakage();
+    void resetLeakage();
+
+    void satisfyPageRelocation(PacketPtr pkt, Cycles *lat);
+
     void initializePageAllocation (PacketPtr pkt);
+    Cycles fillPageRun (PacketPtr pkt);
     void satisfyPageAllocation (PacketPtr pkt);
 
     void initializePageDeallocation (PacketPtr pkt);
@@ -332,13 +407,83 @@ class SPM : public BaseSPM
 
     bool acceptingMemReqs();
     int pendingReqs;
+    unsigned outstandingCPUReqs;  // cpu requests still waiting for a response
+
+    // moves allocated/deallocated page runs between memory and the spm
+    SPMTransferEngine *transferEngine;
 
     void writebackCacheCopies(Addr p_page_addr);
     unsigned getCacheBlkSize();
 
+    unsigned getNumSlots() const { return size / pageSizeBytes; }
+
+    /**
+     * A reconfigurable spm shares its array with the cache on its memory
+     * side: every way it takes from the cache gives it a way worth of
+     * slots, the others are left unused. Taking ways evicts the blocks
+     * in them, and is refused (false) until the cache can evict them
+     * all; the pages on the slots given back must have been moved off
+     * beforehand.
+     */
+    bool isReconfigurable() const { return reconfigurable; }
+    bool setSPMWays(unsigned num_ways);
+    // when the blocks evicted by the last resizes are out of the cache
+    Tick getResizeReadyTick() const { return resizeReadyTick; }
+    unsigned getSPMWays() const { return spmWays; }
+    unsigned getMaxSPMWays() const;
+    unsigned getPagesPerWay() const;
+
     unsigned int pAddress2PageIndex(Addr addr) const
     {
         return (addr / pageSizeBytes);
     }
+
+  private:
+    /**
+     * Banks of the array, interleaved every bankInterleaving bytes, with
+     * portsPerBank ports each. An access holds a port of every bank it
+     * touches for bankBusyCycles per interleaving unit; cpu accesses,
+     * remote accesses and page transfers all contend for the ports. No
+     * banks leave the bandwidth of the spm unlimited.
+     */
+    const unsigned numBanks;
+    const unsigned bankInterleaving;
+    const unsigned portsPerBank;
+    const Cycles bankBusyCycles;
+    std::vector<Tick> portBusyUntil;  // ports of bank 0 first, then bank 1...
+
+    const Cycles wakeupLatency;
+    const double drowsyLeakageFactor;
+    int nominalOperatingPoint;
+    int lowLeakageOperatingPoint;
+    std::vector<Tick> leakageChargedUntil;  // per slot
+    void chargeSlotLeakage(unsigned page_index);
+    // wakes the slot up if needed, returns the cycles it took
+    Cycles wakePage(unsigned page_index);
+
+    const bool hugePages;
+    // pages relocated within the spm and written back pages leave their
+    // slots rather than being copied, see SPMArena
+    const bool zeroCopyTransfers;
+
+    const bool reconfigurable;
+    Cache *reconfigCache;   // cache the spm carves its slots from
+    unsigned spmWays;
+    Tick resizeReadyTick;
+
+    Stats::Scalar spmResizes;
+    Stats::Vector bankAccesses;
+    Stats::Scalar bankConflicts;
+    Stats::Scalar bankQueueingCycles;
+    Stats::Formula avgBankQueueing;
+    Stats::Scalar staticEnergy;
+    Stats::Scalar pageWakeups;
+    Stats::Value freePages;
+    Stats::Value largestFreeRun;
+    Stats::Value fragmentation;
+    Stats::Scalar readBitFlips;
+    Stats::Scalar writeBitFlips;
+    Stats::Scalar faultyReads;
+    Stats::Scalar faultyWrites;
 };
 #endif // __MEM_SPM_SPM_HH__
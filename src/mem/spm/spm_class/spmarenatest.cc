@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <set>
+
+#include "mem/spm/spm_class/SPMArena.hh"
+
+namespace {
+
+const unsigned pageSize = 4096;
+
+} // anonymous namespace
+
+TEST(SPMArenaTest, PagesAreAlignedAndApart)
+{
+    SPMArena arena(8, 0, pageSize, false);
+
+    std::set<uint8_t *> pages;
+    for (unsigned i = 0; i < arena.getNumPages(); i++) {
+        uint8_t *page = arena.getPage(i);
+        EXPECT_EQ((Addr)page % pageSize, 0u);
+        EXPECT_TRUE(arena.contains(page));
+        pages.insert(page);
+
+        // every page is mapped and writable
+        memset(page, i, pageSize);
+    }
+    EXPECT_EQ(pages.size(), 8u);
+    EXPECT_EQ(arena.getPage(7), arena.getPage(0) + 7 * pageSize);
+}
+
+TEST(SPMArenaTest, NoSpares)
+{
+    SPMArena arena(8, 0, pageSize, false);
+
+    EXPECT_EQ(arena.getNumSpares(), 0u);
+    EXPECT_EQ(arena.takeSpare(), nullptr);
+}
+
+TEST(SPMArenaTest, SparesStayInTheArena)
+{
+    SPMArena arena(8, 4, pageSize, false);
+    EXPECT_EQ(arena.getNumSpares(), 4u);
+
+    std::set<uint8_t *> spares;
+    for (unsigned i = 0; i < 4; i++) {
+        uint8_t *spare = arena.takeSpare();
+        ASSERT_NE(spare, nullptr);
+        EXPECT_TRUE(arena.contains(spare));
+        EXPECT_EQ((Addr)spare % pageSize, 0u);
+        for (unsigned page_index = 0; page_index < 8; page_index++)
+            EXPECT_NE(spare, arena.getPage(page_index));
+        memset(spare, 0xff, pageSize);
+        spares.insert(spare);
+    }
+    EXPECT_EQ(spares.size(), 4u);
+    EXPECT_EQ(arena.getNumSpares(), 0u);
+    EXPECT_EQ(arena.takeSpare(), nullptr);
+
+    // a slot page handed back after a swap becomes a spare
+    arena.returnSpare(arena.getPage(3));
+    EXPECT_EQ(arena.getNumSpares(), 1u);
+    EXPECT_EQ(arena.takeSpare(), arena.getPage(3));
+}
+
+TEST(SPMArenaTest, ArenasDontOverlap)
+{
+    SPMArena arena(8, 2, pageSize, false);
+    SPMArena other(8, 2, pageSize, false);
+
+    for (unsigned i = 0; i < 8; i++) {
+        EXPECT_FALSE(arena.contains(other.getPage(i)));
+        EXPECT_FALSE(other.contains(arena.getPage(i)));
+    }
+    EXPECT_FALSE(arena.contains(other.takeSpare()));
+}
+
+TEST(SPMArenaTest, LargePages)
+{
+    // larger than a host page, the mapping is realigned
+    SPMArena arena(4, 1, 64 * 1024, false);
+
+    for (unsigned i = 0; i < 4; i++)
+        EXPECT_EQ((Addr)arena.getPage(i) % (64 * 1024), 0u);
+    uint8_t *spare = arena.takeSpare();
+    EXPECT_EQ((Addr)spare % (64 * 1024), 0u);
+    memset(spare, 0, 64 * 1024);
+}
@@ -23,6 +23,7 @@ class SPMRequestMsg :  public Message
         // m_Destination has no default
         // m_DataBlk has no default
         m_MessageSize = MessageSizeType_NUM; // default value of MessageSizeType
+        m_ExtraDataBytes = 0;
     }
     SPMRequestMsg(const SPMRequestMsg&other)
         : Message(other)
@@ -33,6 +34,7 @@ class SPMRequestMsg :  public Message
         m_Destination = other.m_Destination;
         m_DataBlk = other.m_DataBlk;
         m_MessageSize = other.m_MessageSize;
+        m_ExtraDataBytes = other.m_ExtraDataBytes;
         m_PktPtr = other.m_PktPtr;
     }
     SPMRequestMsg(const Tick curTime, const Addr& local_addr, const SPMRequestType& local_Type, const MachineID& local_Requestor, const NetDest& local_Destination, const SPMPage& local_DataBlk, const MessageSizeType& local_MessageSize, const PacketPtr local_PktPtr)
@@ -44,12 +46,13 @@ class SPMRequestMsg :  public Message
         m_Destination = local_Destination;
         m_DataBlk = local_DataBlk;
         m_MessageSize = local_MessageSize;
+        m_ExtraDataBytes = 0;
         m_PktPtr = local_PktPtr;
     }
     MsgPtr
     clone() const
     {
-         return std::shared_ptr<Message>(new SPMRequestMsg(*this));
+         return MsgPtr(new SPMRequestMsg(*this));
     }
     // Const accessors methods for each field
     /** \brief Const accessor method for addr field.
@@ -100,6 +103,14 @@ class SPMRequestMsg :  public Message
     {
         return m_MessageSize;
     }
+    /** \brief Const accessor method for ExtraDataBytes field.
+     *  \return ExtraDataBytes field
+     */
+    uint32_t
+    getExtraDataBytes() const
+    {
+        return m_ExtraDataBytes;
+    }
     // Non const Accessors methods for each field
     /** \brief Non-const accessor method for addr field.
      *  \return addr field
@@ -216,6 +227,8 @@ class SPMRequestMsg :  public Message
     SPMPage m_DataBlk;
     /** size category of the message */
     MessageSizeType m_MessageSize;
+    /** data carried on top of the size category, e.g. relocated pages */
+    uint32_t m_ExtraDataBytes;
     /** pointer to original request packet */
     PacketPtr m_PktPtr;
 
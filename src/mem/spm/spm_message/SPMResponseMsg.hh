@@ -52,7 +52,7 @@ class SPMResponseMsg :  public Message
     MsgPtr
     clone() const
     {
-         return std::shared_ptr<Message>(new SPMResponseMsg(*this));
+         return MsgPtr(new SPMResponseMsg(*this));
     }
     // Const accessors methods for each field
     /** \brief Const accessor method for addr field.
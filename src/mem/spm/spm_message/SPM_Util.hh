@@ -52,6 +52,10 @@
 inline bool
 testAndRead(Addr addr, SPMPage& blk, Packet *pkt)
 {
+    // the data of spm messages travels with their packet
+    if (!blk.hasData())
+        return false;
+
     Addr pktLineAddr = makeLineAddress(pkt->getAddr());
     Addr lineAddr = makeLineAddress(addr);
 
@@ -77,6 +81,10 @@ testAndRead(Addr addr, SPMPage& blk, Packet *pkt)
 inline bool
 testAndWrite(Addr addr, SPMPage& blk, Packet *pkt)
 {
+    // the data of spm messages travels with their packet
+    if (!blk.hasData())
+        return false;
+
     Addr pktLineAddr = makeLineAddress(pkt->getAddr());
     Addr lineAddr = makeLineAddress(addr);
 
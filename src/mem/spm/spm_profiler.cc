@@ -0,0 +1,144 @@
+#include "mem/spm/spm_profiler.hh"
+
+#include "base/callback.hh"
+#include "base/output.hh"
+#include "cpu/thread_context.hh"
+#include "mem/spm/pmmu.hh"
+#include "mem/spm/spm_class/spm.hh"
+#include "params/SPMProfiler.hh"
+#include "proto/spm_profile.pb.h"
+#include "sim/process.hh"
+#include "sim/system.hh"
+
+SPMProfiler::SPMProfiler(SPMProfilerParams *p)
+    : SimObject(p),
+      spms(p->spms),
+      epoch(p->epoch),
+      currentEpoch(0),
+      profileStream(nullptr)
+{
+    if (epoch == 0)
+        fatal("%s: the profiling epoch can't be zero\n", name());
+
+    std::string filename = simout.resolve(p->profile_file != "" ?
+                                          p->profile_file :
+                                          name() + ".prof.gz");
+    profileStream = new ProtoOutputStream(filename);
+
+    // Register a callback to compensate for the destructor not
+    // being called. The callback flushes the last epoch, then closes
+    // the output file.
+    registerExitCallback(
+        new MakeCallback<SPMProfiler, &SPMProfiler::closeStreams>(this));
+}
+
+void
+SPMProfiler::startup()
+{
+    ProtoMessage::SPMProfileHeader header_msg;
+    header_msg.set_obj_id(name());
+    header_msg.set_tick_freq(SimClock::Frequency);
+    header_msg.set_epoch(epoch);
+    header_msg.set_page_size(PMMU::getPageSizeBytes());
+
+    // capacities and distances are indexed by node id
+    std::vector<PMMU *> pmmu_by_node;
+    for (auto spm : spms) {
+        NodeID node = spm->myPMMU->getNodeID();
+        if (node >= pmmu_by_node.size())
+            pmmu_by_node.resize(node + 1, nullptr);
+        pmmu_by_node[node] = spm->myPMMU;
+    }
+
+    for (auto pmmu : pmmu_by_node) {
+        header_msg.add_spm_pages(pmmu ? pmmu->getSPMSizePages() : 0);
+    }
+    for (auto from : pmmu_by_node) {
+        for (NodeID to = 0; to < pmmu_by_node.size(); to++) {
+            header_msg.add_hop_distances(from && pmmu_by_node[to] ?
+                                         from->getHopDistance(to) : 0);
+        }
+    }
+
+    profileStream->write(header_msg);
+
+    currentEpoch = curTick() / epoch;
+}
+
+void
+SPMProfiler::regProbeListeners()
+{
+    listeners.resize(spms.size());
+    for (int i = 0; i < spms.size(); i++) {
+        listeners[i].reset(new AccessListener(*this, spms[i],
+                                              spms[i]->getProbeManager(),
+                                              "Access"));
+    }
+}
+
+void
+SPMProfiler::handleAccess(SPM *spm, PacketPtr pkt)
+{
+    if (!(pkt->isRead() || pkt->isWrite()) ||
+        !pkt->req->hasVaddr() || !pkt->req->hasContextId()) {
+        return;
+    }
+
+    // the spms may be served by several threads, whose clocks are only
+    // in step at the end of every simulation quantum
+    std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+    if (inParallelMode)
+        lock.lock();
+
+    if (curTick() / epoch > currentEpoch) {
+        flushEpoch();
+        currentEpoch = curTick() / epoch;
+    }
+
+    ThreadContext *tc = spm->system->getThreadContext(pkt->req->contextId());
+    PageKey key{spm->myPMMU->getNodeID(), tc->getProcessPtr()->tgid(),
+                PMMU::spmPageAlign(pkt->req->getVaddr())};
+
+    PageCounts &counts = pageCounts[key];
+    if (pkt->isWrite()) {
+        counts.writes++;
+    }
+    else {
+        counts.reads++;
+    }
+}
+
+void
+SPMProfiler::flushEpoch()
+{
+    for (auto &entry : pageCounts) {
+        ProtoMessage::SPMPageAccesses page_msg;
+        page_msg.set_epoch(currentEpoch);
+        page_msg.set_node(entry.first.node);
+        page_msg.set_asid(entry.first.asid);
+        page_msg.set_vpage(entry.first.vpage);
+        if (entry.second.reads)
+            page_msg.set_reads(entry.second.reads);
+        if (entry.second.writes)
+            page_msg.set_writes(entry.second.writes);
+
+        profileStream->write(page_msg);
+    }
+    pageCounts.clear();
+}
+
+void
+SPMProfiler::closeStreams()
+{
+    if (profileStream != NULL) {
+        flushEpoch();
+        delete profileStream;
+        profileStream = NULL;
+    }
+}
+
+SPMProfiler *
+SPMProfilerParams::create()
+{
+    return new SPMProfiler(this);
+}
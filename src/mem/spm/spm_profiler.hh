@@ -0,0 +1,102 @@
+/* The SPM profiler counts, epoch by epoch, the accesses every node makes
+ * to every virtual page, whether the page is on an spm or not, and writes
+ * them to a protobuf stream. util/spm_plan.py turns the profile into a
+ * placement plan that the Plan governor replays.
+ * */
+
+#ifndef __SPM_PROFILER_HH__
+#define __SPM_PROFILER_HH__
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "mem/packet.hh"
+#include "proto/protoio.hh"
+#include "sim/probe/probe.hh"
+#include "sim/sim_object.hh"
+
+struct SPMProfilerParams;
+class SPM;
+
+class SPMProfiler : public SimObject
+{
+  public:
+    SPMProfiler(SPMProfilerParams *params);
+
+    void startup() override;
+    void regProbeListeners() override;
+
+  protected:
+    void handleAccess(SPM *spm, PacketPtr pkt);
+
+    // writes the counts of the current epoch and starts a new one
+    void flushEpoch();
+
+    /**
+     * Callback to flush the last epoch and close the stream on exit.
+     */
+    void closeStreams();
+
+    class AccessListener : public ProbeListenerArgBase<PacketPtr>
+    {
+      public:
+        AccessListener(SPMProfiler &_parent, SPM *_spm,
+                       ProbeManager *pm, const std::string &name)
+            : ProbeListenerArgBase(pm, name),
+              parent(_parent), spm(_spm) {}
+
+        void notify(const PacketPtr &pkt) override {
+            parent.handleAccess(spm, pkt);
+        }
+
+      protected:
+        SPMProfiler &parent;
+        SPM *spm;
+    };
+
+    std::vector<SPM *> spms;
+    std::vector<std::unique_ptr<AccessListener>> listeners;
+
+    const Tick epoch;
+    uint64_t currentEpoch;
+
+    struct PageKey
+    {
+        NodeID node;
+        uint64_t asid;
+        Addr vpage;
+
+        bool operator==(const PageKey &other) const
+        {
+            return node == other.node && asid == other.asid &&
+                   vpage == other.vpage;
+        }
+    };
+
+    struct PageKeyHash
+    {
+        size_t operator()(const PageKey &key) const
+        {
+            return std::hash<Addr>()(key.vpage) ^
+                   (std::hash<uint64_t>()(key.asid) << 1) ^
+                   (size_t(key.node) << 7);
+        }
+    };
+
+    struct PageCounts
+    {
+        uint64_t reads;
+        uint64_t writes;
+    };
+
+    // accesses of the current epoch
+    std::unordered_map<PageKey, PageCounts, PageKeyHash> pageCounts;
+
+    ProtoOutputStream *profileStream;
+
+    std::mutex mutex;
+};
+
+#endif // __SPM_PROFILER_HH__
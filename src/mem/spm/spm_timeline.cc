@@ -0,0 +1,144 @@
+#include "mem/spm/spm_timeline.hh"
+
+#include <cassert>
+
+#include "base/callback.hh"
+#include "mem/spm/governor/GOVLock.hh"
+#include "mem/spm/pmmu.hh"
+#include "params/SPMTimeline.hh"
+
+static const char timelineMagic[8] = {'S', 'P', 'M', 'T', 'L', 'N', '1', '\0'};
+
+static const char *timelineFields[] = {
+    "tick", "node", "spm_pages", "used_pages", "largest_free_run",
+    "allocated_pages", "deallocated_pages", "relocated_pages",
+    "local_bytes", "remote_bytes"
+};
+static const uint64_t numTimelineFields =
+    sizeof(timelineFields) / sizeof(timelineFields[0]);
+
+SPMTimeline::SPMTimeline(SPMTimelineParams *p)
+    : SimObject(p),
+      spms(p->spms),
+      epoch(p->epoch),
+      binary(p->binary),
+      lastSampleTick(0),
+      sampleEvent([this]{ sample(); }, name()),
+      timelineStream(nullptr)
+{
+    if (epoch == 0)
+        fatal("%s: the timeline epoch can't be zero\n", name());
+
+    std::string filename = p->timeline_file != "" ? p->timeline_file :
+                           name() + (binary ? ".bin" : ".csv");
+    timelineStream = simout.create(filename, binary);
+
+    // Register a callback to compensate for the destructor not
+    // being called. The callback writes the last epoch, then closes
+    // the output file.
+    registerExitCallback(
+        new MakeCallback<SPMTimeline, &SPMTimeline::closeStream>(this));
+}
+
+void
+SPMTimeline::startup()
+{
+    writeHeader();
+
+    // the spms don't checkpoint their counters, restored runs start
+    // from wherever they are
+    lastCounters.clear();
+    for (auto spm : spms) {
+        lastCounters.push_back(spm->timelineCounters);
+    }
+    lastSampleTick = curTick();
+
+    schedule(sampleEvent, (curTick() / epoch + 1) * epoch);
+}
+
+void
+SPMTimeline::writeHeader()
+{
+    std::ostream &os = *timelineStream->stream();
+
+    if (binary) {
+        uint64_t tick_freq = SimClock::Frequency;
+        uint64_t epoch_ticks = epoch;
+        os.write(timelineMagic, sizeof(timelineMagic));
+        os.write((const char *)&tick_freq, sizeof(tick_freq));
+        os.write((const char *)&epoch_ticks, sizeof(epoch_ticks));
+        os.write((const char *)&numTimelineFields, sizeof(numTimelineFields));
+        return;
+    }
+
+    for (uint64_t i = 0; i < numTimelineFields; i++) {
+        os << (i ? "," : "") << timelineFields[i];
+    }
+    os << "\n";
+}
+
+void
+SPMTimeline::writeRow(const std::vector<uint64_t> &fields)
+{
+    assert(fields.size() == numTimelineFields);
+    std::ostream &os = *timelineStream->stream();
+
+    if (binary) {
+        os.write((const char *)fields.data(), fields.size() * sizeof(uint64_t));
+        return;
+    }
+
+    for (int i = 0; i < fields.size(); i++) {
+        os << (i ? "," : "") << fields[i];
+    }
+    os << "\n";
+}
+
+void
+SPMTimeline::sample()
+{
+    // the spms may be served by other threads, which are paused while
+    // their counters are read
+    GOVLock gov_lock;
+
+    for (int i = 0; i < spms.size(); i++) {
+        SPM *spm = spms[i];
+        const SPM::TimelineCounters &now = spm->timelineCounters;
+        const SPM::TimelineCounters &last = lastCounters[i];
+        const SPMFreePageIndex &free_pages = spm->freePageIndex;
+
+        writeRow({curTick(),
+                  spm->myPMMU->getNodeID(),
+                  free_pages.getNumPages(),
+                  free_pages.getNumPages() - free_pages.getNumFreePages(),
+                  free_pages.getLargestFreeRun(),
+                  now.allocatedPages - last.allocatedPages,
+                  now.deallocatedPages - last.deallocatedPages,
+                  now.relocatedPages - last.relocatedPages,
+                  now.localBytes - last.localBytes,
+                  now.remoteBytes - last.remoteBytes});
+
+        lastCounters[i] = now;
+    }
+    lastSampleTick = curTick();
+
+    if (!sampleEvent.scheduled())
+        schedule(sampleEvent, curTick() + epoch);
+}
+
+void
+SPMTimeline::closeStream()
+{
+    if (timelineStream != NULL) {
+        if (curTick() > lastSampleTick && !lastCounters.empty())
+            sample();
+        simout.close(timelineStream);
+        timelineStream = NULL;
+    }
+}
+
+SPMTimeline *
+SPMTimelineParams::create()
+{
+    return new SPMTimeline(this);
+}
@@ -0,0 +1,60 @@
+/* The SPM timeline samples every spm at the end of each epoch and writes
+ * one row per node: slots in use, largest free run, pages allocated,
+ * deallocated and relocated in, and the bytes of cpu accesses served
+ * locally and by remote spms during the epoch. The stats aren't touched,
+ * the rows are the differences of counters the spms keep anyway (see
+ * SPM::TimelineCounters), so leaving the timeline out of the configuration
+ * costs nothing.
+ *
+ * Rows go to a CSV file, or to a binary one made of a header (magic,
+ * tick frequency, epoch, number of fields) followed by the fields of every
+ * row, all of them uint64_t in host byte order.
+ * */
+
+#ifndef __SPM_TIMELINE_HH__
+#define __SPM_TIMELINE_HH__
+
+#include <vector>
+
+#include "base/output.hh"
+#include "mem/spm/spm_class/spm.hh"
+#include "sim/eventq.hh"
+#include "sim/sim_object.hh"
+
+struct SPMTimelineParams;
+
+class SPMTimeline : public SimObject
+{
+  public:
+    SPMTimeline(SPMTimelineParams *params);
+
+    void startup() override;
+
+  protected:
+    // writes a row per spm for the epoch ending now
+    void sample();
+
+    /**
+     * Callback to write the last, partial, epoch and close the file on
+     * exit.
+     */
+    void closeStream();
+
+    void writeHeader();
+    void writeRow(const std::vector<uint64_t> &fields);
+
+    std::vector<SPM *> spms;
+
+    const Tick epoch;
+    const bool binary;
+
+    // counters of every spm at the start of the epoch
+    std::vector<SPM::TimelineCounters> lastCounters;
+    Tick lastSampleTick;
+
+    EventFunctionWrapper sampleEvent;
+
+    OutputStream *timelineStream;
+};
+
+#endif // __SPM_TIMELINE_HH__
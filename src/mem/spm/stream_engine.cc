@@ -0,0 +1,415 @@
+#include "mem/spm/stream_engine.hh"
+
+#include <algorithm>
+
+#include "base/cprintf.hh"
+#include "cpu/thread_context.hh"
+#include "debug/SPMStream.hh"
+#include "mem/page_table.hh"
+#include "mem/spm/att.hh"
+#include "mem/spm/governor/GOVLock.hh"
+#include "mem/spm/governor/base.hh"
+#include "mem/spm/pmmu.hh"
+#include "sim/process.hh"
+#include "sim/system.hh"
+
+SPMStreamEngine::SPMStreamEngine(PMMU *_pmmu, unsigned int _max_streams)
+    : pmmu(_pmmu),
+      max_streams(_max_streams),
+      advanceEvent([this]{ advance(); }, _pmmu->name() + ".stream_engine")
+{
+}
+
+uint64_t
+SPMStreamEngine::setStream(ThreadContext *tc, Addr start, Addr end,
+                           uint64_t metadata)
+{
+    uint64_t asid = tc->getProcessPtr()->tgid();
+    Addr first_page = PMMU::spmPageAlignUP(start);
+    Addr end_page = PMMU::spmPageAlignDown(end);
+    unsigned int depth = (metadata >> 32) & 0x00000000FFFFFFFF;
+
+    if (depth == 0) {
+        for (auto it = streams.begin(); it != streams.end(); ++it) {
+            if (it->asid == asid &&
+                first_page >= it->start && first_page < it->end) {
+                // the data is back in memory when the call returns
+                releasePages(*it, tc, Addr(0), Addr(0), false);
+                DPRINTF(SPMStream, "Node %d: Ended stream [%#x - %#x)\n",
+                        pmmu->getNodeID(), it->start, it->end);
+                streams.erase(it);
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    if (end_page <= first_page || streams.size() >= max_streams) {
+        return 0;
+    }
+
+    for (auto &stream : streams) {
+        if (stream.asid == asid &&
+            first_page < stream.end && stream.start < end_page) {
+            return 0;
+        }
+    }
+
+    Stream stream;
+    stream.context_id = tc->contextId();
+    stream.asid = asid;
+    stream.start = first_page;
+    stream.end = end_page;
+    stream.depth = depth;
+    stream.alloc_mode = static_cast<AllocationModes>((metadata >> 12) & 0x000000000000000F);
+    stream.dealloc_mode = static_cast<DeallocationModes>((metadata >> 0) & 0x000000000000000F);
+    stream.head = first_page;
+    stream.fetched_end = first_page;
+    stream.last_page = first_page;
+    // the first pages are brought in before the core gets to them
+    stream.target = first_page;
+    stream.moved = true;
+    streams.push_back(stream);
+    streamsStarted++;
+
+    DPRINTF(SPMStream, "Node %d: Started stream [%#x - %#x), %d page(s) ahead\n",
+            pmmu->getNodeID(), first_page, end_page, depth);
+
+    scheduleAdvance();
+    return 1;
+}
+
+void
+SPMStreamEngine::observeStreams(uint64_t asid, Addr v_page_addr)
+{
+    for (auto &stream : streams) {
+        if (stream.asid != asid ||
+            v_page_addr < stream.start || v_page_addr >= stream.end) {
+            continue;
+        }
+
+        if (v_page_addr != stream.last_page) {
+            // the window follows the core when it steps to the next page
+            // or skips into the pages already on their way
+            bool sequential = v_page_addr == stream.last_page + PMMU::getPageSizeBytes();
+            bool ahead = v_page_addr > stream.head && v_page_addr < windowEnd(stream);
+            stream.last_page = v_page_addr;
+
+            if (sequential || ahead) {
+                stream.target = v_page_addr;
+                stream.moved = true;
+                scheduleAdvance();
+            }
+            else {
+                streamJumps++;
+            }
+        }
+        return;
+    }
+}
+
+void
+SPMStreamEngine::scheduleAdvance()
+{
+    // the window moves outside of the access that triggered it
+    if (!advanceEvent.scheduled() &&
+        pmmu->drainState() == DrainState::Running) {
+        pmmu->schedule(advanceEvent, pmmu->clockEdge(Cycles(1)));
+    }
+}
+
+void
+SPMStreamEngine::advance()
+{
+    bool retry = false;
+    for (auto it = streams.begin(); it != streams.end(); ) {
+        if (!it->moved) {
+            ++it;
+            continue;
+        }
+
+        ThreadContext *tc = getThreadContext(*it);
+        if (!tc) {
+            // the address space is gone, and its mappings with it
+            DPRINTF(SPMStream, "Node %d: Dropped stream [%#x - %#x)\n",
+                    pmmu->getNodeID(), it->start, it->end);
+            it = streams.erase(it);
+            continue;
+        }
+
+        if (!advanceStream(*it, tc)) {
+            retry = true;
+        }
+        ++it;
+    }
+
+    if (retry) {
+        scheduleAdvance();
+    }
+}
+
+bool
+SPMStreamEngine::advanceStream(Stream &stream, ThreadContext *tc)
+{
+    Addr target = stream.target;
+
+    if (target < stream.head) {
+        // pages behind were let go, they can't come back before their
+        // write-back is done
+        auto &tickets = stream.release_tickets;
+        tickets.erase(std::remove_if(tickets.begin(), tickets.end(),
+                                     [this](uint64_t ticket) {
+                                         return pmmu->isTicketComplete(ticket);
+                                     }),
+                      tickets.end());
+        if (!tickets.empty()) {
+            return false;
+        }
+    }
+
+    if (target < stream.head || target >= stream.fetched_end) {
+        stream.fetched_end = target;
+        streamRestarts++;
+    }
+    else if (target != stream.head) {
+        streamAdvances++;
+    }
+
+    stream.head = target;
+    stream.moved = false;
+
+    DPRINTF(SPMStream, "Node %d: Stream [%#x - %#x) moved to page %#x\n",
+            pmmu->getNodeID(), stream.start, stream.end, target);
+
+    releasePages(stream, tc, stream.head, windowEnd(stream), true);
+    fetchPages(stream, tc);
+    return true;
+}
+
+void
+SPMStreamEngine::fetchPages(Stream &stream, ThreadContext *tc)
+{
+    const Addr page_size = PMMU::getPageSizeBytes();
+    FuncPageTable *page_table = dynamic_cast<FuncPageTable*>(tc->getProcessPtr()->pTable);
+
+    auto fetch_run = [&](Addr run_start, Addr run_end) {
+        if (run_end <= run_start) {
+            return;
+        }
+
+        uint64_t metadata = ((uint64_t)stream.alloc_mode << 12) | SPM_ASYNC_REQUEST;
+        GOVRequest gov_request(tc, Allocation, run_start, run_end, metadata);
+        gov_request.setTicket(pmmu->openTicket());
+        GOVLock gov_lock;
+        pmmu->getGovernor()->allocate(&gov_request);
+
+        // the governor might not find room for all of them
+        for (Addr page = run_start; page < run_end; page += page_size) {
+            if (pmmu->my_att->getMapping(stream.asid, page)) {
+                stream.owned.insert(page);
+                streamFetchedPages++;
+            }
+        }
+    };
+
+    Addr window_end = windowEnd(stream);
+    Addr run_start = stream.fetched_end;
+    while (stream.fetched_end < window_end) {
+        Addr page = stream.fetched_end;
+
+        // pages the program hasn't touched yet are fetched on a later move
+        Addr p_page_addr;
+        if (!page_table->translate(page, p_page_addr)) {
+            break;
+        }
+
+        // pages on chip already are left to whoever put them there
+        if (pmmu->my_att->getMapping(stream.asid, page)) {
+            fetch_run(run_start, page);
+            run_start = page + page_size;
+        }
+        stream.fetched_end += page_size;
+    }
+    fetch_run(run_start, stream.fetched_end);
+}
+
+void
+SPMStreamEngine::releasePages(Stream &stream, ThreadContext *tc,
+                              Addr keep_start, Addr keep_end, bool async)
+{
+    const Addr page_size = PMMU::getPageSizeBytes();
+    Addr run_start = 0;
+    Addr run_end = 0;
+
+    auto release_run = [&]() {
+        if (run_end <= run_start) {
+            return;
+        }
+
+        uint64_t metadata = (uint64_t)stream.dealloc_mode;
+        if (async) {
+            metadata |= SPM_ASYNC_REQUEST;
+        }
+        GOVRequest gov_request(tc, Deallocation, run_start, run_end, metadata);
+        if (async) {
+            gov_request.setTicket(pmmu->openTicket());
+            stream.release_tickets.push_back(gov_request.getTicket());
+        }
+        GOVLock gov_lock;
+        pmmu->getGovernor()->deAllocate(&gov_request);
+    };
+
+    for (auto it = stream.owned.begin(); it != stream.owned.end(); ) {
+        Addr page = *it;
+        if (page >= keep_start && page < keep_end) {
+            ++it;
+            continue;
+        }
+        it = stream.owned.erase(it);
+
+        // the program might have freed it itself
+        if (!pmmu->my_att->getMapping(stream.asid, page)) {
+            continue;
+        }
+
+        if (page != run_end) {
+            release_run();
+            run_start = page;
+        }
+        run_end = page + page_size;
+        streamReleasedPages++;
+    }
+    release_run();
+}
+
+ThreadContext *
+SPMStreamEngine::getThreadContext(const Stream &stream) const
+{
+    ThreadContext *tc = pmmu->my_spm_ptr->system->getThreadContext(stream.context_id);
+    if (!tc || !tc->getProcessPtr() ||
+        tc->getProcessPtr()->tgid() != stream.asid) {
+        return nullptr;
+    }
+    return tc;
+}
+
+Addr
+SPMStreamEngine::windowEnd(const Stream &stream) const
+{
+    // the page the core is on, and depth pages ahead of it
+    return std::min(stream.head + (stream.depth + 1) * PMMU::getPageSizeBytes(),
+                    stream.end);
+}
+
+void
+SPMStreamEngine::drain()
+{
+    if (advanceEvent.scheduled()) {
+        pmmu->deschedule(advanceEvent);
+    }
+}
+
+void
+SPMStreamEngine::drainResume()
+{
+    for (auto &stream : streams) {
+        if (stream.moved) {
+            scheduleAdvance();
+            break;
+        }
+    }
+}
+
+void
+SPMStreamEngine::serialize(CheckpointOut &cp) const
+{
+    unsigned num_streams = streams.size();
+    SERIALIZE_SCALAR(num_streams);
+
+    for (unsigned i = 0; i < num_streams; i++) {
+        const Stream &stream = streams[i];
+        ScopedCheckpointSection sec(cp, csprintf("stream%d", i));
+        paramOut(cp, "context_id", stream.context_id);
+        paramOut(cp, "asid", stream.asid);
+        paramOut(cp, "start", stream.start);
+        paramOut(cp, "end", stream.end);
+        paramOut(cp, "depth", stream.depth);
+        paramOut(cp, "alloc_mode", (int)stream.alloc_mode);
+        paramOut(cp, "dealloc_mode", (int)stream.dealloc_mode);
+        paramOut(cp, "head", stream.head);
+        paramOut(cp, "fetched_end", stream.fetched_end);
+        paramOut(cp, "last_page", stream.last_page);
+        paramOut(cp, "target", stream.target);
+        paramOut(cp, "moved", stream.moved);
+        std::vector<Addr> owned(stream.owned.begin(), stream.owned.end());
+        arrayParamOut(cp, "owned", owned);
+        // write-backs are done by the time we checkpoint, so the tickets
+        // of the released pages are not needed anymore
+    }
+}
+
+void
+SPMStreamEngine::unserialize(CheckpointIn &cp)
+{
+    unsigned num_streams;
+    UNSERIALIZE_SCALAR(num_streams);
+
+    streams.clear();
+    for (unsigned i = 0; i < num_streams; i++) {
+        Stream stream;
+        int alloc_mode, dealloc_mode;
+        ScopedCheckpointSection sec(cp, csprintf("stream%d", i));
+        paramIn(cp, "context_id", stream.context_id);
+        paramIn(cp, "asid", stream.asid);
+        paramIn(cp, "start", stream.start);
+        paramIn(cp, "end", stream.end);
+        paramIn(cp, "depth", stream.depth);
+        paramIn(cp, "alloc_mode", alloc_mode);
+        paramIn(cp, "dealloc_mode", dealloc_mode);
+        stream.alloc_mode = static_cast<AllocationModes>(alloc_mode);
+        stream.dealloc_mode = static_cast<DeallocationModes>(dealloc_mode);
+        paramIn(cp, "head", stream.head);
+        paramIn(cp, "fetched_end", stream.fetched_end);
+        paramIn(cp, "last_page", stream.last_page);
+        paramIn(cp, "target", stream.target);
+        paramIn(cp, "moved", stream.moved);
+        std::vector<Addr> owned;
+        arrayParamIn(cp, "owned", owned);
+        stream.owned.insert(owned.begin(), owned.end());
+        streams.push_back(stream);
+    }
+}
+
+void
+SPMStreamEngine::regStats(const std::string &name)
+{
+    streamsStarted
+        .name(name + ".streams_started")
+        .desc("Number of streams registered with SPM_STREAM")
+        ;
+
+    streamAdvances
+        .name(name + ".stream_advances")
+        .desc("Number of times a stream window followed the core forward")
+        ;
+
+    streamRestarts
+        .name(name + ".stream_restarts")
+        .desc("Number of times a stream window was started over at a new page")
+        ;
+
+    streamJumps
+        .name(name + ".stream_jumps")
+        .desc("Number of non-sequential accesses to a stream")
+        ;
+
+    streamFetchedPages
+        .name(name + ".stream_fetched_pages")
+        .desc("Number of pages brought on chip ahead of a stream")
+        ;
+
+    streamReleasedPages
+        .name(name + ".stream_released_pages")
+        .desc("Number of pages freed behind a stream")
+        ;
+}
@@ -0,0 +1,98 @@
+/* The stream engine of a PMMU turns its spm into a streaming buffer for
+ * the ranges a program walks in order. A range registered with SPM_STREAM
+ * is watched page by page: when the core moves forward, the pages it left
+ * are freed with the dealloc mode of the stream and the next depth pages
+ * are brought in ahead of it. Both go through the governor as asynchronous
+ * requests, so the core never waits for them.
+ * */
+
+#ifndef __SPM_STREAM_ENGINE_HH__
+#define __SPM_STREAM_ENGINE_HH__
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/statistics.hh"
+#include "base/types.hh"
+#include "mem/spm/api/spm_types.h"
+#include "sim/eventq.hh"
+#include "sim/serialize.hh"
+
+class PMMU;
+class ThreadContext;
+
+class SPMStreamEngine : public Serializable
+{
+  public:
+    SPMStreamEngine(PMMU *_pmmu, unsigned int _max_streams);
+
+    // registers a stream of the caller, or ends the one covering start if
+    // the depth encoded in metadata is zero; returns non-zero on success
+    uint64_t setStream(ThreadContext *tc, Addr start, Addr end,
+                       uint64_t metadata);
+
+    // called for every access translated by the pmmu
+    void observe(uint64_t asid, Addr v_page_addr)
+    {
+        if (!streams.empty())
+            observeStreams(asid, v_page_addr);
+    }
+
+    // window moves still to do are kept across a drain
+    void drain();
+    void drainResume();
+
+    void serialize(CheckpointOut &cp) const override;
+    void unserialize(CheckpointIn &cp) override;
+
+    void regStats(const std::string &name);
+
+  private:
+    struct Stream
+    {
+        ContextID context_id;
+        uint64_t asid;
+        Addr start;             // first page of the range
+        Addr end;               // page past the range
+        unsigned int depth;     // pages kept ahead of the consumer
+        AllocationModes alloc_mode;
+        DeallocationModes dealloc_mode;
+        Addr head;              // page the consumer is on
+        Addr fetched_end;       // pages below were requested already
+        Addr last_page;         // last page the consumer touched
+        Addr target;            // page the window has to move to
+        bool moved;             // target not acted upon yet
+        std::set<Addr> owned;   // pages the stream put on chip
+        std::vector<uint64_t> release_tickets;
+    };
+
+    PMMU *pmmu;
+    const unsigned int max_streams;
+    std::vector<Stream> streams;
+
+    EventFunctionWrapper advanceEvent;
+
+    void observeStreams(uint64_t asid, Addr v_page_addr);
+    void scheduleAdvance();
+    void advance();
+
+    // slides the window of the stream to its target, false to retry later
+    bool advanceStream(Stream &stream, ThreadContext *tc);
+    void fetchPages(Stream &stream, ThreadContext *tc);
+    // frees the owned pages outside [keep_start, keep_end)
+    void releasePages(Stream &stream, ThreadContext *tc,
+                      Addr keep_start, Addr keep_end, bool async);
+
+    ThreadContext *getThreadContext(const Stream &stream) const;
+    Addr windowEnd(const Stream &stream) const;
+
+    Stats::Scalar streamsStarted;
+    Stats::Scalar streamAdvances;
+    Stats::Scalar streamRestarts;
+    Stats::Scalar streamJumps;
+    Stats::Scalar streamFetchedPages;
+    Stats::Scalar streamReleasedPages;
+};
+
+#endif // __SPM_STREAM_ENGINE_HH__
@@ -79,7 +79,9 @@
 #include "sim/stats.hh"
 #include "sim/system.hh"
 #include "sim/vptr.hh"
+#include "mem/spm/governor/GOVLock.hh"
 #include "mem/spm/governor/base.hh"
+#include "mem/spm/stream_engine.hh"
 
 using namespace std;
 
@@ -204,15 +206,17 @@ pseudoInst(ThreadContext *tc, uint8_t func, uint8_t subfunc)
 
       case M5OP_ANNOTATE:
       case M5OP_SPM_ALLOC:
-        spm_alloc(tc, args[0], args[1], args[2]);
-        break;
+        return spm_alloc(tc, args[0], args[1], args[2]);
       case M5OP_SPM_FREE:
-        spm_free(tc, args[0], args[1], args[2]);
-        break;
-      case M5OP_RESERVED4:
-      case M5OP_RESERVED5:
-        warn("Unimplemented m5 op (0x%x)\n", func);
-        break;
+        return spm_free(tc, args[0], args[1], args[2]);
+      case M5OP_SPM_TEST:
+        return spm_test(tc, args[0]);
+      case M5OP_SPM_STREAM:
+        return spm_stream(tc, args[0], args[1], args[2]);
+      case M5OP_SPM_TRANSFER:
+        return spm_transfer(tc, args[0], args[1], args[2]);
+      case M5OP_SPM_RESIZE:
+        return spm_resize(tc, args[0]);
 
       /* SE mode functions */
       case M5OP_SE_SYSCALL:
@@ -768,22 +772,83 @@ workend(ThreadContext *tc, uint64_t workid, uint64_t threadid)
     }
 }
 
-void
+uint64_t
 spm_alloc(ThreadContext *tc, uint64_t start, uint64_t end, uint64_t metadata)
 {
     DPRINTF(PseudoInst, "PseudoInst: spm_alloc in thread %d [start=%#x - end=%#x]\n", tc->contextId(), start, end);
 
     GOVRequest gov_request(tc, Allocation, start, end, metadata);
+    if (gov_request.isAsync())
+        gov_request.setTicket(gov_request.getPMMUPtr()->openTicket());
+
+    // the other nodes are paused while the governor decides
+    GOVLock gov_lock;
     gov_request.getPMMUPtr()->getGovernor()->allocate(&gov_request);
+    return gov_request.getTicket();
 }
 
-void
+uint64_t
 spm_free(ThreadContext *tc, uint64_t start, uint64_t end, uint64_t metadata)
 {
     DPRINTF(PseudoInst, "PseudoInst: spm_free in thread %d [start=%#x - end=%#x]\n", tc->contextId(), start, end);
 
     GOVRequest gov_request(tc, Deallocation, start, end, metadata);
+    if (gov_request.isAsync())
+        gov_request.setTicket(gov_request.getPMMUPtr()->openTicket());
+
+    GOVLock gov_lock;
     gov_request.getPMMUPtr()->getGovernor()->deAllocate(&gov_request);
+    return gov_request.getTicket();
+}
+
+uint64_t
+spm_test(ThreadContext *tc, uint64_t ticket)
+{
+    // tickets are private to the pmmu of the requesting core
+    bool complete = PMMU::getPMMU(tc)->isTicketComplete(ticket);
+
+    DPRINTF(PseudoInst, "PseudoInst: spm_test in thread %d [ticket=%d complete=%d]\n",
+            tc->contextId(), ticket, complete);
+    return complete;
+}
+
+uint64_t
+spm_stream(ThreadContext *tc, uint64_t start, uint64_t end, uint64_t metadata)
+{
+    DPRINTF(PseudoInst, "PseudoInst: spm_stream in thread %d [start=%#x - end=%#x]\n", tc->contextId(), start, end);
+
+    // streams are run by the pmmu of the requesting core
+    return PMMU::getPMMU(tc)->getStreamEngine()->setStream(tc, start, end, metadata);
+}
+
+uint64_t
+spm_transfer(ThreadContext *tc, uint64_t start, uint64_t end, uint64_t metadata)
+{
+    DPRINTF(PseudoInst, "PseudoInst: spm_transfer in thread %d [start=%#x - end=%#x]\n", tc->contextId(), start, end);
+
+    GOVRequest gov_request(tc, Relocation, start, end, metadata);
+    GOVLock gov_lock;
+    return gov_request.getPMMUPtr()->getGovernor()->transfer(&gov_request);
+}
+
+uint64_t
+spm_resize(ThreadContext *tc, uint64_t num_ways)
+{
+    DPRINTF(PseudoInst, "PseudoInst: spm_resize in thread %d [ways=%d]\n", tc->contextId(), num_ways);
+
+    PMMU *pmmu = PMMU::getPMMU(tc);
+    uint64_t num_pages;
+    {
+        GOVLock gov_lock;
+        num_pages = pmmu->getGovernor()->resize(pmmu, num_ways);
+    }
+
+    // the core waits for the blocks evicted from the cache ways
+    Tick ready_tick = pmmu->my_spm_ptr->getResizeReadyTick();
+    if (ready_tick > curTick())
+        tc->quiesceTick(ready_tick);
+
+    return num_pages;
 }
 
 } // namespace PseudoInst
@@ -90,8 +90,12 @@ void workbegin(ThreadContext *tc, uint64_t workid, uint64_t threadid);
 void workend(ThreadContext *tc, uint64_t workid, uint64_t threadid);
 void togglesync(ThreadContext *tc);
 
-void spm_alloc(ThreadContext *tc, uint64_t start, uint64_t end, uint64_t metadata); //SPM
-void spm_free(ThreadContext *tc, uint64_t start, uint64_t end, uint64_t metadata); //SPM
+uint64_t spm_alloc(ThreadContext *tc, uint64_t start, uint64_t end, uint64_t metadata); //SPM
+uint64_t spm_free(ThreadContext *tc, uint64_t start, uint64_t end, uint64_t metadata); //SPM
+uint64_t spm_test(ThreadContext *tc, uint64_t ticket); //SPM
+uint64_t spm_stream(ThreadContext *tc, uint64_t start, uint64_t end, uint64_t metadata); //SPM
+uint64_t spm_transfer(ThreadContext *tc, uint64_t start, uint64_t end, uint64_t metadata); //SPM
+uint64_t spm_resize(ThreadContext *tc, uint64_t num_ways); //SPM
 
 } // namespace PseudoInst
 
@@ -1253,18 +1253,27 @@ copyATT(ThreadContext *tc, ThreadContext *ctc)
     ATT *parent_att = parent_pmmu->my_att;
     ATT *child_att = child_pmmu->my_att;
 
-    child_att->invalidateATT();
-
-    for(std::map<Addr, ATTEntry* >::const_iterator it = (parent_att->translation_table).begin();
-        it != (parent_att->translation_table).end(); ++it) {
-        if ((it->second)->annotations->shared_data) {
-            child_att->addMapping(it->first,
-                                 (it->second)->destination_node,
-                                 (it->second)->spm_slot_addr,
-                                 (it->second)->annotations);
-            child_att->validateATTEntry(child_att->getMapping(it->first));
-
-        }
+    uint64_t parent_asid = tc->getProcessPtr()->tgid();
+    uint64_t child_asid = ctc->getProcessPtr()->tgid();
+
+    // other tenants of the child's PMMU keep their mappings
+    child_att->invalidateASID(child_asid);
+
+    // parent and child may share one ATT, so don't insert while walking it
+    std::vector<ATTEntry> shared_mappings;
+    parent_att->forEachMapping([&](const ATTEntry &entry) {
+        if (entry.asid == parent_asid && entry.annotations->shared_data)
+            shared_mappings.push_back(entry);
+    });
+
+    for (const ATTEntry &entry : shared_mappings) {
+        child_att->addMapping(child_asid,
+                              entry.v_page_addr,
+                              entry.destination_node,
+                              entry.spm_slot_addr,
+                              entry.annotations);
+        child_att->validateATTEntry(child_att->getMapping(child_asid,
+                                                          entry.v_page_addr));
     }
 
     DPRINTF(SyscallVerbose, "cloneFunc - copyATT\n");
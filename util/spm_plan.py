@@ -0,0 +1,233 @@
+#!/usr/bin/env python2
+
+# This script turns the per-page access profile written by the
+# SPMProfiler into a placement plan for the Plan governor.
+#
+# For every epoch of the profile, the pages are placed on the spms so
+# that the latency they save is the highest possible under the capacity
+# of every spm. A page of node u on the spm of node h saves, per access,
+# the memory latency minus the spm latency and the network latency of
+# the hops between u and h. Bringing a page to a spm it wasn't on in the
+# previous epoch costs a page transfer. This is a maximum weight
+# b-matching of pages to spms, solved exactly with successive shortest
+# paths on the graph condensed to the spms.
+#
+# Pages of an address space accessed by more than one node are left off
+# chip, as the spms don't keep copies coherent. The estimated cycles
+# saved by the plan are an upper bound on the benefit of the spms for
+# the profiled run.
+
+import heapq
+import optparse
+import os
+import protolib
+import subprocess
+import sys
+
+util_dir = os.path.dirname(os.path.realpath(__file__))
+
+def page_weights(accesses, user, hosts, hop_distances, num_nodes,
+                 prev_host, options):
+    """Cycles saved by the page on each spm in an epoch"""
+    weights = []
+    for host in hosts:
+        hops = hop_distances[user * num_nodes + host]
+        saved = options.mem_latency - options.spm_latency - \
+                options.hop_latency * hops
+        weight = accesses * saved
+        if prev_host != host:
+            weight -= options.transfer_cost
+        weights.append(weight)
+    return weights
+
+def place_epoch(weights, capacities):
+    """
+    Assigns pages to hosts, at most capacities[h] pages on host h, so
+    that the sum of the weights of the assigned pages is maximal.
+    weights[p][h] is the weight of page p on host h. Returns the host
+    index of every page, or None for pages left off chip.
+    """
+    num_hosts = len(capacities)
+    free = list(capacities)
+    host_of = [None] * len(weights)
+
+    # best unassigned page to bring onto each host
+    entry = [[] for h in range(num_hosts)]
+    for p, w in enumerate(weights):
+        for h in range(num_hosts):
+            if w[h] > 0 and capacities[h] > 0:
+                entry[h].append((-w[h], p))
+    for h in range(num_hosts):
+        heapq.heapify(entry[h])
+
+    # cheapest page to move from one host to another
+    move = [[[] for h2 in range(num_hosts)] for h in range(num_hosts)]
+
+    def assign(p, h):
+        host_of[p] = h
+        w = weights[p]
+        for h2 in range(num_hosts):
+            if h2 != h and capacities[h2] > 0:
+                heapq.heappush(move[h][h2], (w[h] - w[h2], p))
+
+    def top_entry(h):
+        heap = entry[h]
+        while heap and host_of[heap[0][1]] is not None:
+            heapq.heappop(heap)
+        return heap[0] if heap else None
+
+    def top_move(h, h2):
+        heap = move[h][h2]
+        while heap and host_of[heap[0][1]] != h:
+            heapq.heappop(heap)
+        return heap[0] if heap else None
+
+    while True:
+        # Bellman-Ford from the source over the hosts; a path enters a
+        # new page on one host and pushes pages along to a host with a
+        # free slot
+        dist = [None] * num_hosts
+        pred = [None] * num_hosts
+        for h in range(num_hosts):
+            top = top_entry(h)
+            if top:
+                dist[h] = top[0]
+                pred[h] = (None, top[1])
+
+        for i in range(num_hosts):
+            changed = False
+            for h in range(num_hosts):
+                if dist[h] is None:
+                    continue
+                for h2 in range(num_hosts):
+                    if h2 == h:
+                        continue
+                    top = top_move(h, h2)
+                    if top and (dist[h2] is None or
+                                dist[h] + top[0] < dist[h2]):
+                        dist[h2] = dist[h] + top[0]
+                        pred[h2] = (h, top[1])
+                        changed = True
+            if not changed:
+                break
+
+        sink = None
+        for h in range(num_hosts):
+            if free[h] > 0 and dist[h] is not None and dist[h] < 0 and \
+               (sink is None or dist[h] < dist[sink]):
+                sink = h
+        if sink is None:
+            break
+
+        # walk the path back, moving every page one host forward
+        free[sink] -= 1
+        h = sink
+        visited = set()
+        while True:
+            assert h not in visited
+            visited.add(h)
+            prev, p = pred[h]
+            assign(p, h)
+            if prev is None:
+                break
+            h = prev
+
+    return host_of
+
+def write_epoch(plan_out, start_tick, placement):
+    plan_out.write('epoch %d\n' % start_tick)
+    for (node, asid, vpage), host in sorted(placement.items()):
+        plan_out.write('%d %d %#x %d\n' % (node, asid, vpage, host))
+
+def main():
+    parser = optparse.OptionParser(
+        usage="%prog [options] <profile> <plan>")
+    parser.add_option("--mem-latency", type="float", default=100.0,
+                      help="cycles of an access to memory")
+    parser.add_option("--spm-latency", type="float", default=2.0,
+                      help="cycles of an access to the local spm")
+    parser.add_option("--hop-latency", type="float", default=2.0,
+                      help="cycles of every network hop to a remote spm")
+    parser.add_option("--transfer-cost", type="float", default=500.0,
+                      help="cycles of bringing a page to a spm")
+    (options, args) = parser.parse_args()
+
+    if len(args) != 2:
+        parser.print_help()
+        exit(-1)
+
+    # Make sure the proto definitions are up to date.
+    subprocess.check_call(['make', '--quiet', '-C', util_dir,
+                           'spm_profile_pb2.py'])
+    import spm_profile_pb2
+
+    proto_in = protolib.openFileRd(args[0])
+
+    try:
+        plan_out = open(args[1], 'w')
+    except IOError:
+        print("Failed to open %s for writing" % args[1])
+        exit(-1)
+
+    # Read the magic number in 4-byte Little Endian
+    magic_number = proto_in.read(4)
+
+    if magic_number != "gem5":
+        print("Unrecognized file %s" % args[0])
+        exit(-1)
+
+    header = spm_profile_pb2.SPMProfileHeader()
+    protolib.decodeMessage(proto_in, header)
+
+    num_nodes = len(header.spm_pages)
+    hosts = [h for h in range(num_nodes) if header.spm_pages[h] > 0]
+    capacities = [header.spm_pages[h] for h in hosts]
+    hop_distances = list(header.hop_distances)
+
+    print("Profile of %s, %d spm(s), epochs of %d ticks" %
+          (header.obj_id, len(hosts), header.epoch))
+
+    # Group the records by epoch, the profiler writes them in order
+    epochs = []
+    users = {}
+    record = spm_profile_pb2.SPMPageAccesses()
+    while protolib.decodeMessage(proto_in, record):
+        if not epochs or epochs[-1][0] != record.epoch:
+            epochs.append((record.epoch, {}))
+        key = (record.node, record.asid, record.vpage)
+        epochs[-1][1][key] = record.reads + record.writes
+        users.setdefault((record.asid, record.vpage), set()).add(record.node)
+
+    shared = set(page for page, nodes in users.items() if len(nodes) > 1)
+    print("Parsed %d epoch(s), %d page(s) left off chip as shared" %
+          (len(epochs), len(shared)))
+
+    prev_placement = {}
+    total_saved = 0
+    for epoch, accesses in epochs:
+        keys = [key for key in accesses if key[1:] not in shared]
+
+        weights = []
+        for key in keys:
+            weights.append(page_weights(accesses[key], key[0], hosts,
+                                        hop_distances, num_nodes,
+                                        prev_placement.get(key), options))
+
+        host_of = place_epoch(weights, capacities)
+
+        placement = {}
+        for p, key in enumerate(keys):
+            if host_of[p] is not None:
+                placement[key] = hosts[host_of[p]]
+                total_saved += weights[p][host_of[p]]
+
+        write_epoch(plan_out, epoch * header.epoch, placement)
+        prev_placement = placement
+
+    print("Estimated cycles saved: %d" % total_saved)
+
+    plan_out.close()
+    proto_in.close()
+
+if __name__ == "__main__":
+    main()